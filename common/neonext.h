@@ -58,6 +58,18 @@ struct Ne_MethodTable {
     void (*exec_callback)(const struct Ne_Cell *callback, const struct Ne_ParameterList *params, struct Ne_Cell *retval);
     // TODO: Remove "code" and make "info" an Object when neonext gets object capability.
     int (*raise_exception)(struct Ne_Cell *retval, const char *name, const char *info, int code);
+
+    // The following entries were added after the original table, so an
+    // extension built against an older header still sees the same layout.
+
+    // Borrowed access: the returned pointers refer directly to the storage
+    // held by the cell and remain valid until the cell is next modified.
+    int (*cell_get_string_size)(const struct Ne_Cell *cell);
+    char *(*cell_resize_string)(struct Ne_Cell *cell, int size);
+    unsigned char *(*cell_resize_bytes)(struct Ne_Cell *cell, int size);
+    // Return the key at position n (in key order) and store its value in *value,
+    // or return NULL if n is out of range.
+    const char *(*cell_get_dictionary_entry)(const struct Ne_Cell *cell, int n, const struct Ne_Cell **value);
 };
 
 struct Ne_Bytes {
@@ -84,6 +96,7 @@ typedef int (*Ne_ExtensionFunction)(struct Ne_Cell *retval, struct Ne_ParameterL
 #define Ne_PARAM_UINT(i) Ne->cell_get_number_uint(Ne_IN_PARAM(i))
 #define Ne_PARAM_STRING(i) Ne->cell_get_string(Ne_IN_PARAM(i))
 #define Ne_PARAM_BYTES(i) { Ne->cell_get_bytes(Ne->parameterlist_get_cell(in_params, (i))), Ne->cell_get_bytes_size(Ne->parameterlist_get_cell(in_params, (i))) }
+#define Ne_PARAM_STRING_SIZE(i) Ne->cell_get_string_size(Ne_IN_PARAM(i))
 #define Ne_PARAM_POINTER(type, i) (type *)(Ne->cell_get_pointer(Ne_IN_PARAM(i)))
 
 #define Ne_RETURN_BOOL(r) do { Ne->cell_set_boolean(retval, (r)); return Ne_SUCCESS; } while (0)
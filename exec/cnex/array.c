@@ -7,6 +7,7 @@
 #include <stdlib.h>
 
 #include "cell.h"
+#include "slab.h"
 #include "util.h"
 
 // ToDo: make dictionary and array pre-malloc sizes adjustable with a command line parameter.
@@ -15,33 +16,24 @@ static const size_t ARRAY_INITIAL_SIZE = 8;  // Reasonable starting value.  Will
 
 Array *array_createArray(void)
 {
-    Array *a = malloc(sizeof(Array));
-    if (a == NULL) {
-        fatal_error("Unable to allocate array.");
-    }
+    Array *a = slab_alloc(sizeof(Array));
 
     a->data = NULL;
     a->size = 0;
     a->max = ARRAY_INITIAL_SIZE;
-    a->data = malloc(a->max * sizeof(Cell));
+    a->data = slab_alloc(a->max * sizeof(Cell));
     a->refcount = 1;
     return a;
 }
 
 Array *array_createArrayFromSize(size_t iElements)
 {
-    Array *a = malloc(sizeof(Array));
-    if (a == NULL) {
-        fatal_error("Unable to allocate array for size.");
-    }
+    Array *a = slab_alloc(sizeof(Array));
 
     a->data = NULL;
     a->size = iElements;
     a->max = (a->size > 0 ? a->size : ARRAY_INITIAL_SIZE);
-    a->data = malloc(a->max * sizeof(Cell));
-    if (a->data == NULL) {
-        fatal_error("Unable to allocate memory for an array of %zu elements.", a->max);
-    }
+    a->data = slab_alloc(a->max * sizeof(Cell));
     a->refcount = 1;
 
     for (size_t i = 0; i < a->size; i++) {
@@ -64,23 +56,18 @@ Array *array_resizeArray(Array *self, size_t newSize)
     }
     // If we're expanding the array, but we don't have any preallocated space left, we need to make some.
     if (newSize > 0 && newSize > self->max) {
+        size_t old_max = self->max;
         self->max *= 2;
         // Just in case max*2 still isn't enough space, we'll cut our losses here and just allocate what we need.
         if (self->max < newSize) {
             self->max = newSize;
         }
-        self->data = realloc(self->data, sizeof(Cell) * self->max);
-        if (self->data == NULL) {
-            fatal_error("Unable resize array from %zu to %zu elements.", self->size, self->max);
-        }
+        self->data = slab_realloc(self->data, sizeof(Cell) * old_max, sizeof(Cell) * self->max);
     } else if (newSize == 0) {
         // If the new size ends up being zero, we'll basically reset the array to an initial starting point.
+        self->data = slab_realloc(self->data, sizeof(Cell) * self->max, sizeof(Cell) * ARRAY_INITIAL_SIZE);
         self->size = 0;
         self->max = ARRAY_INITIAL_SIZE;
-        self->data = realloc(self->data, sizeof(Cell) * self->max);
-        if (self->data == NULL) {
-            fatal_error("Unable resize array.");
-        }
     } // Else we have enough elements to fit the new array data in, so no realloc is necessary, at this time.
 
     // Initialize any new elements we may have added, but skip any that may have been there before.
@@ -101,9 +88,9 @@ void array_freeArray(Array *self)
                 for (size_t i = 0; i < self->size; i++) {
                     cell_clearCell(&self->data[i]);
                 }
-                free(self->data);
+                slab_free(self->data, self->max * sizeof(Cell));
             }
-            free(self);
+            slab_free(self, sizeof(Array));
         }
     }
 }
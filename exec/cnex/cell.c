@@ -11,6 +11,7 @@
 #include "dictionary.h"
 #include "nstring.h"
 #include "object.h"
+#include "slab.h"
 #include "util.h"
 
 void cell_ensureAddress(Cell *a)
@@ -491,21 +492,22 @@ TString *cell_toString(Cell *c)
             break;
         case cDictionary:
         {
-            size_t x;
+            int64_t x;
             r = string_appendCString(r, "{");
-            Cell *keys = dictionary_getKeys(c->dictionary);
-            for (x = 0; x < keys->array->size; x++) {
+            for (x = 0; x < c->dictionary->len; x++) {
                 if (r->length > 1) {
                     r = string_appendCString(r, ", ");
                 }
-                TString *quotedData = cell_toString(dictionary_findDictionaryEntry(c->dictionary, keys->array->data[x].string));
-                r = string_appendString(r, string_quoteInPlace(keys->array->data[x].string));
+                DictionaryEntry *e = dictionary_getSortedEntry(c->dictionary, x);
+                TString *quotedKey = string_copyString(e->key);
+                TString *quotedData = cell_toString(e->value);
+                r = string_appendString(r, string_quoteInPlace(quotedKey));
                 r = string_appendCString(r, ": ");
                 r = string_appendString(r, string_quoteInPlace(quotedData));
+                string_freeString(quotedKey);
                 string_freeString(quotedData);
             }
             r = string_appendCString(r, "}");
-            cell_freeCell(keys);
             break;
         }
         case cNumber:
@@ -583,7 +585,7 @@ Cell *cell_dictionaryIndexForWrite(Cell *c, TString *key)
 
     int64_t index = 0;
     if (!dictionary_findIndex(c->dictionary, key, &index)) {
-        dictionary_addDictionaryEntry(c->dictionary, key, cell_newCell(), index);
+        index = dictionary_addDictionaryEntry(c->dictionary, key, cell_newCell());
     } else {
         string_freeString(key); // Since we aren't using the provided key, we need to destroy it.
     }
@@ -693,10 +695,7 @@ int32_t cell_compareCell(const Cell * s, const Cell * d)
 
 Cell *cell_newCell(void)
 {
-    Cell *c = malloc(sizeof(Cell));
-    if (c == NULL) {
-        fatal_error("Could not allocate new cell object.");
-    }
+    Cell *c = slab_alloc(sizeof(Cell));
 
     c->number = number_from_uint32(0);
     c->object = NULL;
@@ -752,7 +751,12 @@ void cell_clearCell(Cell *c)
 void cell_freeCell(Cell *c)
 {
     cell_clearCell(c);
-    free(c);
+    slab_free(c, sizeof(Cell));
+}
+
+void cell_releaseCell(Cell *c)
+{
+    slab_free(c, sizeof(Cell));
 }
 
 Cell *cell_makeChoice_none(int choice)
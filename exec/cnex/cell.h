@@ -52,6 +52,8 @@ void cell_ensureString(Cell *s);
 
 void cell_clearCell(Cell *c);
 void cell_freeCell(Cell *c);
+// Release a cell whose contents have been moved elsewhere, without clearing them.
+void cell_releaseCell(Cell *c);
 void cell_initCell(Cell *c);
 
 Cell *cell_fromAddress(Cell *c);
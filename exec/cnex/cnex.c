@@ -38,6 +38,7 @@
 #include "number.h"
 #include "object.h"
 #include "opcode.h"
+#include "slab.h"
 #include "rtl_platform.h"
 #include "stack.h"
 #include "support.h"
@@ -230,6 +231,9 @@ int main(int argc, char* argv[])
                         "Total Linear Elements  : %zu\n"
                         "Predef cache hits      : %zu\n"
                         "Predef cache size      : %zu bytes\n"
+                        "Slab allocations       : %zu\n"
+                        "Slabs allocated        : %zu\n"
+                        "Mallocs avoided        : %zu\n"
                         "Execution Time         : %fms\n",
                         g_executor->diagnostics.total_opcodes,
                         g_executor->stack->max + 1,
@@ -245,6 +249,9 @@ int main(int argc, char* argv[])
                         g_executor->diagnostics.total_linear_elements,
                         g_executor->diagnostics.predef_cache_hits,
                         g_executor->diagnostics.predef_cache_size,
+                        slab_getStatistics()->allocations,
+                        slab_getStatistics()->slabs,
+                        slab_mallocsAvoided(),
                         ((((float)g_executor->diagnostics.time_end - g_executor->diagnostics.time_start) / CLOCKS_PER_SEC) * 1000)
         );
     }
@@ -256,6 +263,7 @@ shutdown:
     path_freePaths();
     ext_cleanup();
     number_cleanup();
+    slab_cleanup();
 
     free(gOptions.pszExecutablePath);
 #ifdef __MS_HEAP_DBG
@@ -390,6 +398,14 @@ TExecutor *exec_newExecutor(TModule *object)
         }
     }
 
+    // Numeric literal pool for all modules
+    for (unsigned int m = 0; m < r->module_count; m++) {
+        r->modules[m]->number_constants = calloc(r->modules[m]->bytecode->strtablelen, sizeof(Cell));
+        if (r->modules[m]->number_constants == NULL) {
+            fatal_error("Could not allocate numeric literal pool for module %s.", r->modules[m]->name);
+        }
+    }
+
     /* Debug / Diagnostic fields */
     r->diagnostics.total_opcodes = 0;
     r->diagnostics.callstack_max_height = 0;
@@ -657,7 +673,12 @@ void exec_PUSHN(TExecutor *self)
 {
     self->ip++;
     unsigned int val = exec_getOperand(self);
-    push(self->stack, cell_fromNumber(number_from_string(self->module->bytecode->strings[val]->data)));
+    Cell *c = &self->module->number_constants[val];
+    if (c->type == cNothing) {
+        c->number = number_from_string(self->module->bytecode->strings[val]->data);
+        c->type = cNumber;
+    }
+    push(self->stack, cell_fromNumber(c->number));
 }
 
 void exec_PUSHS(TExecutor *self)
@@ -1527,9 +1548,10 @@ void exec_DUPX1(TExecutor *self)
     self->ip++;
     Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
     Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
+    Cell *c = cell_fromCell(a);
     push(self->stack, a);
     push(self->stack, b);
-    push(self->stack, cell_fromCell(a));
+    push(self->stack, c);
 }
 
 void exec_DROP(TExecutor *self)
@@ -1569,7 +1591,7 @@ void exec_CONSD(TExecutor *self)
     while (val > 0) {
         Cell *value = cell_fromCell(top(self->stack)); pop(self->stack);
         TString *key = string_fromString(top(self->stack)->string); pop(self->stack);
-        dictionary_addDictionaryEntry(d->dictionary, key, value, -1);
+        dictionary_addDictionaryEntry(d->dictionary, key, value);
         val--;
     }
     push(self->stack, d);
@@ -1699,7 +1721,7 @@ void exec_SWAP(TExecutor *self)
 {
     self->ip++;
     int top = self->stack->top;
-    Cell *t = self->stack->data[top];
+    Cell t = self->stack->data[top];
     self->stack->data[top] = self->stack->data[top-1];
     self->stack->data[top-1] = t;
 }
@@ -2035,7 +2057,8 @@ cJSON *cell_writer(Cell *c)
             cJSON_AddStringToObject(writer, "type", "dictionary");
             cJSON *dict = cJSON_CreateObject();
             for (int i = 0; i < c->dictionary->len; i++) {
-                cJSON_AddItemToObject(dict, string_ensureNullTerminated(c->dictionary->data[i].key), cell_writer(c->dictionary->data[i].value));
+                DictionaryEntry *e = dictionary_getSortedEntry(c->dictionary, i);
+                cJSON_AddItemToObject(dict, string_ensureNullTerminated(e->key), cell_writer(e->value));
             }
             cJSON_AddItemToObject(writer, "value", dict);
             break;
@@ -2132,7 +2155,7 @@ void exec_handleGET(TExecutor *exec, TString *path, HttpResponse *response)
         response->code = 200;
         writer = cJSON_CreateArray();
         for (int i = exec->stack->top; i != -1; i--) {
-            cJSON_AddItemToArray(writer, cell_writer(exec->stack->data[i]));
+            cJSON_AddItemToArray(writer, cell_writer(&exec->stack->data[i]));
         }
     } else if (string_compareCString(path, "/status") == 0) {
         response->code = 200;
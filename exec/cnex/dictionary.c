@@ -10,28 +10,63 @@
 #include "array.h"
 #include "cell.h"
 #include "nstring.h"
+#include "slab.h"
 #include "util.h"
 
+static const int64_t DICTIONARY_INITIAL_SIZE = 8;
 
-BOOL dictionary_findIndex(Dictionary *self, TString *key, int64_t *index)
+static uint64_t hash_string(TString *s)
+{
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < s->length; i++) {
+        h ^= (uint8_t)s->data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Return the slot that refers to the entry with the given key, or the empty slot where it would go.
+static int64_t find_slot(Dictionary *self, TString *key, uint64_t hash)
 {
-    int64_t lo = 0;
-    int64_t hi = self->len;
-    while (lo < hi) {
-        int64_t mid = (lo + hi) / 2;
-        int c = string_compareString(key, self->data[mid].key);
-        if (c == 0) {
-            *index = mid;
-            return TRUE;
+    int64_t mask = self->nslots - 1;
+    int64_t i = (int64_t)(hash & (uint64_t)mask);
+    while (self->slots[i] != 0) {
+        DictionaryEntry *e = &self->data[self->slots[i] - 1];
+        if (e->hash == hash && string_compareString(key, e->key) == 0) {
+            break;
         }
-        if (c < 0) {
-            hi = mid;
-        } else {
-            lo = mid + 1;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static void rebuild_slots(Dictionary *self, int64_t nslots)
+{
+    free(self->slots);
+    self->nslots = nslots;
+    self->slots = calloc(self->nslots, sizeof(int64_t));
+    if (self->slots == NULL) {
+        fatal_error("Could not allocate hash table for dictionary.  Size: %zd", self->nslots * sizeof(int64_t));
+    }
+    int64_t mask = self->nslots - 1;
+    for (int64_t n = 0; n < self->len; n++) {
+        int64_t i = (int64_t)(self->data[n].hash & (uint64_t)mask);
+        while (self->slots[i] != 0) {
+            i = (i + 1) & mask;
         }
+        self->slots[i] = n + 1;
     }
-    *index = lo;
-    return FALSE;
+}
+
+BOOL dictionary_findIndex(Dictionary *self, TString *key, int64_t *index)
+{
+    int64_t i = find_slot(self, key, hash_string(key));
+    if (self->slots[i] == 0) {
+        return FALSE;
+    }
+    *index = self->slots[i] - 1;
+    return TRUE;
 }
 
 struct tagTCell *dictionary_findDictionaryEntry(Dictionary *self, TString *key)
@@ -44,22 +79,20 @@ struct tagTCell *dictionary_findDictionaryEntry(Dictionary *self, TString *key)
     return self->data[idx].value;
 }
 
-int64_t dictionary_addDictionaryEntry(Dictionary *self, TString *key, Cell *value, int64_t index)
+int64_t dictionary_addDictionaryEntry(Dictionary *self, TString *key, Cell *value)
 {
-    // If we weren't provided an index to add at, then we'll find out where this value should be inserted at.
-    if (index < 0) {
-        if (dictionary_findIndex(self, key, &index)) {
-            cell_freeCell(self->data[index].value);
-            self->data[index].value = value;
-            return index;
-        }
+    uint64_t hash = hash_string(key);
+    int64_t i = find_slot(self, key, hash);
+    if (self->slots[i] != 0) {
+        // The dictionary takes ownership of the key it's given, so replace the existing (equal) key with it.
+        int64_t index = self->slots[i] - 1;
+        cell_freeCell(self->data[index].value);
+        string_freeString(self->data[index].key);
+        self->data[index].key = key;
+        self->data[index].value = value;
+        return index;
     }
 
-    //This could be a new dictionary; so we should ensure that we have at least the initial storage available.
-    if (self->data == NULL) {
-        self->data = malloc(self->max * sizeof(DictionaryEntry));
-    }
-    assert(self->data != NULL);
     if (self->len >= self->max) {
         self->max *= 2;
         self->data = realloc(self->data, self->max * sizeof(DictionaryEntry));
@@ -67,56 +100,125 @@ int64_t dictionary_addDictionaryEntry(Dictionary *self, TString *key, Cell *valu
             fatal_error("Could not realloc data for dictionary.  Size: %zd", self->max * sizeof(DictionaryEntry));
         }
     }
-    memmove(&self->data[index+1], &self->data[index], (self->len-index) * sizeof(DictionaryEntry));
-    self->len++;
+    int64_t index = self->len++;
     self->data[index].key = key;
     self->data[index].value = value;
+    self->data[index].hash = hash;
+
+    // Keep the hash table no more than half full.
+    if (2 * self->len > self->nslots) {
+        rebuild_slots(self, 2 * self->nslots);
+    } else {
+        self->slots[i] = index + 1;
+    }
+
+    // Adding keys in increasing order is common enough that it's worth keeping the sorted index up to date.
+    if (self->sorted_valid) {
+        if (index == 0 || string_compareString(self->data[self->sorted[index-1]].key, key) < 0) {
+            self->sorted = realloc(self->sorted, self->max * sizeof(int64_t));
+            if (self->sorted == NULL) {
+                fatal_error("Could not realloc sorted index for dictionary.");
+            }
+            self->sorted[index] = index;
+        } else {
+            self->sorted_valid = FALSE;
+        }
+    }
     return index;
 }
 
 void dictionary_removeDictionaryEntry(Dictionary *self, TString *key)
 {
-    int64_t idx = 0;
-    if (!dictionary_findIndex(self, key, &idx)) {
+    int64_t i = find_slot(self, key, hash_string(key));
+    if (self->slots[i] == 0) {
         return;
     }
+    int64_t idx = self->slots[i] - 1;
+    DictionaryEntry removed = self->data[idx];
 
-    cell_freeCell(self->data[idx].value);
-    string_freeString(self->data[idx].key);
-
-    memmove(&self->data[idx], &self->data[idx+1], sizeof(DictionaryEntry) * self->len-1);
+    // Move the last entry into the hole, and point its slot at the new position.
+    int64_t last = self->len - 1;
+    if (idx != last) {
+        int64_t j = find_slot(self, self->data[last].key, self->data[last].hash);
+        self->slots[j] = idx + 1;
+        self->data[idx] = self->data[last];
+    }
     self->len--;
+
+    cell_freeCell(removed.value);
+    string_freeString(removed.key);
+
+    // Move later slots in the same run back into the hole, so that a probe never stops early at an empty slot.
+    int64_t mask = self->nslots - 1;
+    int64_t j = i;
+    self->slots[i] = 0;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (self->slots[j] == 0) {
+            break;
+        }
+        int64_t k = (int64_t)(self->data[self->slots[j] - 1].hash & (uint64_t)mask);
+        if (i <= j ? (k <= i || k > j) : (k <= i && k > j)) {
+            self->slots[i] = self->slots[j];
+            self->slots[j] = 0;
+            i = j;
+        }
+    }
+    self->sorted_valid = FALSE;
 }
 
 Dictionary *dictionary_createDictionary(void)
 {
-    Dictionary *d = malloc(sizeof(struct tagTDictionary));
-    if (d == NULL) {
-        fatal_error("Could not allocate memory for dictionary.");
-    }
+    Dictionary *d = slab_alloc(sizeof(struct tagTDictionary));
     d->len = 0;
-    d->max = 8;
+    d->max = DICTIONARY_INITIAL_SIZE;
     d->refount = 1;
     d->data = malloc(d->max * sizeof(struct tagTDictionaryEntry));
     if (d->data == NULL) {
         fatal_error("Could not allocate space for %d dictionary entries.", d->max);
     }
+    d->nslots = 2 * DICTIONARY_INITIAL_SIZE;
+    d->slots = calloc(d->nslots, sizeof(int64_t));
+    if (d->slots == NULL) {
+        fatal_error("Could not allocate hash table for dictionary.");
+    }
+    d->sorted = NULL;
+    d->sorted_valid = TRUE;
     return d;
 }
 
 Dictionary *dictionary_copyDictionary(Dictionary *self)
 {
-    Dictionary *d = dictionary_createDictionary();
-    d->data = realloc(d->data, sizeof(DictionaryEntry) * self->len);
-
-    // There's no reason to do a sorted insert on a copy; self->data will already be sorted.
+    Dictionary *d = slab_alloc(sizeof(struct tagTDictionary));
+    d->len = self->len;
+    d->max = self->len > 0 ? self->len : DICTIONARY_INITIAL_SIZE;
+    d->refount = 1;
+    d->data = malloc(d->max * sizeof(DictionaryEntry));
+    if (d->data == NULL) {
+        fatal_error("Could not allocate space for %d dictionary entries.", d->max);
+    }
     for (int64_t i = 0; i < self->len; i++) {
         d->data[i].key = string_copyString(self->data[i].key);
         d->data[i].value = cell_fromCellValue(self->data[i].value);
+        d->data[i].hash = self->data[i].hash;
+    }
+
+    // The entries are at the same positions, so the hash table and sorted index can be copied as they are.
+    d->nslots = self->nslots;
+    d->slots = malloc(d->nslots * sizeof(int64_t));
+    if (d->slots == NULL) {
+        fatal_error("Could not allocate hash table for dictionary.");
+    }
+    memcpy(d->slots, self->slots, d->nslots * sizeof(int64_t));
+    d->sorted = NULL;
+    d->sorted_valid = self->sorted_valid;
+    if (d->sorted_valid && d->len > 0) {
+        d->sorted = malloc(d->max * sizeof(int64_t));
+        if (d->sorted == NULL) {
+            fatal_error("Could not allocate sorted index for dictionary.");
+        }
+        memcpy(d->sorted, self->sorted, d->len * sizeof(int64_t));
     }
-    d->len = self->len;
-    // We didn't take into account any extra space; so we want to make sure the limit is set.
-    d->max = self->len;
     return d;
 }
 
@@ -130,18 +232,12 @@ int dictionary_compareDictionary(Dictionary *lhs, Dictionary *rhs)
         return FALSE;
     }
 
-    Cell *keys = dictionary_getKeys(lhs);
-
-    for (size_t l = 0; l < keys->array->size; l++) {
-        Cell *e = dictionary_findDictionaryEntry(rhs, keys->array->data[l].string);
-        if (e != NULL) {
-            if (cell_compareCell(dictionary_findDictionaryEntry(lhs, keys->array->data[l].string), e) != 0) {
-                cell_freeCell(keys);
-                return FALSE;
-            }
+    for (int64_t i = 0; i < lhs->len; i++) {
+        Cell *e = dictionary_findDictionaryEntry(rhs, lhs->data[i].key);
+        if (e == NULL || cell_compareCell(lhs->data[i].value, e) != 0) {
+            return FALSE;
         }
     }
-    cell_freeCell(keys);
     return TRUE;
 }
 
@@ -155,18 +251,50 @@ void dictionary_freeDictionary(Dictionary *self)
                 string_freeString(self->data[i].key);
             }
             free(self->data);
-            free(self);
+            free(self->slots);
+            free(self->sorted);
+            slab_free(self, sizeof(struct tagTDictionary));
+        }
+    }
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    return string_compareString((*(DictionaryEntry **)a)->key, (*(DictionaryEntry **)b)->key);
+}
+
+DictionaryEntry *dictionary_getSortedEntry(Dictionary *self, int64_t n)
+{
+    assert(n >= 0 && n < self->len);
+    if (!self->sorted_valid) {
+        DictionaryEntry **entries = malloc(self->len * sizeof(DictionaryEntry *));
+        if (entries == NULL) {
+            fatal_error("Could not allocate sorted index for dictionary.");
+        }
+        for (int64_t i = 0; i < self->len; i++) {
+            entries[i] = &self->data[i];
+        }
+        qsort(entries, self->len, sizeof(DictionaryEntry *), compare_entries);
+        self->sorted = realloc(self->sorted, self->max * sizeof(int64_t));
+        if (self->sorted == NULL) {
+            fatal_error("Could not allocate sorted index for dictionary.");
+        }
+        for (int64_t i = 0; i < self->len; i++) {
+            self->sorted[i] = entries[i] - self->data;
         }
+        free(entries);
+        self->sorted_valid = TRUE;
     }
+    return &self->data[self->sorted[n]];
 }
 
 Cell *dictionary_getKeys(Dictionary *self)
 {
     Cell *r = cell_createArrayCell(0);
 
-    // There's no reason to sort the keys, they should come out sorted due to sort on insert.
     for (int64_t i = 0; i < self->len; i++) {
-        Cell *e = cell_fromStringLength(self->data[i].key->data, self->data[i].key->length);
+        TString *key = dictionary_getSortedEntry(self, i)->key;
+        Cell *e = cell_fromStringLength(key->data, key->length);
         cell_arrayAppendElementPointer(r, e);
     }
     return r;
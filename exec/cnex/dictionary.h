@@ -7,13 +7,23 @@
 typedef struct tagTDictionaryEntry {
     struct tagTString *key;
     struct tagTCell *value;
+    uint64_t hash;
 } DictionaryEntry;
 
+// Entries are kept in data[] in no particular order, and found through an
+// open addressing hash table (slots[]) that holds entry index + 1, with 0
+// meaning an empty slot.  Neon iterates dictionaries in key order, so
+// sorted[] holds the entry indexes in key order.  It is built the first
+// time it is needed after keys are added or removed.
 typedef struct tagTDictionary {
     int64_t len;
     int64_t max;
     int refount;
     struct tagTDictionaryEntry *data;
+    int64_t *slots;
+    int64_t nslots;
+    int64_t *sorted;
+    BOOL sorted_valid;
 } Dictionary;
 
 Dictionary *dictionary_createDictionary(void);
@@ -24,9 +34,10 @@ int dictionary_compareDictionary(Dictionary *lhs, Dictionary *rhs);
 
 struct tagTCell *dictionary_findDictionaryEntry(Dictionary *self, struct tagTString *key);
 BOOL dictionary_findIndex(Dictionary *self, struct tagTString *key, int64_t *index);
-int64_t dictionary_addDictionaryEntry(Dictionary *self, struct tagTString *key, struct tagTCell *value, int64_t index);
+int64_t dictionary_addDictionaryEntry(Dictionary *self, struct tagTString *key, struct tagTCell *value);
 void dictionary_removeDictionaryEntry(Dictionary *self, struct tagTString *key);
 
+DictionaryEntry *dictionary_getSortedEntry(Dictionary *self, int64_t n);
 struct tagTCell *dictionary_getKeys(Dictionary *self);
 
 #endif
@@ -54,4 +54,16 @@
 #define CHOICE_ParseNumberResult_number 0
 #define CHOICE_ParseNumberResult_error  1
 
+#define CHOICE_JsonResult_data      0
+#define CHOICE_JsonResult_error     1
+
+#define CHOICE_Opcode_any           0
+#define CHOICE_Opcode_char          1
+#define CHOICE_Opcode_class         2
+#define CHOICE_Opcode_begin         3
+#define CHOICE_Opcode_end           4
+#define CHOICE_Opcode_save          5
+#define CHOICE_Opcode_match         6
+#define CHOICE_Opcode_jump          7
+
 #endif
@@ -112,8 +112,10 @@ const char *cell_get_string(const struct Ne_Cell *cell)
 
 void cell_set_string(struct Ne_Cell *cell, const char *value)
 {
-    ((Cell*)cell)->string = string_createCString(value);
-    cell_ensureString((Cell*)cell); // This check happens AFTER we set the string, so as to not cause a memory leak.
+    size_t len = strlen(value);
+    cell_ensureString((Cell*)cell);
+    string_resizeString(((Cell*)cell)->string, len);
+    memcpy(((Cell*)cell)->string->data, value, len);
 }
 
 const unsigned char *cell_get_bytes(const struct Ne_Cell *cell)
@@ -130,9 +132,9 @@ int cell_get_bytes_size(const struct Ne_Cell *cell)
 
 void cell_set_bytes(struct Ne_Cell *cell, const unsigned char *value, int size)
 {
-    ((Cell*)cell)->string = string_createString(size);
+    cell_ensureBytes((Cell*)cell);
+    string_resizeString(((Cell*)cell)->string, size);
     memcpy(((Cell*)cell)->string->data, value, size);
-    cell_ensureBytes((Cell*)cell); // This check happens AFTER we set the string, so as to not cause a memory leak.
 }
 
 void *cell_get_pointer(const struct Ne_Cell *cell)
@@ -181,17 +183,15 @@ int cell_get_dictionary_size(const struct Ne_Cell *cell)
 
 const char *cell_get_dictionary_key(const struct Ne_Cell *cell, int n)
 {
-    // ToDo: Is this supposed to be sorted?
     cell_ensureDictionary((Cell*)cell);
-    return string_ensureNullTerminated(((Cell*)cell)->dictionary->data[n].key);
+    return string_ensureNullTerminated(dictionary_getSortedEntry(((Cell*)cell)->dictionary, n)->key);
 }
 
 const struct Ne_Cell *cell_get_dictionary_cell(const struct Ne_Cell *cell, const char *key)
 {
-    // ToDo: Test for memory leaks...  This is almsot certain to leak memory...
     cell_ensureDictionary((Cell*)cell);
-    Cell *c = cell_fromCString(key);
-    return (struct Ne_Cell*)dictionary_findDictionaryEntry(((Cell*)cell)->dictionary, c->string);
+    TString k = { strlen(key), (char*)key };
+    return (struct Ne_Cell*)dictionary_findDictionaryEntry(((Cell*)cell)->dictionary, &k);
 }
 
 struct Ne_Cell *cell_set_dictionary_cell(struct Ne_Cell *cell, const char *key)
@@ -255,6 +255,39 @@ int raise_exception(struct Ne_Cell *retval, const char *name, const char *info,
     return Ne_EXCEPTION;
 }
 
+int cell_get_string_size(const struct Ne_Cell *cell)
+{
+    cell_ensureString((Cell*)cell);
+    return (int)((Cell*)cell)->string->length;
+}
+
+char *cell_resize_string(struct Ne_Cell *cell, int size)
+{
+    cell_ensureString((Cell*)cell);
+    string_resizeString(((Cell*)cell)->string, size);
+    return ((Cell*)cell)->string->data;
+}
+
+unsigned char *cell_resize_bytes(struct Ne_Cell *cell, int size)
+{
+    cell_ensureBytes((Cell*)cell);
+    string_resizeString(((Cell*)cell)->string, size);
+    return (unsigned char*)((Cell*)cell)->string->data;
+}
+
+const char *cell_get_dictionary_entry(const struct Ne_Cell *cell, int n, const struct Ne_Cell **value)
+{
+    cell_ensureDictionary((Cell*)cell);
+    if (n < 0 || n >= ((Cell*)cell)->dictionary->len) {
+        return NULL;
+    }
+    DictionaryEntry *e = dictionary_getSortedEntry(((Cell*)cell)->dictionary, n);
+    if (value != NULL) {
+        *value = (struct Ne_Cell*)e->value;
+    }
+    return string_ensureNullTerminated(e->key);
+}
+
 struct Ne_MethodTable ExtensionMethodTable = {
     parameterlist_alloc,
     parameterlist_free,
@@ -287,5 +320,9 @@ struct Ne_MethodTable ExtensionMethodTable = {
     cell_get_dictionary_cell,
     cell_set_dictionary_cell,
     exec_callback,
-    raise_exception
+    raise_exception,
+    cell_get_string_size,
+    cell_resize_string,
+    cell_resize_bytes,
+    cell_get_dictionary_entry
 };
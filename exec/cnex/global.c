@@ -23,6 +23,7 @@
 #include "lib/datetime.h"
 #include "lib/debugger.h"
 #include "lib/io.h"
+#include "lib/json.h"
 #include "lib/file.h"
 #include "lib/math.h"
 #include "lib/mmap.h"
@@ -33,6 +34,7 @@
 #endif
 #include "lib/process.h"
 #include "lib/random.h"
+#include "lib/regex.h"
 #include "lib/runtime.h"
 #include "lib/sqlite.h"
 #include "lib/string.h"
@@ -117,6 +119,15 @@ TDispatch gfuncDispatch[] = {
     PDFUNC("io$write",                  io_write),
     PDFUNC("io$_writeBytes",            io_writeBytes),
 
+    // json - JSON encoding and decoding
+    PDFUNC("json$decode",               json_decode),
+    PDFUNC("json$decoderFeed",          json_decoderFeed),
+    PDFUNC("json$decoderFinish",        json_decoderFinish),
+    PDFUNC("json$decoderNext",          json_decoderNext),
+    PDFUNC("json$encode",               json_encode),
+    PDFUNC("json$newDecoder",           json_newDecoder),
+    PDFUNC("json$newSequenceDecoder",   json_newSequenceDecoder),
+
     // math - Arithmatic library module
     PDFUNC("math$abs",                  math_abs),
     PDFUNC("math$acos",                 math_acos),
@@ -269,6 +280,10 @@ TDispatch gfuncDispatch[] = {
     PDFUNC("random$bytes",              random_bytes),
     PDFUNC("random$uint32",             random_uint32),
 
+    // regex - regular expression matching
+    PDFUNC("regex$execute",             regex_execute),
+    PDFUNC("regex$load",                regex_load),
+
     // runtime - runtime support services
     PDFUNC("runtime$assertionsEnabled", runtime_assertionsEnabled),
     PDFUNC("runtime$createObject",      runtime_createObject),
@@ -283,6 +298,8 @@ TDispatch gfuncDispatch[] = {
     PDFUNC("sqlite$exec",               sqlite_exec),
     PDFUNC("sqlite$execOne",            sqlite_execOne),
     PDFUNC("sqlite$execRaw",            sqlite_execRaw),
+    PDFUNC("sqlite$execTyped",          sqlite_execTyped),
+    PDFUNC("sqlite$execMany",           sqlite_execMany),
     PDFUNC("sqlite$close",              sqlite_close),
     PDFUNC("sqlite$cursorDeclare",      sqlite_cursorDeclare),
     PDFUNC("sqlite$cursorOpen",         sqlite_cursorOpen),
@@ -393,6 +410,7 @@ TDispatch gfuncDispatch[] = {
     PDFUNC("builtin$string__toString",          string__toString),
     PDFUNC("builtin$string__index",             string__index),
     PDFUNC("builtin$string__length",            string__length),
+    PDFUNC("builtin$string__nextCharacter",     string__nextCharacter),
     PDFUNC("builtin$string__splice",            string__splice),
     PDFUNC("builtin$string__substring",         string__substring),
 
@@ -1101,7 +1119,7 @@ void bytes__toArray(TExecutor *exec)
     for (i = 0, e = 0; i < s->string->length; i++) {
         Cell *n = cell_fromNumber(number_from_uint32((uint8_t)s->string->data[i]));
         cell_copyCell(&a->array->data[e++], n);
-        free(n);
+        cell_freeCell(n);
     }
     pop(exec->stack);
     push(exec->stack, a);
@@ -1618,6 +1636,31 @@ void string__length(TExecutor *exec)
     push(exec->stack, cell_fromNumber(number_from_uint64(n)));
 }
 
+void string__nextCharacter(TExecutor *exec)
+{
+    /* The string is passed by address so that it is not copied for every
+       character, and the offset is a byte offset into its UTF-8 data. */
+    Cell *offset = top(exec->stack)->address; pop(exec->stack);
+    TString *s = top(exec->stack)->address->string; pop(exec->stack);
+
+    size_t i = number_to_uint64(offset->number);
+    if (i >= s->length) {
+        push(exec->stack, cell_fromCString(""));
+        return;
+    }
+    uint8_t c = s->data[i] & 0xff;
+    size_t n = (c & 0x80) == 0x00 ? 1
+             : (c & 0xe0) == 0xc0 ? 2
+             : (c & 0xf0) == 0xe0 ? 3
+             : (c & 0xf8) == 0xf0 ? 4
+             : 1;
+    if (i + n > s->length) {
+        n = s->length - i;
+    }
+    offset->number = number_from_uint64(i + n);
+    push(exec->stack, cell_fromStringLength(&s->data[i], n));
+}
+
 void string__splice(TExecutor *exec)
 {
     /* TODO: utf8 */
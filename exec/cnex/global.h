@@ -82,6 +82,7 @@ void string__encodeUTF8(struct tagTExecutor *exec);
 void string__toString(struct tagTExecutor *exec);
 void string__index(struct tagTExecutor *exec);
 void string__length(struct tagTExecutor *exec);
+void string__nextCharacter(struct tagTExecutor *exec);
 void string__splice(struct tagTExecutor *exec);
 void string__substring(struct tagTExecutor *exec);
 
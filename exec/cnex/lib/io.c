@@ -151,7 +151,7 @@ void io_readBytes(TExecutor *exec)
 
     uint64_t ncount = number_to_uint64(count);
 
-    Cell *r = cell_createStringCell(ncount);
+    Cell *r = cell_createBytesCell(ncount);
     size_t n = fread((unsigned char *)r->string->data, 1, ncount, f);
 
     if (n != ncount) {
@@ -0,0 +1,800 @@
+#include "json.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "cell.h"
+#include "dictionary.h"
+#include "enums.h"
+#include "exec.h"
+#include "nstring.h"
+#include "number.h"
+#include "object.h"
+#include "stack.h"
+#include "util.h"
+
+// This is the same resumable decoder as lib/json.cpp. It is given the input
+// one byte at a time, and keeps the arrays and dictionaries it is building
+// on its own stack, so it can stop at the end of any chunk.
+
+typedef enum tagEJsonState {
+    jsValue,
+    jsArrayFirst,
+    jsArrayNext,
+    jsObjectFirst,
+    jsObjectColon,
+    jsObjectNext,
+    jsAfter,
+    jsLiteral,
+    jsNumberMinus,
+    jsNumberZero,
+    jsNumberInt,
+    jsNumberDot,
+    jsNumberFrac,
+    jsNumberE,
+    jsNumberESign,
+    jsNumberExp,
+    jsString,
+    jsStringEscape,
+    jsStringHex,
+    jsFailed,
+    jsDone,
+} JsonState;
+
+typedef struct tagTBuffer {
+    char *data;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+typedef struct tagTContainer {
+    BOOL object;
+    Cell *value;
+    TString *key;
+} Container;
+
+typedef struct tagTDecoder {
+    BOOL sequence;
+    JsonState state;
+    BOOL finished;
+    uint64_t index;
+    uint64_t start;
+    Container *stack;
+    size_t depth;
+    size_t stack_capacity;
+    Buffer token;
+    uint32_t hex;
+    int hex_digits;
+    uint32_t high_surrogate;
+    Object *value;
+    Cell **results;
+    size_t results_head;
+    size_t results_count;
+    size_t results_capacity;
+} Decoder;
+
+static const char ReplacementCharacter[] = "\xef\xbf\xbd";
+
+static void buffer_reserve(Buffer *b, size_t n)
+{
+    if (b->length + n > b->capacity) {
+        b->capacity = b->capacity * 2 > b->length + n ? b->capacity * 2 : b->length + n + 16;
+        b->data = realloc(b->data, b->capacity);
+        if (b->data == NULL) {
+            fatal_error("Could not allocate memory for json.  Size: %zd", b->capacity);
+        }
+    }
+}
+
+static void buffer_append(Buffer *b, const char *data, size_t length)
+{
+    buffer_reserve(b, length);
+    memcpy(&b->data[b->length], data, length);
+    b->length += length;
+}
+
+static void buffer_appendChar(Buffer *b, char c)
+{
+    buffer_reserve(b, 1);
+    b->data[b->length++] = c;
+}
+
+static void buffer_appendCodePoint(Buffer *b, uint32_t c)
+{
+    if (c < 0x80) {
+        buffer_appendChar(b, (char)c);
+    } else if (c < 0x800) {
+        buffer_appendChar(b, (char)(0xc0 | (c >> 6)));
+        buffer_appendChar(b, (char)(0x80 | (c & 0x3f)));
+    } else if (c < 0x10000) {
+        buffer_appendChar(b, (char)(0xe0 | (c >> 12)));
+        buffer_appendChar(b, (char)(0x80 | ((c >> 6) & 0x3f)));
+        buffer_appendChar(b, (char)(0x80 | (c & 0x3f)));
+    } else {
+        buffer_appendChar(b, (char)(0xf0 | (c >> 18)));
+        buffer_appendChar(b, (char)(0x80 | ((c >> 12) & 0x3f)));
+        buffer_appendChar(b, (char)(0x80 | ((c >> 6) & 0x3f)));
+        buffer_appendChar(b, (char)(0x80 | (c & 0x3f)));
+    }
+}
+
+static BOOL is_whitespace(int c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static BOOL is_digit(int c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static Decoder *decoder_create(BOOL sequence)
+{
+    Decoder *d = malloc(sizeof(Decoder));
+    if (d == NULL) {
+        fatal_error("Could not allocate memory for json decoder.");
+    }
+    memset(d, 0, sizeof(Decoder));
+    d->sequence = sequence;
+    d->state = jsValue;
+    return d;
+}
+
+static void decoder_clearStack(Decoder *d)
+{
+    while (d->depth > 0) {
+        d->depth--;
+        cell_freeCell(d->stack[d->depth].value);
+        if (d->stack[d->depth].key != NULL) {
+            string_freeString(d->stack[d->depth].key);
+        }
+    }
+}
+
+static void decoder_free(Decoder *d)
+{
+    decoder_clearStack(d);
+    free(d->stack);
+    free(d->token.data);
+    if (d->value != NULL) {
+        d->value->release(d->value);
+    }
+    for (size_t i = d->results_head; i < d->results_count; i++) {
+        cell_freeCell(d->results[i]);
+    }
+    free(d->results);
+    free(d);
+}
+
+static void push_result(Decoder *d, uint32_t tag, Cell *payload)
+{
+    Cell *r = cell_createArrayCell(2);
+    Cell *t = cell_arrayIndexForWrite(r, 0);
+    t->type = cNumber;
+    t->number = number_from_uint32(tag);
+    cell_copyCell(cell_arrayIndexForWrite(r, 1), payload);
+    cell_freeCell(payload);
+
+    if (d->results_head == d->results_count) {
+        d->results_head = 0;
+        d->results_count = 0;
+    }
+    if (d->results_count >= d->results_capacity) {
+        d->results_capacity = d->results_capacity > 0 ? d->results_capacity * 2 : 8;
+        d->results = realloc(d->results, d->results_capacity * sizeof(Cell *));
+        if (d->results == NULL) {
+            fatal_error("Could not allocate memory for json results.");
+        }
+    }
+    d->results[d->results_count++] = r;
+}
+
+static void fail(Decoder *d, const char *message, uint64_t at)
+{
+    Cell *e = cell_createArrayCell(2);
+    Cell *t = cell_arrayIndexForWrite(e, 0);
+    t->type = cString;
+    t->string = string_createCString(message);
+    t = cell_arrayIndexForWrite(e, 1);
+    t->type = cNumber;
+    t->number = number_from_uint64(at);
+    push_result(d, CHOICE_JsonResult_error, e);
+    d->state = jsFailed;
+    decoder_clearStack(d);
+    d->token.length = 0;
+    if (d->value != NULL) {
+        d->value->release(d->value);
+        d->value = NULL;
+    }
+}
+
+// Put a complete value into the container it belongs to, where end is the
+// index just after the value. The decoder takes ownership of v.
+static void complete(Decoder *d, Object *v, uint64_t end)
+{
+    if (d->depth == 0) {
+        if (d->sequence) {
+            push_result(d, CHOICE_JsonResult_data, cell_fromObject(v));
+            d->state = jsValue;
+        } else {
+            d->value = v;
+            d->state = jsAfter;
+        }
+        return;
+    }
+    Container *top = &d->stack[d->depth-1];
+    if (!top->object) {
+        cell_arrayAppendElementPointer(top->value, cell_fromObject(v));
+        d->state = jsArrayNext;
+    } else if (top->key == NULL) {
+        if (v->type != oString) {
+            v->release(v);
+            fail(d, "string key expected", end);
+            return;
+        }
+        top->key = string_fromString(((Cell *)v->ptr)->string);
+        v->release(v);
+        d->state = jsObjectColon;
+    } else {
+        dictionary_addDictionaryEntry(top->value->dictionary, top->key, cell_fromObject(v));
+        top->key = NULL;
+        d->state = jsObjectNext;
+    }
+}
+
+static void open_container(Decoder *d, BOOL object)
+{
+    if (d->depth >= d->stack_capacity) {
+        d->stack_capacity = d->stack_capacity > 0 ? d->stack_capacity * 2 : 16;
+        d->stack = realloc(d->stack, d->stack_capacity * sizeof(Container));
+        if (d->stack == NULL) {
+            fatal_error("Could not allocate memory for json decoder stack.");
+        }
+    }
+    Container *c = &d->stack[d->depth++];
+    c->object = object;
+    c->value = object ? cell_createDictionaryCell() : cell_createArrayCell(0);
+    c->key = NULL;
+    d->state = object ? jsObjectFirst : jsArrayFirst;
+}
+
+static void close_container(Decoder *d, uint64_t end)
+{
+    d->depth--;
+    complete(d, object_fromCell(d->stack[d->depth].value), end);
+}
+
+static void flush_surrogate(Decoder *d)
+{
+    if (d->high_surrogate != 0) {
+        buffer_append(&d->token, ReplacementCharacter, sizeof(ReplacementCharacter) - 1);
+        d->high_surrogate = 0;
+    }
+}
+
+static BOOL token_is(Decoder *d, const char *s)
+{
+    return d->token.length == strlen(s) && memcmp(d->token.data, s, d->token.length) == 0;
+}
+
+static void finish_literal(Decoder *d)
+{
+    if (token_is(d, "null")) {
+        complete(d, object_createObject(), d->index);
+    } else if (token_is(d, "false")) {
+        complete(d, object_createBooleanObject(FALSE), d->index);
+    } else if (token_is(d, "true")) {
+        complete(d, object_createBooleanObject(TRUE), d->index);
+    } else {
+        fail(d, "null or false or true expected", d->start);
+    }
+}
+
+static void finish_number(Decoder *d)
+{
+    buffer_appendChar(&d->token, 0);
+    Number n = number_from_string(d->token.data);
+    if (number_is_nan(n)) {
+        fail(d, "number format error", 0);
+        return;
+    }
+    complete(d, object_createNumberObject(n), d->index);
+}
+
+static void finish_string(Decoder *d)
+{
+    flush_surrogate(d);
+    TString s = { d->token.length, d->token.data };
+    size_t error_offset;
+    if (!string_isValidUtf8(&s, &error_offset)) {
+        fail(d, "invalid character", d->start);
+        return;
+    }
+    complete(d, object_fromCell(cell_fromStringLength(d->token.data, d->token.length)), d->index + 1);
+}
+
+static void finish_hex(Decoder *d)
+{
+    uint32_t c = d->hex;
+    if (c >= 0xd800 && c < 0xdc00) {
+        flush_surrogate(d);
+        d->high_surrogate = c;
+    } else if (c >= 0xdc00 && c < 0xe000) {
+        if (d->high_surrogate != 0) {
+            buffer_appendCodePoint(&d->token, 0x10000 + ((d->high_surrogate - 0xd800) << 10) + (c - 0xdc00));
+            d->high_surrogate = 0;
+        } else {
+            buffer_append(&d->token, ReplacementCharacter, sizeof(ReplacementCharacter) - 1);
+        }
+    } else {
+        flush_surrogate(d);
+        buffer_appendCodePoint(&d->token, c);
+    }
+    d->state = jsString;
+}
+
+// Handle one byte of input (or -1 for the end of the input). Returns FALSE
+// if the byte ended a token and must be handled again in the new state.
+static BOOL step(Decoder *d, int c)
+{
+    switch (d->state) {
+        case jsValue:
+            if (is_whitespace(c)) {
+                return TRUE;
+            }
+            d->start = d->index;
+            d->token.length = 0;
+            if (c >= 'a' && c <= 'z') {
+                buffer_appendChar(&d->token, (char)c);
+                d->state = jsLiteral;
+            } else if (c == '-') {
+                buffer_appendChar(&d->token, '-');
+                d->state = jsNumberMinus;
+            } else if (is_digit(c)) {
+                d->state = jsNumberMinus;
+                return FALSE;
+            } else if (c == '"') {
+                d->high_surrogate = 0;
+                d->state = jsString;
+            } else if (c == '[') {
+                open_container(d, FALSE);
+            } else if (c == '{') {
+                open_container(d, TRUE);
+            } else if (c < 0 && d->sequence && d->depth == 0) {
+                d->state = jsDone;
+            } else {
+                fail(d, "value expected", d->index);
+            }
+            return TRUE;
+        case jsArrayFirst:
+        case jsObjectFirst:
+            if (is_whitespace(c)) {
+                return TRUE;
+            }
+            if (c == (d->state == jsArrayFirst ? ']' : '}')) {
+                close_container(d, d->index + 1);
+                return TRUE;
+            }
+            d->state = jsValue;
+            return FALSE;
+        case jsArrayNext:
+            if (is_whitespace(c)) {
+                return TRUE;
+            }
+            if (c == ',') {
+                d->state = jsValue;
+            } else if (c == ']') {
+                close_container(d, d->index + 1);
+            } else {
+                fail(d, ", or ] expected", d->index);
+            }
+            return TRUE;
+        case jsObjectColon:
+            if (is_whitespace(c)) {
+                return TRUE;
+            }
+            if (c == ':') {
+                d->state = jsValue;
+            } else {
+                fail(d, ": expected", d->index);
+            }
+            return TRUE;
+        case jsObjectNext:
+            if (is_whitespace(c)) {
+                return TRUE;
+            }
+            if (c == ',') {
+                d->state = jsValue;
+            } else if (c == '}') {
+                close_container(d, d->index + 1);
+            } else {
+                fail(d, ", or } expected", d->index);
+            }
+            return TRUE;
+        case jsAfter:
+            if (is_whitespace(c)) {
+                return TRUE;
+            }
+            if (c < 0) {
+                push_result(d, CHOICE_JsonResult_data, cell_fromObject(d->value));
+                d->value = NULL;
+                d->state = jsDone;
+            } else {
+                fail(d, "unexpected input after value", d->index);
+            }
+            return TRUE;
+        case jsLiteral:
+            if (c >= 'a' && c <= 'z') {
+                buffer_appendChar(&d->token, (char)c);
+                return TRUE;
+            }
+            finish_literal(d);
+            return FALSE;
+        case jsNumberMinus:
+            if (c == '0') {
+                d->state = jsNumberZero;
+            } else if (is_digit(c)) {
+                d->state = jsNumberInt;
+            } else {
+                fail(d, "digit expected", d->start);
+                return TRUE;
+            }
+            buffer_appendChar(&d->token, (char)c);
+            return TRUE;
+        case jsNumberZero:
+        case jsNumberInt:
+        case jsNumberFrac:
+            if (is_digit(c) && d->state != jsNumberZero) {
+                buffer_appendChar(&d->token, (char)c);
+                return TRUE;
+            }
+            if (c == '.' && d->state != jsNumberFrac) {
+                buffer_appendChar(&d->token, '.');
+                d->state = jsNumberDot;
+                return TRUE;
+            }
+            if (c == 'e' || c == 'E') {
+                buffer_appendChar(&d->token, (char)c);
+                d->state = jsNumberE;
+                return TRUE;
+            }
+            finish_number(d);
+            return FALSE;
+        case jsNumberDot:
+        case jsNumberESign:
+            if (!is_digit(c)) {
+                fail(d, "digit expected", d->start);
+                return TRUE;
+            }
+            buffer_appendChar(&d->token, (char)c);
+            d->state = d->state == jsNumberDot ? jsNumberFrac : jsNumberExp;
+            return TRUE;
+        case jsNumberE:
+            if (c == '+' || c == '-') {
+                buffer_appendChar(&d->token, (char)c);
+                d->state = jsNumberESign;
+            } else if (is_digit(c)) {
+                buffer_appendChar(&d->token, (char)c);
+                d->state = jsNumberExp;
+            } else {
+                fail(d, "digit expected", d->start);
+            }
+            return TRUE;
+        case jsNumberExp:
+            if (is_digit(c)) {
+                buffer_appendChar(&d->token, (char)c);
+                return TRUE;
+            }
+            finish_number(d);
+            return FALSE;
+        case jsString:
+            if (c == '"') {
+                finish_string(d);
+            } else if (c == '\\') {
+                d->state = jsStringEscape;
+            } else if (c < 0) {
+                fail(d, "missing trailing quote", d->index);
+            } else if (c < 0x20) {
+                fail(d, "invalid character", d->index);
+            } else {
+                flush_surrogate(d);
+                buffer_appendChar(&d->token, (char)c);
+            }
+            return TRUE;
+        case jsStringEscape:
+            if (c == 'u') {
+                d->hex = 0;
+                d->hex_digits = 0;
+                d->state = jsStringHex;
+                return TRUE;
+            }
+            if (c < 0) {
+                fail(d, "missing trailing quote", d->index);
+                return TRUE;
+            }
+            flush_surrogate(d);
+            switch (c) {
+                case '"':
+                case '\\':
+                case '/':
+                    buffer_appendChar(&d->token, (char)c);
+                    break;
+                case 'b': buffer_appendChar(&d->token, '\b'); break;
+                case 'f': buffer_appendChar(&d->token, '\f'); break;
+                case 'n': buffer_appendChar(&d->token, '\n'); break;
+                case 'r': buffer_appendChar(&d->token, '\r'); break;
+                case 't': buffer_appendChar(&d->token, '\t'); break;
+                default:
+                    fail(d, "invalid escape sequence", d->index);
+                    return TRUE;
+            }
+            d->state = jsString;
+            return TRUE;
+        case jsStringHex:
+            if (is_digit(c)) {
+                d->hex = (d->hex << 4) | (uint32_t)(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                d->hex = (d->hex << 4) | (uint32_t)(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                d->hex = (d->hex << 4) | (uint32_t)(c - 'A' + 10);
+            } else {
+                fail(d, "invalid hex character", d->index);
+                return TRUE;
+            }
+            d->hex_digits++;
+            if (d->hex_digits == 4) {
+                finish_hex(d);
+            }
+            return TRUE;
+        case jsFailed:
+        case jsDone:
+            return TRUE;
+    }
+    return TRUE;
+}
+
+static void decoder_feed(Decoder *d, const unsigned char *data, size_t length)
+{
+    const unsigned char *end = data + length;
+    const unsigned char *p = data;
+    while (p < end) {
+        if (d->state == jsString && d->high_surrogate == 0) {
+            // Copy a run of ordinary characters in one go.
+            const unsigned char *q = p;
+            while (q < end && *q != '"' && *q != '\\' && *q >= 0x20) {
+                if ((*q & 0xc0) != 0x80) {
+                    d->index++;
+                }
+                q++;
+            }
+            buffer_append(&d->token, (const char *)p, q - p);
+            p = q;
+            if (p == end) {
+                break;
+            }
+        }
+        if (step(d, *p)) {
+            if ((*p & 0xc0) != 0x80) {
+                d->index++;
+            }
+            p++;
+        }
+    }
+}
+
+static void decoder_finish(Decoder *d)
+{
+    d->finished = TRUE;
+    while (!step(d, -1)) {
+    }
+}
+
+static Cell *decoder_next(Decoder *d)
+{
+    if (d->results_head == d->results_count) {
+        return NULL;
+    }
+    return d->results[d->results_head++];
+}
+
+static void object_releaseDecoderObject(Object *o)
+{
+    if (o != NULL) {
+        assert(o->refcount > 0);
+        o->refcount--;
+        if (o->refcount <= 0) {
+            decoder_free(o->ptr);
+            free(o);
+        }
+    }
+}
+
+static Cell *object_decoderObjectToString(Object *self)
+{
+    (void)self;
+    return cell_fromCString("<JSON decoder>");
+}
+
+static Object *object_createDecoderObject(Decoder *d)
+{
+    Object *r = object_createObject();
+    r->ptr = d;
+    r->release = object_releaseDecoderObject;
+    r->toString = object_decoderObjectToString;
+    return r;
+}
+
+static Decoder *check_decoder(Cell *pdecoder)
+{
+    if (pdecoder->type != cObject || pdecoder->object == NULL || pdecoder->object->release != object_releaseDecoderObject) {
+        return NULL;
+    }
+    return pdecoder->object->ptr;
+}
+
+static void encode_string(Buffer *r, TString *s)
+{
+    buffer_appendChar(r, '"');
+    for (size_t i = 0; i < s->length; i++) {
+        char c = s->data[i];
+        switch (c) {
+            case '"':  buffer_append(r, "\\\"", 2); break;
+            case '\\': buffer_append(r, "\\\\", 2); break;
+            case '\b': buffer_append(r, "\\b", 2); break;
+            case '\f': buffer_append(r, "\\f", 2); break;
+            case '\n': buffer_append(r, "\\n", 2); break;
+            case '\r': buffer_append(r, "\\r", 2); break;
+            case '\t': buffer_append(r, "\\t", 2); break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[7];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    buffer_append(r, buf, 6);
+                } else {
+                    buffer_appendChar(r, c);
+                }
+                break;
+        }
+    }
+    buffer_appendChar(r, '"');
+}
+
+static void encode_value(Buffer *r, Object *data)
+{
+    if (data == NULL || (data->type == oNone && data->ptr == NULL)) {
+        buffer_append(r, "null", 4);
+        return;
+    }
+    Cell *v = data->ptr;
+    switch (data->type) {
+        case oBoolean:
+            if (v->boolean) {
+                buffer_append(r, "true", 4);
+            } else {
+                buffer_append(r, "false", 5);
+            }
+            break;
+        case oNumber: {
+            const char *s = number_to_string(v->number);
+            buffer_append(r, s, strlen(s));
+            break;
+        }
+        case oString:
+            encode_string(r, v->string);
+            break;
+        case oArray:
+            buffer_appendChar(r, '[');
+            for (size_t i = 0; i < v->array->size; i++) {
+                if (i > 0) {
+                    buffer_appendChar(r, ',');
+                }
+                encode_value(r, v->array->data[i].object);
+            }
+            buffer_appendChar(r, ']');
+            break;
+        case oDictionary:
+            buffer_appendChar(r, '{');
+            for (int64_t i = 0; i < v->dictionary->len; i++) {
+                if (i > 0) {
+                    buffer_appendChar(r, ',');
+                }
+                DictionaryEntry *e = dictionary_getSortedEntry(v->dictionary, i);
+                encode_string(r, e->key);
+                buffer_appendChar(r, ':');
+                encode_value(r, e->value->object);
+            }
+            buffer_appendChar(r, '}');
+            break;
+        default:
+            buffer_append(r, "?unknown", 8);
+            break;
+    }
+}
+
+
+
+void json_decode(TExecutor *exec)
+{
+    TString *json = top(exec->stack)->string;
+
+    Decoder *d = decoder_create(FALSE);
+    decoder_feed(d, (const unsigned char *)json->data, json->length);
+    decoder_finish(d);
+    Cell *r = decoder_next(d);
+    decoder_free(d);
+
+    pop(exec->stack);
+    push(exec->stack, r);
+}
+
+void json_decoderFeed(TExecutor *exec)
+{
+    TString *chunk = top(exec->stack)->string;
+    Decoder *d = check_decoder(peek(exec->stack, 1));
+    BOOL finished = d != NULL && d->finished;
+    if (d != NULL && !finished) {
+        decoder_feed(d, (const unsigned char *)chunk->data, chunk->length);
+    }
+    pop(exec->stack);
+    pop(exec->stack);
+
+    if (d == NULL) {
+        exec->rtl_raise(exec, "JsonException.InvalidDecoder", "");
+    } else if (finished) {
+        exec->rtl_raise(exec, "JsonException.InvalidDecoder", "finished");
+    }
+}
+
+void json_decoderFinish(TExecutor *exec)
+{
+    Decoder *d = check_decoder(top(exec->stack));
+    if (d != NULL && !d->finished) {
+        decoder_finish(d);
+    }
+    pop(exec->stack);
+
+    if (d == NULL) {
+        exec->rtl_raise(exec, "JsonException.InvalidDecoder", "");
+    }
+}
+
+void json_decoderNext(TExecutor *exec)
+{
+    Decoder *d = check_decoder(top(exec->stack));
+    Cell *r = d != NULL ? decoder_next(d) : NULL;
+    pop(exec->stack);
+
+    if (d == NULL) {
+        exec->rtl_raise(exec, "JsonException.InvalidDecoder", "");
+        return;
+    }
+    push(exec->stack, cell_fromBoolean(r != NULL));
+    push(exec->stack, r != NULL ? r : cell_newCell());
+}
+
+void json_encode(TExecutor *exec)
+{
+    Object *data = top(exec->stack)->object;
+
+    Buffer r = { NULL, 0, 0 };
+    encode_value(&r, data);
+    Cell *s = cell_fromStringLength(r.data, r.length);
+    free(r.data);
+
+    pop(exec->stack);
+    push(exec->stack, s);
+}
+
+void json_newDecoder(TExecutor *exec)
+{
+    push(exec->stack, cell_fromObject(object_createDecoderObject(decoder_create(FALSE))));
+}
+
+void json_newSequenceDecoder(TExecutor *exec)
+{
+    push(exec->stack, cell_fromObject(object_createDecoderObject(decoder_create(TRUE))));
+}
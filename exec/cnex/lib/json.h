@@ -0,0 +1,14 @@
+#ifndef JSON_H
+#define JSON_H
+
+struct tagTExecutor;
+
+void json_decode(struct tagTExecutor *exec);
+void json_decoderFeed(struct tagTExecutor *exec);
+void json_decoderFinish(struct tagTExecutor *exec);
+void json_decoderNext(struct tagTExecutor *exec);
+void json_encode(struct tagTExecutor *exec);
+void json_newDecoder(struct tagTExecutor *exec);
+void json_newSequenceDecoder(struct tagTExecutor *exec);
+
+#endif
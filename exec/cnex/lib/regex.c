@@ -0,0 +1,353 @@
+#include "regex.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "cell.h"
+#include "dictionary.h"
+#include "enums.h"
+#include "exec.h"
+#include "nstring.h"
+#include "number.h"
+#include "object.h"
+#include "stack.h"
+#include "util.h"
+
+// This decodes and runs the program compiled by regex.neon the same way as
+// lib/regex.cpp does, following every thread of the program together one character of
+// the target at a time (a Pike VM) instead of backtracking.
+
+typedef struct tagTInstruction {
+    uint32_t opcode;
+    uint32_t c;
+    BOOL complement;
+    uint32_t *chars;
+    size_t nchars;
+    size_t *targets;
+    size_t ntargets;
+} Instruction;
+
+// A decoded program, kept in the Regex record so that each match can use
+// it directly.
+typedef struct tagTProgram {
+    Instruction *instructions;
+    size_t size;
+    size_t nsaved;
+    size_t nedges;
+} Program;
+
+// A list of threads, each with a program counter and nsaved positions.
+typedef struct tagTThreadList {
+    size_t count;
+    size_t *pc;
+    int64_t *saved;
+} ThreadList;
+
+typedef struct tagTMachine {
+    Instruction *program;
+    size_t size;
+    size_t nsaved;
+    uint32_t *text;
+    size_t length;
+    size_t *visited;
+    ThreadList stack;
+    int64_t *tmp;
+} Machine;
+
+static void *checked_malloc(size_t size)
+{
+    void *p = malloc(size > 0 ? size : 1);
+    if (p == NULL) {
+        fatal_error("Could not allocate memory for regex.  Size: %zd", size);
+    }
+    return p;
+}
+
+// Decode the next UTF-8 code point from s starting at byte *i, and advance *i past it.
+static uint32_t next_code_point(TString *s, size_t *i)
+{
+    uint32_t c = s->data[*i] & 0xff;
+    (*i)++;
+    if (c & 0x80) {
+        int n = 0;
+        if ((c & 0xe0) == 0xc0) {
+            c &= 0x1f;
+            n = 1;
+        } else if ((c & 0xf0) == 0xe0) {
+            c &= 0x0f;
+            n = 2;
+        } else if ((c & 0xf8) == 0xf0) {
+            c &= 0x07;
+            n = 3;
+        }
+        while (n-- > 0 && *i < s->length && (s->data[*i] & 0xc0) == 0x80) {
+            c = (c << 6) | (s->data[*i] & 0x3f);
+            (*i)++;
+        }
+    }
+    return c;
+}
+
+static uint32_t first_code_point(TString *s)
+{
+    size_t i = 0;
+    return s->length > 0 ? next_code_point(s, &i) : 0;
+}
+
+static int compare_code_points(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static Instruction *decode(Cell *regex, size_t *size, size_t *nsaved, size_t *nedges)
+{
+    *size = regex->array->size;
+    *nsaved = 0;
+    *nedges = *size;
+    Instruction *program = checked_malloc(*size * sizeof(Instruction));
+    for (size_t i = 0; i < *size; i++) {
+        Cell *choice = &regex->array->data[i];
+        Instruction *inst = &program[i];
+        memset(inst, 0, sizeof(Instruction));
+        inst->opcode = number_to_uint32(choice->array->data[0].number);
+        if (inst->opcode == CHOICE_Opcode_char) {
+            inst->c = first_code_point(choice->array->data[1].string);
+        } else if (inst->opcode == CHOICE_Opcode_class) {
+            Cell *cls = &choice->array->data[1];
+            Dictionary *chars = cls->array->data[0].dictionary;
+            inst->nchars = chars->len;
+            inst->chars = checked_malloc(inst->nchars * sizeof(uint32_t));
+            for (int64_t j = 0; j < chars->len; j++) {
+                inst->chars[j] = first_code_point(chars->data[j].key);
+            }
+            qsort(inst->chars, inst->nchars, sizeof(uint32_t), compare_code_points);
+            inst->complement = cls->array->data[1].boolean;
+        } else if (inst->opcode == CHOICE_Opcode_save) {
+            inst->c = number_to_uint32(choice->array->data[1].number);
+            if (inst->c + 1 > *nsaved) {
+                *nsaved = inst->c + 1;
+            }
+        } else if (inst->opcode == CHOICE_Opcode_jump) {
+            Array *targets = choice->array->data[1].array;
+            inst->ntargets = targets->size;
+            inst->targets = checked_malloc(inst->ntargets * sizeof(size_t));
+            for (size_t j = 0; j < targets->size; j++) {
+                inst->targets[j] = number_to_uint32(targets->data[j].number);
+            }
+            *nedges += inst->ntargets;
+        }
+    }
+    return program;
+}
+
+static void init_list(ThreadList *list, size_t capacity, size_t nsaved)
+{
+    list->count = 0;
+    list->pc = checked_malloc(capacity * sizeof(size_t));
+    list->saved = checked_malloc(capacity * nsaved * sizeof(int64_t));
+}
+
+static void free_list(ThreadList *list)
+{
+    free(list->pc);
+    free(list->saved);
+}
+
+static void push_thread(ThreadList *list, size_t nsaved, size_t pc, const int64_t *saved)
+{
+    list->pc[list->count] = pc;
+    memcpy(&list->saved[list->count * nsaved], saved, nsaved * sizeof(int64_t));
+    list->count++;
+}
+
+// Add the thread starting at pc to list, after following every instruction
+// that doesn't consume a character, depth first in priority order.
+static void add_thread(Machine *m, ThreadList *list, size_t generation, size_t pc, const int64_t *saved, size_t pos)
+{
+    m->stack.count = 0;
+    push_thread(&m->stack, m->nsaved, pc, saved);
+    while (m->stack.count > 0) {
+        m->stack.count--;
+        pc = m->stack.pc[m->stack.count];
+        memcpy(m->tmp, &m->stack.saved[m->stack.count * m->nsaved], m->nsaved * sizeof(int64_t));
+        if (pc >= m->size || m->visited[pc] == generation) {
+            continue;
+        }
+        m->visited[pc] = generation;
+        Instruction *inst = &m->program[pc];
+        switch (inst->opcode) {
+            case CHOICE_Opcode_begin:
+                if (pos == 0) {
+                    push_thread(&m->stack, m->nsaved, pc + 1, m->tmp);
+                }
+                break;
+            case CHOICE_Opcode_end:
+                if (pos >= m->length) {
+                    push_thread(&m->stack, m->nsaved, pc + 1, m->tmp);
+                }
+                break;
+            case CHOICE_Opcode_save:
+                m->tmp[inst->c] = (int64_t)pos;
+                push_thread(&m->stack, m->nsaved, pc + 1, m->tmp);
+                break;
+            case CHOICE_Opcode_jump:
+                for (size_t j = inst->ntargets; j > 0; j--) {
+                    push_thread(&m->stack, m->nsaved, inst->targets[j-1], m->tmp);
+                }
+                break;
+            default:
+                push_thread(list, m->nsaved, pc, m->tmp);
+                break;
+        }
+    }
+}
+
+static BOOL accepts(Machine *m, Instruction *inst, size_t pos)
+{
+    if (pos >= m->length) {
+        return FALSE;
+    }
+    uint32_t c = m->text[pos];
+    switch (inst->opcode) {
+        case CHOICE_Opcode_any:
+            return TRUE;
+        case CHOICE_Opcode_char:
+            return c == inst->c;
+        case CHOICE_Opcode_class:
+            return (bsearch(&c, inst->chars, inst->nchars, sizeof(uint32_t), compare_code_points) != NULL) != inst->complement;
+        default:
+            return FALSE;
+    }
+}
+
+static BOOL run(Machine *m, int64_t *result)
+{
+    ThreadList lists[2];
+    init_list(&lists[0], m->size, m->nsaved);
+    init_list(&lists[1], m->size, m->nsaved);
+    ThreadList *current = &lists[0];
+    ThreadList *next = &lists[1];
+    for (size_t i = 0; i < m->nsaved; i++) {
+        result[i] = -1;
+    }
+    size_t generation = 0;
+    add_thread(m, current, generation, 0, result, 0);
+    BOOL matched = FALSE;
+    for (size_t pos = 0; current->count > 0; pos++) {
+        generation++;
+        next->count = 0;
+        for (size_t t = 0; t < current->count; t++) {
+            Instruction *inst = &m->program[current->pc[t]];
+            int64_t *saved = &current->saved[t * m->nsaved];
+            if (inst->opcode == CHOICE_Opcode_match) {
+                // Threads after this one have lower priority, so the
+                // matches they might find are never reported.
+                matched = TRUE;
+                memcpy(result, saved, m->nsaved * sizeof(int64_t));
+                break;
+            }
+            if (accepts(m, inst, pos)) {
+                add_thread(m, next, generation, current->pc[t] + 1, saved, pos + 1);
+            }
+        }
+        ThreadList *t = current;
+        current = next;
+        next = t;
+    }
+    free_list(&lists[0]);
+    free_list(&lists[1]);
+    return matched;
+}
+
+static void object_releaseRegexObject(Object *o)
+{
+    if (o != NULL) {
+        assert(o->refcount > 0);
+        o->refcount--;
+        if (o->refcount <= 0) {
+            Program *p = o->ptr;
+            for (size_t i = 0; i < p->size; i++) {
+                free(p->instructions[i].chars);
+                free(p->instructions[i].targets);
+            }
+            free(p->instructions);
+            free(p);
+            free(o);
+        }
+    }
+}
+
+static Cell *object_regexObjectToString(Object *self)
+{
+    (void)self;
+    return cell_fromCString("<REGEX>");
+}
+
+void regex_load(TExecutor *exec)
+{
+    Program *p = checked_malloc(sizeof(Program));
+    p->instructions = decode(top(exec->stack), &p->size, &p->nsaved, &p->nedges);
+    p->nsaved += p->nsaved % 2;
+
+    Object *o = object_createObject();
+    o->ptr = p;
+    o->release = object_releaseRegexObject;
+    o->toString = object_regexObjectToString;
+
+    pop(exec->stack);
+    push(exec->stack, cell_fromObject(o));
+}
+
+void regex_execute(TExecutor *exec)
+{
+    TString *target = peek(exec->stack, 0)->string;
+    Cell *regex = peek(exec->stack, 1);
+
+    // A Regex that was never prepared has no program, and matches nothing.
+    if (regex->type != cObject || regex->object == NULL || regex->object->release != object_releaseRegexObject) {
+        pop(exec->stack);
+        pop(exec->stack);
+        push(exec->stack, cell_createArrayCell(0));
+        return;
+    }
+    Program *p = regex->object->ptr;
+
+    Machine m;
+    m.program = p->instructions;
+    m.size = p->size;
+    m.nsaved = p->nsaved;
+    m.text = checked_malloc((target->length + 1) * sizeof(uint32_t));
+    m.length = 0;
+    for (size_t i = 0; i < target->length; ) {
+        m.text[m.length++] = next_code_point(target, &i);
+    }
+    m.visited = checked_malloc(m.size * sizeof(size_t));
+    for (size_t i = 0; i < m.size; i++) {
+        m.visited[i] = SIZE_MAX;
+    }
+    init_list(&m.stack, p->nedges + 1, m.nsaved);
+    m.tmp = checked_malloc(m.nsaved * sizeof(int64_t));
+
+    int64_t *saved = checked_malloc(m.nsaved * sizeof(int64_t));
+    Cell *r = cell_createArrayCell(0);
+    if (run(&m, saved)) {
+        for (size_t i = 0; i < m.nsaved; i++) {
+            cell_arrayAppendElementPointer(r, cell_fromNumber(number_from_sint64(saved[i])));
+        }
+    }
+
+    free(saved);
+    free(m.tmp);
+    free_list(&m.stack);
+    free(m.visited);
+    free(m.text);
+
+    pop(exec->stack);
+    pop(exec->stack);
+    push(exec->stack, r);
+}
@@ -0,0 +1,9 @@
+#ifndef REGEX_H
+#define REGEX_H
+
+struct tagTExecutor;
+
+void regex_execute(struct tagTExecutor *exec);
+void regex_load(struct tagTExecutor *exec);
+
+#endif
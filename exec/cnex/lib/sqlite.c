@@ -1,6 +1,7 @@
 #include "sqlite.h"
 
 #include <inttypes.h>
+#include <string.h>
 
 #include "assert.h"
 #include "cell.h"
@@ -27,14 +28,94 @@ void sqlite_initModule(void)
 
 
 
-inline static Object *check_database(Cell *pdb)
+// Number of prepared statements kept for each database connection.
+#define STATEMENT_CACHE_SIZE 32
+
+typedef struct tagTCachedStatement {
+    char *sql;
+    sqlite3_stmt *stmt;
+    uint64_t used;
+} CachedStatement;
+
+typedef struct tagTDatabase {
+    sqlite3 *db;
+    CachedStatement statements[STATEMENT_CACHE_SIZE];
+    uint64_t clock;
+} Database;
+
+void object_releaseDatabaseObject(Object *o);
+
+inline static Database *check_database(Cell *pdb)
 {
-    if (pdb->type != cObject || pdb->object == NULL || pdb->object->ptr == NULL) {
+    if (pdb->type != cObject || pdb->object == NULL || pdb->object->release != object_releaseDatabaseObject) {
+        return NULL;
+    }
+    Database *d = pdb->object->ptr;
+    if (d == NULL || d->db == NULL) {
+        return NULL;
+    }
+    return d;
+}
+
+static void finalizeStatements(Database *d)
+{
+    for (int i = 0; i < STATEMENT_CACHE_SIZE; i++) {
+        if (d->statements[i].stmt != NULL) {
+            sqlite3_finalize(d->statements[i].stmt);
+            free(d->statements[i].sql);
+            d->statements[i].stmt = NULL;
+            d->statements[i].sql = NULL;
+        }
+    }
+}
+
+// Return a prepared statement for sql from the cache, preparing it (and
+// evicting the least recently used one) if necessary. The caller never
+// finalizes it, but calls releaseStatement() when done. Raises SqlException
+// and returns NULL on error.
+static sqlite3_stmt *prepareStatement(TExecutor *exec, Database *d, const char *sql)
+{
+    int victim = 0;
+    for (int i = 0; i < STATEMENT_CACHE_SIZE; i++) {
+        if (d->statements[i].stmt != NULL && strcmp(d->statements[i].sql, sql) == 0) {
+            d->statements[i].used = ++d->clock;
+            return d->statements[i].stmt;
+        }
+        if (d->statements[i].used < d->statements[victim].used) {
+            victim = i;
+        }
+    }
+    sqlite3_stmt *stmt;
+    int r = sqlite3_prepare_v2(d->db, sql, -1, &stmt, NULL);
+    if (r != SQLITE_OK) {
+        exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(d->db));
         return NULL;
     }
-    return pdb->object;
+    CachedStatement *c = &d->statements[victim];
+    if (c->stmt != NULL) {
+        sqlite3_finalize(c->stmt);
+        free(c->sql);
+    }
+    size_t n = strlen(sql) + 1;
+    c->sql = malloc(n);
+    if (c->sql == NULL) {
+        fatal_error("Could not alloc SQLite statement text.\n");
+    }
+    memcpy(c->sql, sql, n);
+    c->stmt = stmt;
+    c->used = ++d->clock;
+    return stmt;
 }
 
+// Reset a cached statement so that it holds no locks or parameter data
+// while it is in the cache.
+static void releaseStatement(sqlite3_stmt *stmt)
+{
+    if (stmt != NULL) {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+}
 
 void object_releaseDatabaseObject(Object *o)
 {
@@ -42,10 +123,12 @@ void object_releaseDatabaseObject(Object *o)
         assert(o->refcount > 0);
         o->refcount--;
         if (o->refcount <= 0) {
-            if (o->ptr != NULL) {
-                sqlite3_close_v2(o->ptr);
-                o->ptr = NULL;
+            Database *d = o->ptr;
+            if (d->db != NULL) {
+                finalizeStatements(d);
+                sqlite3_close_v2(d->db);
             }
+            free(d);
             free(o);
         }
     }
@@ -54,15 +137,21 @@ void object_releaseDatabaseObject(Object *o)
 Cell *object_databaseObjectToString(Object *self)
 {
     char s[32];
-    snprintf(s, sizeof(s), "<SQLITE %p>", self->ptr);
+    snprintf(s, sizeof(s), "<SQLITE %p>", (void *)((Database *)self->ptr)->db);
     Cell *r = cell_fromCString(s);
     return r;
 }
 
 Object *object_createDatabaseObject(sqlite3 *db)
 {
+    Database *d = calloc(1, sizeof(Database));
+    if (d == NULL) {
+        fatal_error("Could not alloc SQLite Database.\n");
+    }
+    d->db = db;
+
     Object *r = object_createObject();
-    r->ptr = db;
+    r->ptr = d;
     r->release = object_releaseDatabaseObject;
     r->toString = object_databaseObjectToString;
 
@@ -156,6 +245,126 @@ static int callback(void *rowscell, int columns, char **values, char **names)
 
 
 
+static BOOL bindStrings(TExecutor *exec, Database *d, sqlite3_stmt *stmt, Cell *parameters)
+{
+    // The parameters outlive the statement execution (see releaseStatement),
+    // so they are bound without copying.
+    for (int64_t i = 0; i < parameters->dictionary->len; i++) {
+        DictionaryEntry *p = &parameters->dictionary->data[i];
+        int c = sqlite3_bind_parameter_index(stmt, TCSTR(p->key));
+        if (c == 0) {
+            exec->rtl_raise(exec, "SqliteException.ParameterName", TCSTR(p->key));
+            return FALSE;
+        }
+        int r = sqlite3_bind_text(stmt, c, p->value->string->data, (int)p->value->string->length, SQLITE_STATIC);
+        if (r != SQLITE_OK) {
+            exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(d->db));
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static BOOL bindObjects(TExecutor *exec, Database *d, sqlite3_stmt *stmt, Cell *parameters)
+{
+    for (int64_t i = 0; i < parameters->dictionary->len; i++) {
+        DictionaryEntry *p = &parameters->dictionary->data[i];
+        int c = sqlite3_bind_parameter_index(stmt, TCSTR(p->key));
+        if (c == 0) {
+            exec->rtl_raise(exec, "SqliteException.ParameterName", TCSTR(p->key));
+            return FALSE;
+        }
+        Object *o = p->value->object;
+        int r;
+        if (o == NULL || o->type == oNone) {
+            r = sqlite3_bind_null(stmt, c);
+        } else if (o->type == oNumber) {
+            Number n = ((Cell *)o->ptr)->number;
+            // Integers too big for an int64 are bound as a real instead.
+            if (number_is_integer(n)
+             && number_is_greater_equal(n, number_from_sint64(INT64_MIN))
+             && number_is_less_equal(n, number_from_sint64(INT64_MAX))) {
+                r = sqlite3_bind_int64(stmt, c, number_to_sint64(n));
+            } else {
+                r = sqlite3_bind_double(stmt, c, number_to_double(n));
+            }
+        } else if (o->type == oString) {
+            TString *t = ((Cell *)o->ptr)->string;
+            r = sqlite3_bind_text(stmt, c, t->data, (int)t->length, SQLITE_STATIC);
+        } else if (o->type == oBytes) {
+            TString *t = ((Cell *)o->ptr)->string;
+            r = sqlite3_bind_blob(stmt, c, t->data, (int)t->length, SQLITE_STATIC);
+        } else if (o->type == oBoolean) {
+            r = sqlite3_bind_int(stmt, c, ((Cell *)o->ptr)->boolean);
+        } else {
+            exec->rtl_raise(exec, "SqliteException.ParameterType", TCSTR(p->key));
+            return FALSE;
+        }
+        if (r != SQLITE_OK) {
+            exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(d->db));
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static Cell *columnText(sqlite3_stmt *stmt, int i)
+{
+    const unsigned char *value = sqlite3_column_text(stmt, i);
+    if (value == NULL) {
+        return cell_fromCString("");
+    }
+    return cell_fromStringLength((const char *)value, sqlite3_column_bytes(stmt, i));
+}
+
+static Cell *columnObject(sqlite3_stmt *stmt, int i)
+{
+    switch (sqlite3_column_type(stmt, i)) {
+        case SQLITE_INTEGER:
+            return cell_fromObject(object_createNumberObject(number_from_sint64(sqlite3_column_int64(stmt, i))));
+        case SQLITE_FLOAT:
+            return cell_fromObject(object_createNumberObject(number_from_double(sqlite3_column_double(stmt, i))));
+        case SQLITE_TEXT:
+            return cell_fromObject(object_fromCell(columnText(stmt, i)));
+        case SQLITE_BLOB: {
+            int n = sqlite3_column_bytes(stmt, i);
+            Cell *b = cell_createBytesCell(n);
+            if (n > 0) {
+                memcpy(b->string->data, sqlite3_column_blob(stmt, i), n);
+            }
+            return cell_fromObject(object_fromCell(b));
+        }
+        default:
+            return cell_fromObject(object_createObject());
+    }
+}
+
+// Run a prepared statement to completion, appending each row made by
+// column(stmt, i) to rows (if not NULL).
+static BOOL stepAll(TExecutor *exec, Database *d, sqlite3_stmt *stmt, Cell *(*column)(sqlite3_stmt *, int), Cell *rows)
+{
+    int columns = sqlite3_column_count(stmt);
+    for (;;) {
+        int r = sqlite3_step(stmt);
+        if (r == SQLITE_DONE) {
+            return TRUE;
+        }
+        if (r != SQLITE_ROW) {
+            exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(d->db));
+            return FALSE;
+        }
+        if (rows != NULL) {
+            Cell *row = cell_createArrayCell(0);
+            for (int i = 0; i < columns; i++) {
+                cell_arrayAppendElementPointer(row, column(stmt, i));
+            }
+            cell_arrayAppendElementPointer(rows, row);
+        }
+    }
+}
+
+
+
 void sqlite_open(TExecutor *exec)
 {
     char *name = string_asCString(top(exec->stack)->string); pop(exec->stack);
@@ -191,57 +400,26 @@ void sqlite_exec(TExecutor *exec)
 {
     Cell *parameters = cell_fromCell(top(exec->stack)); pop(exec->stack);
     char *sql = string_asCString(top(exec->stack)->string); pop(exec->stack);
-    Object *db = check_database(top(exec->stack)); pop(exec->stack);
+    Database *db = check_database(top(exec->stack)); pop(exec->stack);
 
     sqlite3_stmt *stmt = NULL;
     if (db == NULL) {
         exec->rtl_raise(exec, "SqliteException.InvalidDatabase", "");
         goto cleanup;
     }
-    Cell *rows = cell_createArrayCell(0);
-    int r = sqlite3_prepare_v2(db->ptr, sql, -1, &stmt, NULL);
-    if (r != SQLITE_OK) {
-        exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->ptr));
+    stmt = prepareStatement(exec, db, sql);
+    if (stmt == NULL || !bindStrings(exec, db, stmt, parameters)) {
         goto cleanup;
     }
-    for (int i = 0; i < parameters->dictionary->len; i++) {
-        int c = sqlite3_bind_parameter_index(stmt, TCSTR(parameters->dictionary->data[i].key));
-        if (c == 0) {
-            exec->rtl_raise(exec, "SqlException.ParameterName", TCSTR(parameters->dictionary->data[i].key));
-            goto cleanup;
-        }
-        r = sqlite3_bind_text(stmt, c, TCSTR(parameters->dictionary->data[i].value->string), -1, SQLITE_TRANSIENT);
-        if (r != SQLITE_OK) {
-            exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->ptr));
-            goto cleanup;
-        }
-    }
-    int columns = sqlite3_column_count(stmt);
-    for (;;) {
-        r = sqlite3_step(stmt);
-        if (r == SQLITE_DONE) {
-            break;
-        }
-        if (r == SQLITE_ROW) {
-            Cell *row = cell_createArrayCell(0);
-            for (int i = 0; i < columns; i++) {
-                const unsigned char *value = sqlite3_column_text(stmt, i);
-                if (value != NULL) {
-                    cell_arrayAppendElementPointer(row, cell_fromCString((const char *)value));
-                } else {
-                    cell_arrayAppendElementPointer(row, cell_fromCString(""));
-                }
-            }
-            cell_arrayAppendElementPointer(rows, row);
-        } else {
-            exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->ptr));
-            goto cleanup;
-        }
+    Cell *rows = cell_createArrayCell(0);
+    if (!stepAll(exec, db, stmt, columnText, rows)) {
+        cell_freeCell(rows);
+        goto cleanup;
     }
     push(exec->stack, rows);
 
 cleanup:
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     free(sql);
     cell_freeCell(parameters);
 }
@@ -250,7 +428,7 @@ void sqlite_execOne(TExecutor *exec)
 {
     Cell *parameters = cell_fromCell(top(exec->stack)); pop(exec->stack);
     char *sql = string_asCString(top(exec->stack)->string); pop(exec->stack);
-    Object *db = check_database(top(exec->stack)); pop(exec->stack);
+    Database *db = check_database(top(exec->stack)); pop(exec->stack);
 
     sqlite3_stmt *stmt = NULL;
 
@@ -258,43 +436,26 @@ void sqlite_execOne(TExecutor *exec)
         exec->rtl_raise(exec, "SqliteException.InvalidDatabase", "");
         goto cleanup;
     }
+    stmt = prepareStatement(exec, db, sql);
+    if (stmt == NULL || !bindStrings(exec, db, stmt, parameters)) {
+        goto cleanup;
+    }
 
     Cell *result = cell_createArrayCell(0);
     BOOL Retval = FALSE;
 
-    int r = sqlite3_prepare_v2(db->ptr, sql, -1, &stmt, NULL);
-    if (r != SQLITE_OK) {
-        exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->ptr));
-        goto cleanup;
-    }
-    for (int i = 0; i < parameters->dictionary->len; i++) {
-        int c = sqlite3_bind_parameter_index(stmt, TCSTR(parameters->dictionary->data[i].key));
-        if (c == 0) {
-            exec->rtl_raise(exec, "SqlException.ParameterName", TCSTR(parameters->dictionary->data[i].key));
-            goto cleanup;
-        }
-        r = sqlite3_bind_text(stmt, c, TCSTR(parameters->dictionary->data[i].value->string), -1, SQLITE_TRANSIENT);
-        if (r != SQLITE_OK) {
-            exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->ptr));
-            goto cleanup;
-        }
-    }
     int columns = sqlite3_column_count(stmt);
-    r = sqlite3_step(stmt);
+    int r = sqlite3_step(stmt);
     if (r == SQLITE_DONE) {
         goto done;
     }
     if (r == SQLITE_ROW) {
         for (int i = 0; i < columns; i++) {
-            const unsigned char *value = sqlite3_column_text(stmt, i);
-            if (value != NULL) {
-                cell_arrayAppendElementPointer(result, cell_fromCString((const char *)value));
-            } else {
-                cell_arrayAppendElementPointer(result, cell_fromCString(""));
-            }
+            cell_arrayAppendElementPointer(result, columnText(stmt, i));
         }
     } else {
-        exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->ptr));
+        exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->db));
+        cell_freeCell(result);
         goto cleanup;
     }
     Retval = TRUE;
@@ -304,7 +465,86 @@ done:
     push(exec->stack, result);
 
 cleanup:
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
+    free(sql);
+    cell_freeCell(parameters);
+}
+
+void sqlite_execTyped(TExecutor *exec)
+{
+    Cell *parameters = cell_fromCell(top(exec->stack)); pop(exec->stack);
+    char *sql = string_asCString(top(exec->stack)->string); pop(exec->stack);
+    Database *db = check_database(top(exec->stack)); pop(exec->stack);
+
+    sqlite3_stmt *stmt = NULL;
+    if (db == NULL) {
+        exec->rtl_raise(exec, "SqliteException.InvalidDatabase", "");
+        goto cleanup;
+    }
+    stmt = prepareStatement(exec, db, sql);
+    if (stmt == NULL || !bindObjects(exec, db, stmt, parameters)) {
+        goto cleanup;
+    }
+    Cell *rows = cell_createArrayCell(0);
+    if (!stepAll(exec, db, stmt, columnObject, rows)) {
+        cell_freeCell(rows);
+        goto cleanup;
+    }
+    push(exec->stack, rows);
+
+cleanup:
+    releaseStatement(stmt);
+    free(sql);
+    cell_freeCell(parameters);
+}
+
+void sqlite_execMany(TExecutor *exec)
+{
+    Cell *parameters = cell_fromCell(top(exec->stack)); pop(exec->stack);
+    char *sql = string_asCString(top(exec->stack)->string); pop(exec->stack);
+    Database *db = check_database(top(exec->stack)); pop(exec->stack);
+
+    sqlite3_stmt *stmt = NULL;
+    BOOL transaction = FALSE;
+    if (db == NULL) {
+        exec->rtl_raise(exec, "SqliteException.InvalidDatabase", "");
+        goto cleanup;
+    }
+    // Use a transaction of our own unless the caller already has one.
+    transaction = sqlite3_get_autocommit(db->db) != 0;
+    if (transaction) {
+        sqlite3_exec(db->db, "BEGIN", NULL, NULL, NULL);
+    }
+    stmt = prepareStatement(exec, db, sql);
+    if (stmt == NULL) {
+        goto rollback;
+    }
+    int64_t changes = 0;
+    for (size_t i = 0; i < parameters->array->size; i++) {
+        releaseStatement(stmt);
+        if (!bindObjects(exec, db, stmt, &parameters->array->data[i]) || !stepAll(exec, db, stmt, columnObject, NULL)) {
+            goto rollback;
+        }
+        changes += sqlite3_changes(db->db);
+    }
+    releaseStatement(stmt);
+    stmt = NULL;
+    if (transaction && sqlite3_exec(db->db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+        exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->db));
+        goto rollback;
+    }
+    push(exec->stack, cell_fromNumber(number_from_sint64(changes)));
+    goto cleanup;
+
+rollback:
+    releaseStatement(stmt);
+    stmt = NULL;
+    if (transaction) {
+        sqlite3_exec(db->db, "ROLLBACK", NULL, NULL, NULL);
+    }
+
+cleanup:
+    releaseStatement(stmt);
     free(sql);
     cell_freeCell(parameters);
 }
@@ -312,7 +552,7 @@ cleanup:
 void sqlite_execRaw(TExecutor *exec)
 {
     char *sql = string_asCString(top(exec->stack)->string); pop(exec->stack);
-    Object *db = check_database(top(exec->stack)); pop(exec->stack);
+    Database *db = check_database(top(exec->stack)); pop(exec->stack);
 
     if (db == NULL) {
         exec->rtl_raise(exec, "SqliteException.InvalidDatabase", "");
@@ -321,9 +561,9 @@ void sqlite_execRaw(TExecutor *exec)
 
     Cell *rows = cell_createArrayCell(0);
     char *errmsg = NULL;
-    int r = sqlite3_exec(db->ptr, sql, callback, rows, &errmsg);
+    int r = sqlite3_exec(db->db, sql, callback, rows, &errmsg);
     if (r != SQLITE_OK) {
-        exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->ptr));
+        exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->db));
         goto cleanup;
     }
 
@@ -335,18 +575,19 @@ cleanup:
 
 void sqlite_close(TExecutor *exec)
 {
-    Object *db = check_database(top(exec->stack)); pop(exec->stack);
+    Database *db = check_database(top(exec->stack)); pop(exec->stack);
 
     if (db == NULL) {
         exec->rtl_raise(exec, "SqliteException.InvalidDatabase", "");
         return;
     }
 
-    int r = sqlite3_close(db->ptr);
+    finalizeStatements(db);
+    int r = sqlite3_close(db->db);
     if (r == SQLITE_OK) {
-        db->ptr = NULL;
+        db->db = NULL;
     } else {
-        exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->ptr));
+        exec->rtl_raise(exec, "SqlException", sqlite3_errmsg(db->db));
     }
 }
 
@@ -354,7 +595,7 @@ void sqlite_cursorDeclare(TExecutor *exec)
 {
     char *query = string_asCString(top(exec->stack)->string); pop(exec->stack);
     TString *name = string_fromString(top(exec->stack)->string); pop(exec->stack);
-    Object *db = check_database(top(exec->stack)); pop(exec->stack);
+    Database *db = check_database(top(exec->stack)); pop(exec->stack);
 
     if (db == NULL) {
         exec->rtl_raise(exec, "SqliteException.InvalidDatabase", "");
@@ -364,10 +605,10 @@ void sqlite_cursorDeclare(TExecutor *exec)
     }
 
     // It is important to note that query will be freed in freeCursor(), so we simply pass it along and don't bother to make a copy of it.
-    Cell *c = cell_createOtherCell(declareCursor(exec, db->ptr, query));
+    Cell *c = cell_createOtherCell(declareCursor(exec, db->db, query));
 
     // It is again, important to note that name is also preserved, as it becomes the active KEY for the dictionary entry, so once again, we pass it along.
-    dictionary_addDictionaryEntry(Cursors, name, c, -1);
+    dictionary_addDictionaryEntry(Cursors, name, c);
 
     push(exec->stack, cell_fromString(name));
 }
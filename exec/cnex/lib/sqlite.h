@@ -10,6 +10,8 @@ void sqlite_open(struct tagTExecutor *exec);
 void sqlite_exec(struct tagTExecutor *exec);
 void sqlite_execOne(struct tagTExecutor *exec);
 void sqlite_execRaw(struct tagTExecutor *exec);
+void sqlite_execTyped(struct tagTExecutor *exec);
+void sqlite_execMany(struct tagTExecutor *exec);
 void sqlite_close(struct tagTExecutor *exec);
 
 void sqlite_cursorDeclare(struct tagTExecutor *exec);
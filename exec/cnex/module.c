@@ -41,6 +41,7 @@ TModule *module_newModule(const char *name)
     r->bytecode = bytecode_newBytecode();
     r->globals = NULL;
     r->predef_cache = NULL;
+    r->number_constants = NULL;
     r->code = NULL;
     r->path_only = NULL;
     r->extension_path = NULL;
@@ -177,6 +178,7 @@ void module_freeModule(TModule *m)
         free(m->extension_path);
     }
     free(m->predef_cache);
+    free(m->number_constants);
     // If our debug_symbols are NULL, it is ok to pass NULL to cJSON_Delete().
     cJSON_Delete(m->debug_symbols);
     free(m->name);
@@ -17,6 +17,9 @@ typedef struct tagTModule {
     struct tagTBytecode *bytecode;
     struct tagTCell *globals;
     PredefinedFunctionPointer *predef_cache;
+    // Numeric literals for PUSHN, indexed by string table entry.  An entry
+    // is converted the first time it is pushed; cNothing means not yet.
+    struct tagTCell *number_constants;
     cJSON *debug_symbols;
 } TModule;
 
@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "slab.h"
 #include "util.h"
 
 TString *string_createCString(const char *s)
@@ -43,10 +44,7 @@ TString *string_createStringFromData(void *data, size_t len)
 
 TString *string_newString(void)
 {
-    TString *c = malloc(sizeof(TString));
-    if (c == NULL) {
-        fatal_error("Failed to allocate new TString object.");
-    }
+    TString *c = slab_alloc(sizeof(TString));
 
     c->data = NULL;
     c->length = 0;
@@ -60,7 +58,7 @@ void string_freeString(TString *s)
         s->data = NULL;
         s->length = 0;
     }
-    free(s);
+    slab_free(s, sizeof(TString));
 }
 
 void string_clearString(TString *s)
@@ -225,7 +223,7 @@ TString *string_appendData(TString *s, char *buf, size_t len)
 void string_resizeString(TString *s, size_t n)
 {
     s->data = realloc(s->data, n);
-    if (s->data == NULL) {
+    if (s->data == NULL && n > 0) {
         fatal_error("Could not resize string to new count of %ld", n);
     }
     s->length = n;
@@ -535,7 +533,7 @@ TString *string_quoteInPlace(TString *s)
     free(s->data);
     s->data = r->data;
     s->length = r->length;
-    free(r);
+    slab_free(r, sizeof(TString));
     return s;
 }
 
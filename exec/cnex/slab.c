@@ -0,0 +1,139 @@
+#include "slab.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+#define SLAB_SIZE       65536
+// Blocks start this far into a slab, past the link to the next slab, so
+// that they keep the alignment malloc() would have given them.
+#define SLAB_HEADER     16
+
+static const size_t size_classes[] = { 16, 32, 48, 64, 80, 96, 112, 128, 192, 256, 384, 512, 768, 1024 };
+#define SIZE_CLASS_COUNT    (sizeof(size_classes) / sizeof(size_classes[0]))
+#define LARGEST_CLASS       1024
+
+typedef struct tagTFreeBlock {
+    struct tagTFreeBlock *next;
+} TFreeBlock;
+
+typedef struct tagTSlab {
+    struct tagTSlab *next;
+} TSlab;
+
+static TFreeBlock *free_lists[SIZE_CLASS_COUNT];
+static TSlab *slabs = NULL;
+static TSlabStatistics statistics;
+
+static size_t size_class(size_t size)
+{
+    if (size <= 128) {
+        return size == 0 ? 0 : (size + 15) / 16 - 1;
+    }
+    size_t c = 8;
+    while (size_classes[c] < size) {
+        c++;
+    }
+    return c;
+}
+
+static void refill(size_t c)
+{
+    TSlab *slab = malloc(SLAB_SIZE);
+    if (slab == NULL) {
+        fatal_error("Could not allocate memory for %zu byte blocks.", size_classes[c]);
+    }
+    statistics.slabs++;
+    slab->next = slabs;
+    slabs = slab;
+
+    size_t block_size = size_classes[c];
+    size_t count = (SLAB_SIZE - SLAB_HEADER) / block_size;
+    unsigned char *p = (unsigned char *)slab + SLAB_HEADER;
+    for (size_t i = 0; i < count; i++) {
+        TFreeBlock *b = (TFreeBlock *)(p + i * block_size);
+        b->next = free_lists[c];
+        free_lists[c] = b;
+    }
+}
+
+void *slab_alloc(size_t size)
+{
+    statistics.allocations++;
+    if (size > LARGEST_CLASS) {
+        statistics.large++;
+        void *p = malloc(size);
+        if (p == NULL) {
+            fatal_error("Could not allocate %zu bytes of memory.", size);
+        }
+        return p;
+    }
+    size_t c = size_class(size);
+    if (free_lists[c] == NULL) {
+        refill(c);
+    }
+    TFreeBlock *b = free_lists[c];
+    free_lists[c] = b->next;
+    return b;
+}
+
+void *slab_realloc(void *p, size_t old_size, size_t new_size)
+{
+    if (p == NULL) {
+        return slab_alloc(new_size);
+    }
+    if (old_size > LARGEST_CLASS && new_size > LARGEST_CLASS) {
+        statistics.allocations++;
+        statistics.large++;
+        void *r = realloc(p, new_size);
+        if (r == NULL) {
+            fatal_error("Could not reallocate %zu bytes of memory.", new_size);
+        }
+        return r;
+    }
+    if (old_size <= LARGEST_CLASS && new_size <= LARGEST_CLASS && size_class(old_size) == size_class(new_size)) {
+        statistics.reuses++;
+        return p;
+    }
+    void *r = slab_alloc(new_size);
+    memcpy(r, p, old_size < new_size ? old_size : new_size);
+    slab_free(p, old_size);
+    return r;
+}
+
+void slab_free(void *p, size_t size)
+{
+    if (p == NULL) {
+        return;
+    }
+    if (size > LARGEST_CLASS) {
+        free(p);
+        return;
+    }
+    size_t c = size_class(size);
+    TFreeBlock *b = p;
+    b->next = free_lists[c];
+    free_lists[c] = b;
+}
+
+void slab_cleanup(void)
+{
+    while (slabs != NULL) {
+        TSlab *next = slabs->next;
+        free(slabs);
+        slabs = next;
+    }
+    memset(free_lists, 0, sizeof(free_lists));
+}
+
+const TSlabStatistics *slab_getStatistics(void)
+{
+    return &statistics;
+}
+
+size_t slab_mallocsAvoided(void)
+{
+    return statistics.allocations + statistics.reuses - statistics.slabs - statistics.large;
+}
@@ -0,0 +1,30 @@
+#ifndef SLAB_H
+#define SLAB_H
+#include <stddef.h>
+
+// Small blocks that cnex allocates and releases constantly (Cells, the
+// headers of strings, arrays and dictionaries, and small array element
+// buffers) come from size-classed slabs instead of malloc().  Each size
+// class keeps a free list of released blocks, and when that runs dry it
+// carves up a new slab obtained with a single malloc() call.  Requests
+// larger than the biggest size class are passed straight to malloc().
+//
+// A block must be released with slab_free() (or resized with
+// slab_realloc()) using the same size it was allocated with.
+
+typedef struct tagTSlabStatistics {
+    size_t allocations;     // Blocks handed out, including resizes that moved.
+    size_t reuses;          // Resizes that fit in the block already held.
+    size_t slabs;           // Slabs obtained from malloc().
+    size_t large;           // Requests too big for a size class.
+} TSlabStatistics;
+
+void *slab_alloc(size_t size);
+void *slab_realloc(void *p, size_t old_size, size_t new_size);
+void slab_free(void *p, size_t size);
+void slab_cleanup(void);
+
+const TSlabStatistics *slab_getStatistics(void);
+size_t slab_mallocsAvoided(void);
+
+#endif
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <string.h>
 
 #include "cell.h"
 #include "nstring.h"
@@ -20,7 +21,7 @@ TStack *createStack(int capacity)
     stack->capacity = capacity;
     stack->top = -1;
     stack->max = -1;
-    stack->data = malloc(stack->capacity * sizeof(Cell *));
+    stack->data = malloc(stack->capacity * sizeof(Cell));
     if (stack->data == NULL) {
         fatal_error("Could not allocate stack memory.");
     }
@@ -58,7 +59,9 @@ void push(TStack *stack, Cell *item)
         stack->max++;
     }
 
-    stack->data[++stack->top] = item;
+    // Move the contents into the slot; the cell that held them is no longer needed.
+    stack->data[++stack->top] = *item;
+    cell_releaseCell(item);
 }
 
 void pop(TStack *stack)
@@ -67,8 +70,7 @@ void pop(TStack *stack)
         fatal_error("Stack underflow error.");
     }
 
-    Cell *p = stack->data[stack->top--];
-    cell_freeCell(p);
+    cell_clearCell(&stack->data[stack->top--]);
 }
 
 Cell *top(TStack *stack)
@@ -77,7 +79,7 @@ Cell *top(TStack *stack)
         fatal_error("Stack underflow error.");
     }
 
-    return stack->data[stack->top];
+    return &stack->data[stack->top];
 }
 
 Cell *peek(TStack *stack, int element)
@@ -86,7 +88,7 @@ Cell *peek(TStack *stack, int element)
         fatal_error("Stack underflow error.");
     }
 
-    return stack->data[stack->top - element];
+    return &stack->data[stack->top - element];
 }
 
 void drop(TStack *stack, int element)
@@ -100,13 +102,9 @@ void drop(TStack *stack, int element)
         fatal_error("Stack underflow error.");
     }
 
-    Cell *p = stack->data[stack->top - element];
-    for (int i = stack->top - element; i < stack->top; i++) {
-        stack->data[i] = stack->data[i+1];
-    }
-    // Clear that stack element.  Not critical, but; proper.
-    stack->data[stack->top--] = NULL;
-    cell_freeCell(p);
+    cell_clearCell(&stack->data[stack->top - element]);
+    memmove(&stack->data[stack->top - element], &stack->data[stack->top - element + 1], element * sizeof(Cell));
+    cell_initCell(&stack->data[stack->top--]);
 }
 
 void dump(TStack* stack)
@@ -2,11 +2,15 @@
 #define STACK_H
 #include <stddef.h>
 
+// The operand stack holds its cells by value, in one contiguous array.
+// push() takes over the contents of the cell it is given and releases
+// the cell itself.  The pointers returned by top() and peek() refer to
+// the stack slots, so they are only valid until that slot is popped.
 typedef struct tagTStack {
     int top;
     int capacity;
     int max;
-    struct tagTCell **data;
+    struct tagTCell *data;
 } TStack;
 
 TStack *createStack(int capacity);
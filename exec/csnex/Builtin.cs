@@ -744,6 +744,21 @@ namespace csnex
             Exec.stack.Push(Cell.CreateNumberCell(n));
         }
 
+        public void string__nextCharacter()
+        {
+            Cell offset = Exec.stack.Pop().Address;
+            Cell addr = Exec.stack.Pop().Address;
+
+            Int32 i = Number.number_to_int32(offset.Number);
+            if (i >= addr.String.Length) {
+                Exec.stack.Push(Cell.CreateStringCell(""));
+                return;
+            }
+            Int32 n = Char.IsSurrogatePair(addr.String, i) ? 2 : 1;
+            offset.Number = new Number(i + n);
+            Exec.stack.Push(Cell.CreateStringCell(addr.String.Substring(i, n)));
+        }
+
         public void string__splice()
         {
             bool last_from_end = Exec.stack.Pop().Boolean;
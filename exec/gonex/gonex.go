@@ -18,6 +18,9 @@ import (
 	"strconv"
 	"strings"
 	"time"
+	"unicode"
+	"unicode/utf16"
+	"unicode/utf8"
 )
 
 const BYTECODE_VERSION int = 3
@@ -1874,6 +1877,118 @@ func (self *executor) op_ind() {
 	self.push(make_cell_bool(found))
 }
 
+// Opcodes of a compiled regex program.
+const (
+	opAny   = 0
+	opChar  = 1
+	opClass = 2
+	opBegin = 3
+	opEnd   = 4
+	opSave  = 5
+	opMatch = 6
+	opJump  = 7
+)
+
+// A compiled regex program and the number of positions it saves, kept in
+// the Regex record so that each match can use it directly.
+type regexProgram struct {
+	program []cell
+	nsaved  int
+}
+
+func regex_load(program []cell) *regexProgram {
+	nsaved := 0
+	for _, op := range program {
+		if int(op.array[0].num) == opSave && int(op.array[1].num)+1 > nsaved {
+			nsaved = int(op.array[1].num) + 1
+		}
+	}
+	nsaved += nsaved % 2
+	return &regexProgram{program, nsaved}
+}
+
+// Run all threads of a compiled regex program together (a Pike VM), in
+// priority order, and return the saved positions if it matches.
+func regex_execute(regex *regexProgram, target []rune) []cell {
+	type thread struct {
+		pc    int
+		saved []int
+	}
+	program := regex.program
+	nsaved := regex.nsaved
+	add := func(threads []thread, visited map[int]bool, pc int, saved []int, pos int) []thread {
+		stack := []thread{{pc, saved}}
+		for len(stack) > 0 {
+			t := stack[len(stack)-1]
+			stack = stack[:len(stack)-1]
+			if t.pc >= len(program) || visited[t.pc] {
+				continue
+			}
+			visited[t.pc] = true
+			op := program[t.pc].array
+			switch int(op[0].num) {
+			case opBegin:
+				if pos == 0 {
+					stack = append(stack, thread{t.pc + 1, t.saved})
+				}
+			case opEnd:
+				if pos >= len(target) {
+					stack = append(stack, thread{t.pc + 1, t.saved})
+				}
+			case opSave:
+				saved := append([]int(nil), t.saved...)
+				saved[int(op[1].num)] = pos
+				stack = append(stack, thread{t.pc + 1, saved})
+			case opJump:
+				for j := len(op[1].array) - 1; j >= 0; j-- {
+					stack = append(stack, thread{int(op[1].array[j].num), t.saved})
+				}
+			default:
+				threads = append(threads, t)
+			}
+		}
+		return threads
+	}
+	accepts := func(op []cell, c rune) bool {
+		switch int(op[0].num) {
+		case opAny:
+			return true
+		case opChar:
+			return string(c) == op[1].str
+		case opClass:
+			_, found := op[1].array[0].dict[string(c)]
+			return found != op[1].array[1].bool
+		}
+		return false
+	}
+	initial := make([]int, nsaved)
+	for i := range initial {
+		initial[i] = -1
+	}
+	current := add(nil, map[int]bool{}, 0, initial, 0)
+	var result []int
+	for pos := 0; len(current) > 0; pos++ {
+		var next []thread
+		visited := map[int]bool{}
+		for _, t := range current {
+			op := program[t.pc].array
+			if int(op[0].num) == opMatch {
+				result = t.saved
+				break
+			}
+			if pos < len(target) && accepts(op, target[pos]) {
+				next = add(next, visited, t.pc+1, t.saved, pos+1)
+			}
+		}
+		current = next
+	}
+	r := []cell{}
+	for _, x := range result {
+		r = append(r, make_cell_num(float64(x)))
+	}
+	return r
+}
+
 func (self *executor) op_callp() {
 	self.ip++
 	val := get_vint(self.module.object.code, &self.ip)
@@ -2508,6 +2623,23 @@ func (self *executor) op_callp() {
 			f.WriteString(s.str + "\n")
 		}
 		self.push(make_cell_array([]cell{make_cell_num(0)})) // ok
+	case "json$decode":
+		s := []rune(self.pop().str)
+		v, i, err := json_decode_part(s, 0)
+		if err == nil {
+			i = json_skip_whitespace(s, i)
+			if i < len(s) {
+				err = &jsonError{"unexpected input after value", i}
+			}
+		}
+		if err != nil {
+			self.push(make_cell_array([]cell{make_cell_num(1), make_cell_array([]cell{make_cell_str(err.message), make_cell_num(float64(err.index))})})) // error
+		} else {
+			self.push(make_cell_array([]cell{make_cell_num(0), make_cell_obj(v)})) // data
+		}
+	case "json$encode":
+		o := self.pop().obj
+		self.push(make_cell_str(json_encode_value(o)))
 	case "math$abs":
 		x := self.pop().num
 		self.push(make_cell_num(math.Abs(x)))
@@ -2876,6 +3008,17 @@ func (self *executor) op_callp() {
 		}
 	case "random$uint32":
 		self.push(make_cell_num(float64(rand.Uint32())))
+	case "regex$execute":
+		target := self.pop().str
+		regex, ok := self.pop().other.(*regexProgram)
+		if !ok {
+			// A Regex that was never prepared has no program, and matches nothing.
+			self.push(make_cell_array([]cell{}))
+			break
+		}
+		self.push(make_cell_array(regex_execute(regex, []rune(target))))
+	case "regex$load":
+		self.push(make_cell_other(regex_load(self.pop().array)))
 	case "runtime$assertionsEnabled":
 		self.push(make_cell_bool(true)) // TODO: enable_assertions
 	case "runtime$debugEnabled":
@@ -2996,6 +3139,18 @@ func (self *executor) op_callp() {
 	case "builtin$string__length":
 		s := self.pop().str
 		self.push(make_cell_num(float64(len(s))))
+	case "builtin$string__nextCharacter":
+		ro := self.pop().ref
+		rs := self.pop().ref
+		s := rs.load().str
+		i := int(ro.load().num)
+		if i >= len(s) {
+			self.push(make_cell_str(""))
+		} else {
+			_, n := utf8.DecodeRuneInString(s[i:])
+			ro.store(make_cell_num(float64(i + n)))
+			self.push(make_cell_str(s[i : i+n]))
+		}
 	case "builtin$string__splice":
 		last_from_end := self.pop().bool
 		last := int(self.pop().num)
@@ -3431,3 +3586,274 @@ func main() {
 	executor := make_executor(os.Args[1], bytes)
 	executor.run()
 }
+
+type jsonError struct {
+	message string
+	index   int
+}
+
+func json_skip_whitespace(s []rune, i int) int {
+	for i < len(s) && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n') {
+		i++
+	}
+	return i
+}
+
+func json_is_digit(s []rune, i int) bool {
+	return i < len(s) && '0' <= s[i] && s[i] <= '9'
+}
+
+// Follows the grammar (and error messages) of the Neon json decoder.
+func json_decode_part(s []rune, i int) (object, int, *jsonError) {
+	i = json_skip_whitespace(s, i)
+	if i >= len(s) {
+		return nil, i, &jsonError{"value expected", i}
+	}
+	switch c := s[i]; {
+	case 'a' <= c && c <= 'z':
+		start := i
+		for i < len(s) && 'a' <= s[i] && s[i] <= 'z' {
+			i++
+		}
+		switch string(s[start:i]) {
+		case "null":
+			return nil, i, nil
+		case "false":
+			return objectBoolean{false}, i, nil
+		case "true":
+			return objectBoolean{true}, i, nil
+		}
+		return nil, i, &jsonError{"null or false or true expected", start}
+	case c == '-' || ('0' <= c && c <= '9'):
+		start := i
+		if s[i] == '-' {
+			i++
+		}
+		if i < len(s) && s[i] == '0' {
+			i++
+		} else {
+			if !json_is_digit(s, i) {
+				return nil, i, &jsonError{"digit expected", start}
+			}
+			for json_is_digit(s, i) {
+				i++
+			}
+		}
+		if i < len(s) && s[i] == '.' {
+			i++
+			if !json_is_digit(s, i) {
+				return nil, i, &jsonError{"digit expected", start}
+			}
+			for json_is_digit(s, i) {
+				i++
+			}
+		}
+		if i < len(s) && (s[i] == 'e' || s[i] == 'E') {
+			i++
+			if i < len(s) && (s[i] == '+' || s[i] == '-') {
+				i++
+			}
+			if !json_is_digit(s, i) {
+				return nil, i, &jsonError{"digit expected", start}
+			}
+			for json_is_digit(s, i) {
+				i++
+			}
+		}
+		n, err := strconv.ParseFloat(string(s[start:i]), 64)
+		if err != nil {
+			return nil, i, &jsonError{"number format error", 0}
+		}
+		return objectNumber{n}, i, nil
+	case c == '"':
+		i++
+		var r []rune
+		for i < len(s) && s[i] != '"' {
+			if s[i] < 0x20 {
+				return nil, i, &jsonError{"invalid character", i}
+			}
+			if s[i] == '\\' {
+				i++
+				if i >= len(s) {
+					break
+				}
+				switch s[i] {
+				case '"', '\\', '/':
+					r = append(r, s[i])
+				case 'b':
+					r = append(r, '\b')
+				case 'f':
+					r = append(r, '\f')
+				case 'n':
+					r = append(r, '\n')
+				case 'r':
+					r = append(r, '\r')
+				case 't':
+					r = append(r, '\t')
+				case 'u':
+					var u rune
+					for j := 1; j <= 4; j++ {
+						if i+j >= len(s) {
+							return nil, i, &jsonError{"invalid hex character", i + j}
+						}
+						d := s[i+j]
+						switch {
+						case '0' <= d && d <= '9':
+							u = u*16 + d - '0'
+						case 'a' <= d && d <= 'f':
+							u = u*16 + d - 'a' + 10
+						case 'A' <= d && d <= 'F':
+							u = u*16 + d - 'A' + 10
+						default:
+							return nil, i, &jsonError{"invalid hex character", i + j}
+						}
+					}
+					// Combine surrogate pairs, and replace any that are left alone.
+					if n := len(r); n > 0 && utf16.IsSurrogate(r[n-1]) && 0xdc00 <= u && u < 0xe000 {
+						r[n-1] = utf16.DecodeRune(r[n-1], u)
+					} else {
+						r = append(r, u)
+					}
+					i += 4
+				default:
+					return nil, i, &jsonError{"invalid escape sequence", i}
+				}
+			} else {
+				r = append(r, s[i])
+			}
+			i++
+		}
+		if i >= len(s) {
+			return nil, i, &jsonError{"missing trailing quote", i}
+		}
+		for j, x := range r {
+			if utf16.IsSurrogate(x) {
+				r[j] = unicode.ReplacementChar
+			}
+		}
+		return objectString{string(r)}, i + 1, nil
+	case c == '[':
+		i = json_skip_whitespace(s, i+1)
+		a := []object{}
+		if i < len(s) && s[i] == ']' {
+			return objectArray{a}, i + 1, nil
+		}
+		for {
+			v, j, err := json_decode_part(s, i)
+			if err != nil {
+				return nil, j, err
+			}
+			a = append(a, v)
+			i = json_skip_whitespace(s, j)
+			if i < len(s) && s[i] == ',' {
+				i++
+			} else if i < len(s) && s[i] == ']' {
+				return objectArray{a}, i + 1, nil
+			} else {
+				return nil, i, &jsonError{", or ] expected", i}
+			}
+		}
+	case c == '{':
+		i = json_skip_whitespace(s, i+1)
+		d := make(map[string]object)
+		if i < len(s) && s[i] == '}' {
+			return objectDictionary{d}, i + 1, nil
+		}
+		for {
+			k, j, err := json_decode_part(s, i)
+			if err != nil {
+				return nil, j, err
+			}
+			key, ok := k.(objectString)
+			if !ok {
+				return nil, j, &jsonError{"string key expected", j}
+			}
+			i = json_skip_whitespace(s, j)
+			if i >= len(s) || s[i] != ':' {
+				return nil, i, &jsonError{": expected", i}
+			}
+			v, j, err := json_decode_part(s, i+1)
+			if err != nil {
+				return nil, j, err
+			}
+			d[key.str] = v
+			i = json_skip_whitespace(s, j)
+			if i < len(s) && s[i] == ',' {
+				i++
+			} else if i < len(s) && s[i] == '}' {
+				return objectDictionary{d}, i + 1, nil
+			} else {
+				return nil, i, &jsonError{", or } expected", i}
+			}
+		}
+	}
+	return nil, i, &jsonError{"value expected", i}
+}
+
+func json_encode_string(s string) string {
+	var r strings.Builder
+	r.WriteByte('"')
+	for _, c := range s {
+		switch c {
+		case '"':
+			r.WriteString("\\\"")
+		case '\\':
+			r.WriteString("\\\\")
+		case '\b':
+			r.WriteString("\\b")
+		case '\f':
+			r.WriteString("\\f")
+		case '\n':
+			r.WriteString("\\n")
+		case '\r':
+			r.WriteString("\\r")
+		case '\t':
+			r.WriteString("\\t")
+		default:
+			if c < 0x20 {
+				fmt.Fprintf(&r, "\\u%04x", c)
+			} else {
+				r.WriteRune(c)
+			}
+		}
+	}
+	r.WriteByte('"')
+	return r.String()
+}
+
+func json_encode_value(o object) string {
+	switch v := o.(type) {
+	case nil:
+		return "null"
+	case objectBoolean:
+		if v.bool {
+			return "true"
+		}
+		return "false"
+	case objectNumber:
+		if v.num == 0 {
+			return "0"
+		}
+		return fmt.Sprintf("%v", v.num)
+	case objectString:
+		return json_encode_string(v.str)
+	case objectArray:
+		r := make([]string, len(v.array))
+		for i, x := range v.array {
+			r[i] = json_encode_value(x)
+		}
+		return "[" + strings.Join(r, ",") + "]"
+	case objectDictionary:
+		keys := make([]string, 0, len(v.dict))
+		for k := range v.dict {
+			keys = append(keys, k)
+		}
+		sort.Strings(keys)
+		r := make([]string, len(keys))
+		for i, k := range keys {
+			r[i] = json_encode_string(k) + ":" + json_encode_value(v.dict[k])
+		}
+		return "{" + strings.Join(r, ",") + "}"
+	}
+	return "?unknown"
+}
@@ -93,6 +93,7 @@ class Executor {
         predefined.put("builtin$string__concat", this::string__concat);
         predefined.put("builtin$string__index", this::string__index);
         predefined.put("builtin$string__length", this::string__length);
+        predefined.put("builtin$string__nextCharacter", this::string__nextCharacter);
         predefined.put("builtin$string__substring", this::string__substring);
         predefined.put("builtin$string__encodeUTF8", this::string__encodeUTF8);
         predefined.put("builtin$string__toString", this::string__toString);
@@ -1913,6 +1914,21 @@ class Executor {
         stack.addFirst(new Cell(BigDecimal.valueOf(s.length())));
     }
 
+    private void string__nextCharacter()
+    {
+        Cell offset = stack.removeFirst().getAddress();
+        Cell a = stack.removeFirst().getAddress();
+        String s = a.getString();
+        int i = offset.getNumber().intValue();
+        if (i >= s.length()) {
+            stack.addFirst(new Cell(""));
+            return;
+        }
+        int n = Character.charCount(s.codePointAt(i));
+        offset.set(BigDecimal.valueOf(i + n));
+        stack.addFirst(new Cell(s.substring(i, i + n)));
+    }
+
     private void string__substring()
     {
         boolean last_from_end = stack.removeFirst().getBoolean();
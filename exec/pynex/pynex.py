@@ -40,7 +40,32 @@ g_ExtensionModules = {}
 
 class Ne_Cell:
     def __init__(self, value=None):
+        self.buffer = None
+        self.text = False
         self.value = value
+    # After cell_resize_string or cell_resize_bytes, the extension writes
+    # into a ctypes buffer owned by the cell, so the value is taken from
+    # that buffer until the cell is next assigned.
+    @property
+    def value(self):
+        if self.buffer is not None:
+            data = self.buffer.raw[:len(self.buffer) - 1]
+            return data.decode() if self.text else data
+        return self._value
+    @value.setter
+    def value(self, value):
+        self.buffer = None
+        self._value = value
+    def resize(self, size, text):
+        data = self.value
+        if data is None:
+            data = b""
+        elif text:
+            data = data.encode()
+        self.value = None
+        self.buffer = ctypes.create_string_buffer(data[:size], size + 1)
+        self.text = text
+        return ctypes.addressof(self.buffer)
     def __repr__(self):
         return "Ne_Cell({})".format(repr(self.value))
 
@@ -156,6 +181,26 @@ def Ne_cell_set_dictionary_cell(cell, key):
         cell.value[key.decode()] = r
     return r
 
+def Ne_cell_get_string_size(cell):
+    return len(cell.value.encode())
+
+def Ne_cell_resize_string(cell, size):
+    return cell.resize(size, True)
+
+def Ne_cell_resize_bytes(cell, size):
+    return cell.resize(size, False)
+
+def Ne_cell_get_dictionary_entry(cell, n, value):
+    if cell.value is None:
+        cell.value = {}
+    keys = sorted(cell.value)
+    if not 0 <= n < len(keys):
+        return None
+    key = keys[n]
+    if value:
+        ctypes.cast(value, ctypes.POINTER(ctypes.py_object))[0] = cell.value[key]
+    return key.encode()
+
 def Ne_exec_callback(callback, params, retval):
     assert False
 
@@ -198,6 +243,11 @@ NeMethodThunks = [
 
     ctypes.CFUNCTYPE(None, ctypes.py_object, ctypes.py_object, ctypes.py_object)(Ne_exec_callback),
     ctypes.CFUNCTYPE(ctypes.c_int, ctypes.py_object, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int)(Ne_raise_exception),
+
+    ctypes.CFUNCTYPE(ctypes.c_int, ctypes.py_object)(Ne_cell_get_string_size),
+    ctypes.CFUNCTYPE(ctypes.c_void_p, ctypes.py_object, ctypes.c_int)(Ne_cell_resize_string),
+    ctypes.CFUNCTYPE(ctypes.c_void_p, ctypes.py_object, ctypes.c_int)(Ne_cell_resize_bytes),
+    ctypes.CFUNCTYPE(ctypes.c_char_p, ctypes.py_object, ctypes.c_int, ctypes.c_void_p)(Ne_cell_get_dictionary_entry),
 ]
 
 NeMethodTable = b"".join(bytes(x) if x is not None else bytearray([0] * 8) for x in NeMethodThunks)
@@ -2281,6 +2331,16 @@ def neon_builtin_string__length(self):
     s = self.stack.pop()
     self.stack.append(len(s))
 
+def neon_builtin_string__nextCharacter(self):
+    offset = self.stack.pop()
+    r = self.stack.pop()
+    i = int(offset.value)
+    if i >= len(r.value):
+        self.stack.append("")
+        return
+    offset.value = i + 1
+    self.stack.append(r.value[i])
+
 def neon_builtin_string__splice(self):
     last_from_end = self.stack.pop()
     last = int(self.stack.pop())
@@ -2543,6 +2603,159 @@ def neon_io_write(self):
     f = self.stack.pop()
     f.write(s.encode())
 
+class JsonError(Exception):
+    def __init__(self, message, index):
+        self.message = message
+        self.index = index
+
+def json_skip_whitespace(s, i):
+    while i < len(s) and s[i] in " \t\r\n":
+        i += 1
+    return i
+
+def json_decode_part(s, i):
+    # Follows the grammar (and error messages) of the Neon json decoder.
+    i = json_skip_whitespace(s, i)
+    if i >= len(s):
+        raise JsonError("value expected", i)
+    c = s[i]
+    if "a" <= c <= "z":
+        start = i
+        while i < len(s) and "a" <= s[i] <= "z":
+            i += 1
+        t = s[start:i]
+        if t == "null":
+            return None, i
+        if t == "false":
+            return False, i
+        if t == "true":
+            return True, i
+        raise JsonError("null or false or true expected", start)
+    if c == "-" or "0" <= c <= "9":
+        m = re.compile(r"-?(0|[1-9][0-9]*)?(\.[0-9]*)?([eE][+-]?[0-9]*)?").match(s, i)
+        if m.group(1) is None or m.group(2) == "." or (m.group(3) is not None and not m.group(3)[-1].isdigit()):
+            raise JsonError("digit expected", i)
+        e = m.end()
+        return decimal.Decimal(m.group(0)), e
+    if c == '"':
+        i += 1
+        r = []
+        while i < len(s) and s[i] != '"':
+            if ord(s[i]) < 0x20:
+                raise JsonError("invalid character", i)
+            if s[i] == "\\":
+                i += 1
+                if i >= len(s):
+                    break
+                e = s[i]
+                if e in "\"\\/":
+                    r.append(e)
+                elif e in "bfnrt":
+                    r.append({"b": "\b", "f": "\f", "n": "\n", "r": "\r", "t": "\t"}[e])
+                elif e == "u":
+                    for j in range(1, 5):
+                        if i+j >= len(s) or s[i+j] not in "0123456789abcdefABCDEF":
+                            raise JsonError("invalid hex character", i+j)
+                    r.append(chr(int(s[i+1:i+5], 16)))
+                    i += 4
+                else:
+                    raise JsonError("invalid escape sequence", i)
+            else:
+                r.append(s[i])
+            i += 1
+        if i >= len(s):
+            raise JsonError("missing trailing quote", i)
+        t = "".join(r)
+        # Combine surrogate pairs, and replace any that are left alone.
+        t = t.encode("utf-16", "surrogatepass").decode("utf-16", "replace")
+        return t, i + 1
+    if c == "[":
+        i = json_skip_whitespace(s, i + 1)
+        a = []
+        if i < len(s) and s[i] == "]":
+            return a, i + 1
+        while True:
+            v, i = json_decode_part(s, i)
+            a.append(Value(v))
+            i = json_skip_whitespace(s, i)
+            if i < len(s) and s[i] == ",":
+                i += 1
+            elif i < len(s) and s[i] == "]":
+                return a, i + 1
+            else:
+                raise JsonError(", or ] expected", i)
+    if c == "{":
+        i = json_skip_whitespace(s, i + 1)
+        d = {}
+        if i < len(s) and s[i] == "}":
+            return d, i + 1
+        while True:
+            k, i = json_decode_part(s, i)
+            if not isinstance(k, str):
+                raise JsonError("string key expected", i)
+            i = json_skip_whitespace(s, i)
+            if i >= len(s) or s[i] != ":":
+                raise JsonError(": expected", i)
+            v, i = json_decode_part(s, i + 1)
+            d[k] = Value(v)
+            i = json_skip_whitespace(s, i)
+            if i < len(s) and s[i] == ",":
+                i += 1
+            elif i < len(s) and s[i] == "}":
+                return d, i + 1
+            else:
+                raise JsonError(", or } expected", i)
+    raise JsonError("value expected", i)
+
+def json_encode_string(s):
+    r = ['"']
+    for c in s:
+        if c == '"' or c == "\\":
+            r.append("\\" + c)
+        elif c in "\b\f\n\r\t":
+            r.append({"\b": "\\b", "\f": "\\f", "\n": "\\n", "\r": "\\r", "\t": "\\t"}[c])
+        elif ord(c) < 0x20:
+            r.append("\\u{:04x}".format(ord(c)))
+        else:
+            r.append(c)
+    r.append('"')
+    return "".join(r)
+
+def json_encode_value(v):
+    if v is None:
+        return "null"
+    if v is True or v is False:
+        return "true" if v else "false"
+    if isinstance(v, (int, decimal.Decimal)):
+        if v == 0:
+            return "0"
+        s = format(decimal.Decimal(v), "f")
+        if "." in s:
+            s = s.rstrip("0").rstrip(".")
+        return s
+    if isinstance(v, str):
+        return json_encode_string(v)
+    if isinstance(v, list):
+        return "[" + ",".join(json_encode_value(x.value) for x in v) + "]"
+    if isinstance(v, dict):
+        return "{" + ",".join(json_encode_string(k) + ":" + json_encode_value(x.value) for k, x in sorted(v.items())) + "}"
+    return "?unknown"
+
+def neon_json_decode(self):
+    s = self.stack.pop()
+    try:
+        v, i = json_decode_part(s, 0)
+        i = json_skip_whitespace(s, i)
+        if i < len(s):
+            raise JsonError("unexpected input after value", i)
+        self.stack.append([Value(0), Value(v)]) # data
+    except JsonError as e:
+        self.stack.append([Value(1), Value([Value(e.message), Value(e.index)])]) # error
+
+def neon_json_encode(self):
+    v = self.stack.pop()
+    self.stack.append(json_encode_value(v))
+
 def neon_math_abs(self):
     x = self.stack.pop()
     self.stack.append(abs(x))
@@ -2872,6 +3085,88 @@ def neon_random_bytes(self):
 def neon_random_uint32(self):
     self.stack.append(random.randrange(0x100000000))
 
+class RegexProgram:
+    def __init__(self, program):
+        # Each instruction is decoded to (kind, argument).
+        self.program = []
+        self.nsaved = 0
+        for op in program:
+            kind = op[0].value
+            arg = None
+            if kind == 1: # char
+                arg = op[1].value
+            elif kind == 2: # class
+                cls = op[1].value
+                arg = (set(cls[0].value), cls[1].value)
+            elif kind == 5: # save
+                arg = int(op[1].value)
+                self.nsaved = max(self.nsaved, arg + 1)
+            elif kind == 7: # jump
+                arg = [int(j.value) for j in reversed(op[1].value)]
+            self.program.append((kind, arg))
+        self.nsaved += self.nsaved % 2
+
+def neon_regex_load(self):
+    self.stack.append(RegexProgram([x.value for x in self.stack.pop()]))
+
+def neon_regex_execute(self):
+    # Run all threads of the program together (a Pike VM), in priority order.
+    target = self.stack.pop()
+    regex = self.stack.pop()
+    if not isinstance(regex, RegexProgram):
+        # A Regex that was never prepared has no program, and matches nothing.
+        self.stack.append([])
+        return
+    program = regex.program
+    def add(threads, visited, pc, saved, pos):
+        stack = [(pc, saved)]
+        while stack:
+            pc, saved = stack.pop()
+            if pc >= len(program) or pc in visited:
+                continue
+            visited.add(pc)
+            kind, arg = program[pc]
+            if kind == 3: # begin
+                if pos == 0:
+                    stack.append((pc + 1, saved))
+            elif kind == 4: # end
+                if pos >= len(target):
+                    stack.append((pc + 1, saved))
+            elif kind == 5: # save
+                saved = list(saved)
+                saved[arg] = pos
+                stack.append((pc + 1, saved))
+            elif kind == 7: # jump
+                for j in arg:
+                    stack.append((j, saved))
+            else:
+                threads.append((pc, saved))
+    def accepts(kind, arg, c):
+        if kind == 0: # any
+            return True
+        if kind == 1: # char
+            return c == arg
+        if kind == 2: # class
+            return (c in arg[0]) != arg[1]
+        return False
+    current = []
+    add(current, set(), 0, [-1] * regex.nsaved, 0)
+    result = []
+    pos = 0
+    while current:
+        following = []
+        visited = set()
+        for pc, saved in current:
+            kind, arg = program[pc]
+            if kind == 6: # match
+                result = saved
+                break
+            if pos < len(target) and accepts(kind, arg, target[pos]):
+                add(following, visited, pc + 1, saved, pos + 1)
+        current = following
+        pos += 1
+    self.stack.append([Value(x) for x in result])
+
 def neon_runtime_assertionsEnabled(self):
     self.stack.append(Value(enable_assert))
 
@@ -2974,6 +3269,60 @@ def neon_sqlite_execRaw(self):
     cur.close()
     self.stack.append(r)
 
+def sqlite_typed_parameters(params):
+    r = {}
+    for k, v in params.items():
+        x = v.value
+        if isinstance(x, decimal.Decimal):
+            x = int(x) if x == x.to_integral_value() else float(x)
+        # Integers too big for an int64 are bound as a real instead.
+        if isinstance(x, int) and not -2**63 <= x < 2**63:
+            x = float(x)
+        r[k[1:]] = x
+    return r
+
+def sqlite_typed_column(x):
+    if isinstance(x, (int, float)):
+        return decimal.Decimal(str(x))
+    return x
+
+def neon_sqlite_execMany(self):
+    params = self.stack.pop()
+    sql = self.stack.pop()
+    db = self.stack.pop()
+    # Use a transaction of our own unless the caller already has one.
+    transaction = not db.in_transaction
+    changes = 0
+    try:
+        if transaction:
+            db.execute("BEGIN")
+        for p in params:
+            cur = db.execute(sql, sqlite_typed_parameters(p.value))
+            changes += max(cur.rowcount, 0)
+            cur.close()
+        if transaction:
+            db.commit()
+    except sqlite3.ProgrammingError as e:
+        if transaction:
+            db.rollback()
+        self.raise_literal("SqliteException.ParameterName", str(e))
+        return
+    self.stack.append(decimal.Decimal(changes))
+
+def neon_sqlite_execTyped(self):
+    params = self.stack.pop()
+    sql = self.stack.pop()
+    db = self.stack.pop()
+    cur = db.execute(sql, sqlite_typed_parameters(params))
+    r = []
+    while True:
+        row = cur.fetchone()
+        if row is None:
+            break
+        r.append(Value([Value(sqlite_typed_column(x)) for x in row]))
+    cur.close()
+    self.stack.append(r)
+
 def neon_sqlite_open(self):
     fn = self.stack.pop()
     r = sqlite3.connect(fn)
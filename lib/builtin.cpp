@@ -51,19 +51,19 @@ Number array__find(Cell &self, Cell &element)
     return number_from_uint64(std::distance(a.begin(), i));
 }
 
-std::vector<Number> array__range(Number first, Number last, Number step)
+std::vector<Cell> array__range(Number first, Number last, Number step)
 {
-    std::vector<Number> r;
+    std::vector<Cell> r;
     if (number_is_zero(step)) {
         throw PanicException(utf8string(number_to_string(step)));
     }
     if (number_is_negative(step)) {
         for (Number i = first; number_is_greater_equal(i, last); i = number_add(i, step)) {
-            r.push_back(i);
+            r.push_back(Cell(i));
         }
     } else {
         for (Number i = first; number_is_less_equal(i, last); i = number_add(i, step)) {
-            r.push_back(i);
+            r.push_back(Cell(i));
         }
     }
     return r;
@@ -159,7 +159,7 @@ Cell array__splice(Cell &b, Cell &a, Number first, bool first_from_end, Number l
     return Cell(r);
 }
 
-std::vector<unsigned char> array__toBytes__number(const std::vector<Number> &a)
+std::vector<unsigned char> array__toBytes__number(ArrayView<Number> a)
 {
     std::vector<unsigned char> r;
     r.reserve(a.size());
@@ -173,7 +173,7 @@ std::vector<unsigned char> array__toBytes__number(const std::vector<Number> &a)
     return r;
 }
 
-utf8string array__toString__number(const std::vector<Number> &a)
+utf8string array__toString__number(ArrayView<Number> a)
 {
     utf8string r {"["};
     for (Number x: a) {
@@ -186,10 +186,10 @@ utf8string array__toString__number(const std::vector<Number> &a)
     return r;
 }
 
-utf8string array__toString__string(const std::vector<utf8string> &a)
+utf8string array__toString__string(ArrayView<utf8string> a)
 {
     utf8string r {"["};
-    for (utf8string x: a) {
+    for (const utf8string &x: a) {
         if (r.length() > 1) {
             r.append(", ");
         }
@@ -199,14 +199,14 @@ utf8string array__toString__string(const std::vector<utf8string> &a)
     return r;
 }
 
-utf8string array__toString__object(std::vector<std::shared_ptr<Object>> a)
+utf8string array__toString__object(ArrayView<std::shared_ptr<Object>> a)
 {
     utf8string r {"["};
-    for (auto &x: a) {
+    for (auto x: a) {
         if (r.length() > 1) {
             r.append(", ");
         }
-        r.append(x->toLiteralString());
+        r.append(x != nullptr ? x->toLiteralString() : utf8string("null"));
     }
     r.append("]");
     return r;
@@ -222,11 +222,12 @@ Number dictionary__size(Cell &self)
     return number_from_uint64(self.dictionary().size());
 }
 
-std::vector<utf8string> dictionary__keys(Cell &self)
+std::vector<Cell> dictionary__keys(Cell &self)
 {
-    std::vector<utf8string> r;
-    for (auto d: self.dictionary()) {
-        r.push_back(d.first);
+    std::vector<Cell> r;
+    r.reserve(self.dictionary().size());
+    for (auto &d: self.dictionary()) {
+        r.push_back(Cell(d.first));
     }
     return r;
 }
@@ -276,7 +277,7 @@ utf8string dictionary__toString__object(std::map<utf8string, std::shared_ptr<Obj
         }
         r.append(rtl::ne_string::quoted(e.first));
         r.append(": ");
-        r.append(e.second->toLiteralString());
+        r.append(e.second != nullptr ? e.second->toLiteralString() : utf8string("null"));
     }
     r.append("}");
     return r;
@@ -314,6 +315,22 @@ Number string__length(const utf8string &self)
     return number_from_uint64(self.length());
 }
 
+utf8string string__nextCharacter(utf8string *self, Number *offset)
+{
+    // The offset is a byte offset into the string, so that stepping
+    // through the string does not need to count characters from the start.
+    const std::string &s = self->str();
+    size_t i = number_to_uint64(*offset);
+    if (i >= s.size()) {
+        return utf8string();
+    }
+    auto start = s.begin() + i;
+    auto end = start;
+    utf8::advance(end, 1, s.end());
+    *offset = number_from_uint64(end - s.begin());
+    return utf8string(std::string(start, end));
+}
+
 utf8string string__splice(const utf8string &t, const utf8string &s, Number first, bool first_from_end, Number last, bool last_from_end)
 {
     // TODO: utf8
@@ -507,11 +524,12 @@ void bytes__store(Number b, std::vector<unsigned char> *s, Number index)
     s->at(i) = bb;
 }
 
-std::vector<Number> bytes__toArray(const std::vector<unsigned char> &self)
+std::vector<Cell> bytes__toArray(const std::vector<unsigned char> &self)
 {
-    std::vector<Number> r;
+    std::vector<Cell> r;
+    r.reserve(self.size());
     for (auto x: self) {
-        r.push_back(number_from_uint8(x));
+        r.push_back(Cell(number_from_uint8(x)));
     }
     return r;
 }
@@ -582,9 +600,14 @@ std::shared_ptr<Object> object__makeBytes(const std::vector<unsigned char> &b)
     return std::shared_ptr<Object>(new ObjectBytes(b));
 }
 
-std::shared_ptr<Object> object__makeArray(std::vector<std::shared_ptr<Object>> a)
+std::shared_ptr<Object> object__makeArray(ArrayView<std::shared_ptr<Object>> a)
 {
-    return std::shared_ptr<Object>(new ObjectArray(a));
+    std::vector<std::shared_ptr<Object>> r;
+    r.reserve(a.size());
+    for (auto x: a) {
+        r.push_back(x);
+    }
+    return std::shared_ptr<Object>(new ObjectArray(std::move(r)));
 }
 
 std::shared_ptr<Object> object__makeDictionary(std::map<utf8string, std::shared_ptr<Object>> d)
@@ -628,12 +651,17 @@ std::vector<unsigned char> object__getBytes(const std::shared_ptr<Object> &obj)
     return r;
 }
 
-std::vector<std::shared_ptr<Object>> object__getArray(const std::shared_ptr<Object> &obj)
+std::vector<Cell> object__getArray(const std::shared_ptr<Object> &obj)
 {
-    std::vector<std::shared_ptr<Object>> r;
-    if (obj == nullptr || not obj->getArray(r)) {
+    std::vector<std::shared_ptr<Object>> a;
+    if (obj == nullptr || not obj->getArray(a)) {
         throw RtlException(ne_global::Exception_DynamicConversionException, utf8string("to Array"));
     }
+    std::vector<Cell> r;
+    r.reserve(a.size());
+    for (auto &x: a) {
+        r.push_back(Cell(x));
+    }
     return r;
 }
 
@@ -651,11 +679,16 @@ bool object__isNull(const std::shared_ptr<Object> &obj)
     return obj == nullptr;
 }
 
-std::shared_ptr<Object> object__invokeMethod(const std::shared_ptr<Object> &obj, const utf8string &name, std::vector<std::shared_ptr<Object>> args)
+std::shared_ptr<Object> object__invokeMethod(const std::shared_ptr<Object> &obj, const utf8string &name, ArrayView<std::shared_ptr<Object>> params)
 {
     if (obj == nullptr) {
         throw RtlException(ne_global::Exception_DynamicConversionException, utf8string("object is null"));
     }
+    std::vector<std::shared_ptr<Object>> args;
+    args.reserve(params.size());
+    for (auto x: params) {
+        args.push_back(x);
+    }
     std::shared_ptr<Object> result;
     if (not obj->invokeMethod(name, args, result)) {
         throw RtlException(ne_global::Exception_DynamicConversionException, utf8string("object does not support calling methods"));
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "neonext.h"
 
@@ -81,6 +82,53 @@ Ne_EXPORT int Ne_funcArraySize(struct Ne_Cell *retval, struct Ne_ParameterList *
     return Ne_SUCCESS;
 }
 
+Ne_EXPORT int Ne_funcBytesReverse(struct Ne_Cell *retval, struct Ne_ParameterList *in_params, struct Ne_ParameterList *out_params)
+{
+    const struct Ne_Cell *b = Ne->parameterlist_get_cell(in_params, 0);
+    const unsigned char *p = Ne->cell_get_bytes(b);
+    int n = Ne->cell_get_bytes_size(b);
+    unsigned char *r = Ne->cell_resize_bytes(retval, n);
+    for (int i = 0; i < n; i++) {
+        r[i] = p[n-1-i];
+    }
+    return Ne_SUCCESS;
+}
+
+Ne_EXPORT int Ne_funcStringRepeat(struct Ne_Cell *retval, struct Ne_ParameterList *in_params, struct Ne_ParameterList *out_params)
+{
+    const char *s = Ne->cell_get_string(Ne->parameterlist_get_cell(in_params, 0));
+    int len = Ne->cell_get_string_size(Ne->parameterlist_get_cell(in_params, 0));
+    int count = Ne->cell_get_number_int(Ne->parameterlist_get_cell(in_params, 1));
+    char *r = Ne->cell_resize_string(retval, len * count);
+    for (int i = 0; i < count; i++) {
+        memcpy(r + i * len, s, len);
+    }
+    return Ne_SUCCESS;
+}
+
+Ne_EXPORT int Ne_funcDictionaryKeys(struct Ne_Cell *retval, struct Ne_ParameterList *in_params, struct Ne_ParameterList *out_params)
+{
+    const struct Ne_Cell *d = Ne->parameterlist_get_cell(in_params, 0);
+    int n = Ne->cell_get_dictionary_size(d);
+    int total = 0;
+    for (int i = 0; i < n; i++) {
+        const struct Ne_Cell *value;
+        const char *key = Ne->cell_get_dictionary_entry(d, i, &value);
+        Ne->cell_set_number_int(Ne->cell_set_array_cell(retval, i), Ne->cell_get_number_int(value));
+        total += (int)strlen(key);
+    }
+    Ne->cell_set_number_int(Ne->parameterlist_set_cell(out_params, 0), total);
+    return Ne_SUCCESS;
+}
+
+Ne_EXPORT int Ne_funcDictionaryHasEntry(struct Ne_Cell *retval, struct Ne_ParameterList *in_params, struct Ne_ParameterList *out_params)
+{
+    const struct Ne_Cell *d = Ne->parameterlist_get_cell(in_params, 0);
+    int n = Ne->cell_get_number_int(Ne->parameterlist_get_cell(in_params, 1));
+    Ne->cell_set_boolean(retval, Ne->cell_get_dictionary_entry(d, n, NULL) != NULL);
+    return Ne_SUCCESS;
+}
+
 Ne_EXPORT int Ne_funcNumberOut(struct Ne_Cell *retval, struct Ne_ParameterList *in_params, struct Ne_ParameterList *out_params)
 {
     Ne->cell_set_number_int(Ne->parameterlist_set_cell(out_params, 0), 5);
@@ -93,13 +93,13 @@ Cell writeBytes(const utf8string &filename, const std::vector<unsigned char> &da
     return Cell(std::vector<Cell> { Cell(number_from_uint32(CHOICE_FileResult_ok)) });
 }
 
-Cell writeLines(const utf8string &filename, const std::vector<utf8string> &lines)
+Cell writeLines(const utf8string &filename, ArrayView<utf8string> lines)
 {
     std::ofstream f(filename.str(), std::ios::out | std::ios::trunc); // Truncate the file every time we open it to write lines to it.
     if (not f.is_open()) {
         return file_error_result(errno, filename);
     }
-    for (auto s: lines) {
+    for (const utf8string &s: lines) {
         f << s.str() << "\n";   // Write line, and line-ending for each element in the array.
         if (f.fail()) {
             // If the write fails for any reason, consider that a FileException.Write exception.
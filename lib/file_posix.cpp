@@ -188,9 +188,9 @@ bool exists(const utf8string &filename)
     return access(filename.c_str(), F_OK) == 0;
 }
 
-std::vector<utf8string> files(const utf8string &path)
+std::vector<Cell> files(const utf8string &path)
 {
-    std::vector<utf8string> r;
+    std::vector<Cell> r;
     DIR *d = opendir(path.c_str());
     if (d != NULL) {
         for (;;) {
@@ -198,7 +198,7 @@ std::vector<utf8string> files(const utf8string &path)
             if (de == NULL) {
                 break;
             }
-            r.push_back(utf8string(de->d_name));
+            r.push_back(Cell(de->d_name));
         }
         closedir(d);
     }
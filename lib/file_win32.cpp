@@ -59,14 +59,14 @@ bool exists(const utf8string &filename)
     return _access(filename.c_str(), 0) == 0;
 }
 
-std::vector<utf8string> files(const utf8string &path)
+std::vector<Cell> files(const utf8string &path)
 {
-    std::vector<utf8string> r;
+    std::vector<Cell> r;
     WIN32_FIND_DATA fd;
     HANDLE ff = FindFirstFile((path + "\\*").c_str(), &fd);
     if (ff != INVALID_HANDLE_VALUE) {
         do {
-            r.push_back(utf8string(fd.cFileName));
+            r.push_back(Cell(fd.cFileName));
         } while (FindNextFile(ff, &fd));
         FindClose(ff);
     }
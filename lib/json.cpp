@@ -0,0 +1,634 @@
+#include <cstdio>
+#include <deque>
+#include <iso646.h>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cell.h"
+#include "number.h"
+#include "object.h"
+#include "rtl_exec.h"
+#include "utf8string.h"
+
+#include "choices.inc"
+
+// The decoder is a state machine that is given the input one byte at a
+// time, so that it can stop at the end of any chunk and carry on when the
+// next one arrives. Arrays and dictionaries under construction are kept on
+// an explicit stack instead of the native one. The results (including the
+// messages and indexes of errors) are the same as the Neon decoder this
+// replaced, and indexes count characters rather than bytes.
+
+namespace {
+
+const char *const ReplacementCharacter = "\xef\xbf\xbd";
+
+bool is_whitespace(int c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool is_digit(int c)
+{
+    return c >= '0' && c <= '9';
+}
+
+void append_code_point(std::string &s, uint32_t c)
+{
+    utf8::append(c, std::back_inserter(s));
+}
+
+class Decoder {
+public:
+    explicit Decoder(bool sequence): sequence(sequence), state(State::VALUE), finished(false), index(0), start(0), stack(), token(), hex(0), hex_digits(0), high_surrogate(0), value(), results() {}
+    Decoder(const Decoder &) = delete;
+    Decoder &operator=(const Decoder &) = delete;
+
+    void feed(const unsigned char *data, size_t length) {
+        const unsigned char *end = data + length;
+        const unsigned char *p = data;
+        while (p < end) {
+            if (state == State::STRING && high_surrogate == 0) {
+                // Copy a run of ordinary characters in one go.
+                const unsigned char *q = p;
+                while (q < end && *q != '"' && *q != '\\' && *q >= 0x20) {
+                    if ((*q & 0xc0) != 0x80) {
+                        index++;
+                    }
+                    q++;
+                }
+                token.append(reinterpret_cast<const char *>(p), q - p);
+                p = q;
+                if (p == end) {
+                    break;
+                }
+            }
+            if (step(*p)) {
+                if ((*p & 0xc0) != 0x80) {
+                    index++;
+                }
+                p++;
+            }
+        }
+    }
+
+    void finish() {
+        finished = true;
+        while (not step(-1)) {
+        }
+    }
+
+    bool next(Cell &result) {
+        if (results.empty()) {
+            return false;
+        }
+        result = std::move(results.front());
+        results.pop_front();
+        return true;
+    }
+
+    bool is_finished() const {
+        return finished;
+    }
+
+private:
+    enum class State {
+        VALUE,
+        ARRAY_FIRST,
+        ARRAY_NEXT,
+        OBJECT_FIRST,
+        OBJECT_COLON,
+        OBJECT_NEXT,
+        AFTER,
+        LITERAL,
+        NUMBER_MINUS,
+        NUMBER_ZERO,
+        NUMBER_INT,
+        NUMBER_DOT,
+        NUMBER_FRAC,
+        NUMBER_E,
+        NUMBER_ESIGN,
+        NUMBER_EXP,
+        STRING,
+        STRING_ESCAPE,
+        STRING_HEX,
+        FAILED,
+        DONE,
+    };
+
+    struct Container {
+        explicit Container(bool object): object(object), array(), dictionary(), key(), have_key(false) {}
+        bool object;
+        std::vector<std::shared_ptr<Object>> array;
+        std::map<utf8string, std::shared_ptr<Object>> dictionary;
+        utf8string key;
+        bool have_key;
+    };
+
+    const bool sequence;
+    State state;
+    bool finished;
+    uint64_t index;
+    uint64_t start;
+    std::vector<Container> stack;
+    std::string token;
+    uint32_t hex;
+    int hex_digits;
+    uint32_t high_surrogate;
+    std::shared_ptr<Object> value;
+    std::deque<Cell> results;
+
+    void fail(const char *message, uint64_t at) {
+        results.push_back(Cell(std::vector<Cell> {
+            Cell(number_from_uint32(CHOICE_JsonResult_error)),
+            Cell(std::vector<Cell> {
+                Cell(utf8string(message)),
+                Cell(number_from_uint64(at))
+            })
+        }));
+        state = State::FAILED;
+        stack.clear();
+        token.clear();
+        value = nullptr;
+    }
+
+    // Put a complete value into the container it belongs to, where end is
+    // the index just after the value.
+    void complete(std::shared_ptr<Object> v, uint64_t end) {
+        if (stack.empty()) {
+            if (sequence) {
+                results.push_back(Cell(std::vector<Cell> {
+                    Cell(number_from_uint32(CHOICE_JsonResult_data)),
+                    Cell(v)
+                }));
+                state = State::VALUE;
+            } else {
+                value = std::move(v);
+                state = State::AFTER;
+            }
+            return;
+        }
+        Container &top = stack.back();
+        if (not top.object) {
+            top.array.push_back(std::move(v));
+            state = State::ARRAY_NEXT;
+        } else if (not top.have_key) {
+            if (v == nullptr || not v->getString(top.key)) {
+                fail("string key expected", end);
+                return;
+            }
+            top.have_key = true;
+            state = State::OBJECT_COLON;
+        } else {
+            top.dictionary[top.key] = std::move(v);
+            top.have_key = false;
+            state = State::OBJECT_NEXT;
+        }
+    }
+
+    void close(uint64_t end) {
+        Container top = std::move(stack.back());
+        stack.pop_back();
+        if (top.object) {
+            complete(std::make_shared<ObjectDictionary>(std::move(top.dictionary)), end);
+        } else {
+            complete(std::make_shared<ObjectArray>(std::move(top.array)), end);
+        }
+    }
+
+    void flush_surrogate() {
+        if (high_surrogate != 0) {
+            token.append(ReplacementCharacter);
+            high_surrogate = 0;
+        }
+    }
+
+    void finish_literal() {
+        if (token == "null") {
+            complete(nullptr, index);
+        } else if (token == "false") {
+            complete(std::make_shared<ObjectBoolean>(false), index);
+        } else if (token == "true") {
+            complete(std::make_shared<ObjectBoolean>(true), index);
+        } else {
+            fail("null or false or true expected", start);
+        }
+    }
+
+    void finish_number() {
+        Number n = number_from_string(token);
+        if (number_is_nan(n)) {
+            fail("number format error", 0);
+            return;
+        }
+        complete(std::make_shared<ObjectNumber>(n), index);
+    }
+
+    void finish_hex() {
+        uint32_t c = hex;
+        if (c >= 0xd800 && c < 0xdc00) {
+            flush_surrogate();
+            high_surrogate = c;
+        } else if (c >= 0xdc00 && c < 0xe000) {
+            if (high_surrogate != 0) {
+                append_code_point(token, 0x10000 + ((high_surrogate - 0xd800) << 10) + (c - 0xdc00));
+                high_surrogate = 0;
+            } else {
+                token.append(ReplacementCharacter);
+            }
+        } else {
+            flush_surrogate();
+            append_code_point(token, c);
+        }
+        state = State::STRING;
+    }
+
+    // Handle one byte of input (or -1 for the end of the input). Returns
+    // false if the byte ended a token and must be handled again in the
+    // new state.
+    bool step(int c) {
+        switch (state) {
+            case State::VALUE:
+                if (is_whitespace(c)) {
+                    return true;
+                }
+                start = index;
+                token.clear();
+                if (c >= 'a' && c <= 'z') {
+                    token.push_back(static_cast<char>(c));
+                    state = State::LITERAL;
+                } else if (c == '-') {
+                    token.push_back('-');
+                    state = State::NUMBER_MINUS;
+                } else if (is_digit(c)) {
+                    state = State::NUMBER_MINUS;
+                    return false;
+                } else if (c == '"') {
+                    high_surrogate = 0;
+                    state = State::STRING;
+                } else if (c == '[') {
+                    stack.emplace_back(false);
+                    state = State::ARRAY_FIRST;
+                } else if (c == '{') {
+                    stack.emplace_back(true);
+                    state = State::OBJECT_FIRST;
+                } else if (c < 0 && sequence && stack.empty()) {
+                    state = State::DONE;
+                } else {
+                    fail("value expected", index);
+                }
+                return true;
+            case State::ARRAY_FIRST:
+                if (is_whitespace(c)) {
+                    return true;
+                }
+                if (c == ']') {
+                    close(index + 1);
+                    return true;
+                }
+                state = State::VALUE;
+                return false;
+            case State::ARRAY_NEXT:
+                if (is_whitespace(c)) {
+                    return true;
+                }
+                if (c == ',') {
+                    state = State::VALUE;
+                } else if (c == ']') {
+                    close(index + 1);
+                } else {
+                    fail(", or ] expected", index);
+                }
+                return true;
+            case State::OBJECT_FIRST:
+                if (is_whitespace(c)) {
+                    return true;
+                }
+                if (c == '}') {
+                    close(index + 1);
+                    return true;
+                }
+                state = State::VALUE;
+                return false;
+            case State::OBJECT_COLON:
+                if (is_whitespace(c)) {
+                    return true;
+                }
+                if (c == ':') {
+                    state = State::VALUE;
+                } else {
+                    fail(": expected", index);
+                }
+                return true;
+            case State::OBJECT_NEXT:
+                if (is_whitespace(c)) {
+                    return true;
+                }
+                if (c == ',') {
+                    state = State::VALUE;
+                } else if (c == '}') {
+                    close(index + 1);
+                } else {
+                    fail(", or } expected", index);
+                }
+                return true;
+            case State::AFTER:
+                if (is_whitespace(c)) {
+                    return true;
+                }
+                if (c < 0) {
+                    results.push_back(Cell(std::vector<Cell> {
+                        Cell(number_from_uint32(CHOICE_JsonResult_data)),
+                        Cell(value)
+                    }));
+                    value = nullptr;
+                    state = State::DONE;
+                } else {
+                    fail("unexpected input after value", index);
+                }
+                return true;
+            case State::LITERAL:
+                if (c >= 'a' && c <= 'z') {
+                    token.push_back(static_cast<char>(c));
+                    return true;
+                }
+                finish_literal();
+                return false;
+            case State::NUMBER_MINUS:
+                if (c == '0') {
+                    state = State::NUMBER_ZERO;
+                } else if (is_digit(c)) {
+                    state = State::NUMBER_INT;
+                } else {
+                    fail("digit expected", start);
+                    return true;
+                }
+                token.push_back(static_cast<char>(c));
+                return true;
+            case State::NUMBER_ZERO:
+            case State::NUMBER_INT:
+            case State::NUMBER_FRAC:
+                if (is_digit(c) && state != State::NUMBER_ZERO) {
+                    token.push_back(static_cast<char>(c));
+                    return true;
+                }
+                if (c == '.' && state != State::NUMBER_FRAC) {
+                    token.push_back('.');
+                    state = State::NUMBER_DOT;
+                    return true;
+                }
+                if (c == 'e' || c == 'E') {
+                    token.push_back(static_cast<char>(c));
+                    state = State::NUMBER_E;
+                    return true;
+                }
+                finish_number();
+                return false;
+            case State::NUMBER_DOT:
+            case State::NUMBER_ESIGN:
+                if (not is_digit(c)) {
+                    fail("digit expected", start);
+                    return true;
+                }
+                token.push_back(static_cast<char>(c));
+                state = state == State::NUMBER_DOT ? State::NUMBER_FRAC : State::NUMBER_EXP;
+                return true;
+            case State::NUMBER_E:
+                if (c == '+' || c == '-') {
+                    token.push_back(static_cast<char>(c));
+                    state = State::NUMBER_ESIGN;
+                } else if (is_digit(c)) {
+                    token.push_back(static_cast<char>(c));
+                    state = State::NUMBER_EXP;
+                } else {
+                    fail("digit expected", start);
+                }
+                return true;
+            case State::NUMBER_EXP:
+                if (is_digit(c)) {
+                    token.push_back(static_cast<char>(c));
+                    return true;
+                }
+                finish_number();
+                return false;
+            case State::STRING:
+                if (c == '"') {
+                    flush_surrogate();
+                    if (not utf8::is_valid(token.begin(), token.end())) {
+                        fail("invalid character", start);
+                        return true;
+                    }
+                    complete(std::make_shared<ObjectString>(utf8string(token)), index + 1);
+                } else if (c == '\\') {
+                    state = State::STRING_ESCAPE;
+                } else if (c < 0) {
+                    fail("missing trailing quote", index);
+                } else if (c < 0x20) {
+                    fail("invalid character", index);
+                } else {
+                    flush_surrogate();
+                    token.push_back(static_cast<char>(c));
+                }
+                return true;
+            case State::STRING_ESCAPE:
+                if (c == 'u') {
+                    hex = 0;
+                    hex_digits = 0;
+                    state = State::STRING_HEX;
+                    return true;
+                }
+                if (c < 0) {
+                    fail("missing trailing quote", index);
+                    return true;
+                }
+                flush_surrogate();
+                switch (c) {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        token.push_back(static_cast<char>(c));
+                        break;
+                    case 'b': token.push_back('\b'); break;
+                    case 'f': token.push_back('\f'); break;
+                    case 'n': token.push_back('\n'); break;
+                    case 'r': token.push_back('\r'); break;
+                    case 't': token.push_back('\t'); break;
+                    default:
+                        fail("invalid escape sequence", index);
+                        return true;
+                }
+                state = State::STRING;
+                return true;
+            case State::STRING_HEX:
+                if (is_digit(c)) {
+                    hex = (hex << 4) | (c - '0');
+                } else if (c >= 'a' && c <= 'f') {
+                    hex = (hex << 4) | (c - 'a' + 10);
+                } else if (c >= 'A' && c <= 'F') {
+                    hex = (hex << 4) | (c - 'A' + 10);
+                } else {
+                    fail("invalid hex character", index);
+                    return true;
+                }
+                hex_digits++;
+                if (hex_digits == 4) {
+                    finish_hex();
+                }
+                return true;
+            case State::FAILED:
+            case State::DONE:
+                return true;
+        }
+        return true;
+    }
+};
+
+class DecoderObject: public Object {
+public:
+    explicit DecoderObject(bool sequence): decoder(sequence) {}
+    DecoderObject(const DecoderObject &) = delete;
+    DecoderObject &operator=(const DecoderObject &) = delete;
+    virtual utf8string toString() const override { return utf8string("<JSON decoder>"); }
+    Decoder decoder;
+};
+
+Decoder &check_decoder(const std::shared_ptr<Object> &pdecoder)
+{
+    DecoderObject *d = dynamic_cast<DecoderObject *>(pdecoder.get());
+    if (d == nullptr) {
+        throw RtlException(rtl::ne_json::Exception_JsonException_InvalidDecoder, utf8string(""));
+    }
+    return d->decoder;
+}
+
+void encode_string(std::string &r, const std::string &s)
+{
+    r.push_back('"');
+    for (char c: s) {
+        switch (c) {
+            case '"':  r.append("\\\""); break;
+            case '\\': r.append("\\\\"); break;
+            case '\b': r.append("\\b"); break;
+            case '\f': r.append("\\f"); break;
+            case '\n': r.append("\\n"); break;
+            case '\r': r.append("\\r"); break;
+            case '\t': r.append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[7];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    r.append(buf);
+                } else {
+                    r.push_back(c);
+                }
+                break;
+        }
+    }
+    r.push_back('"');
+}
+
+void encode_value(std::string &r, const std::shared_ptr<Object> &data)
+{
+    bool b;
+    Number n;
+    utf8string s;
+    std::vector<std::shared_ptr<Object>> a;
+    std::map<utf8string, std::shared_ptr<Object>> d;
+    if (data == nullptr) {
+        r.append("null");
+    } else if (data->getBoolean(b)) {
+        r.append(b ? "true" : "false");
+    } else if (data->getNumber(n)) {
+        r.append(number_to_string(n));
+    } else if (data->getString(s)) {
+        encode_string(r, s.str());
+    } else if (data->getArray(a)) {
+        r.push_back('[');
+        bool first = true;
+        for (auto &x: a) {
+            if (not first) {
+                r.push_back(',');
+            }
+            first = false;
+            encode_value(r, x);
+        }
+        r.push_back(']');
+    } else if (data->getDictionary(d)) {
+        r.push_back('{');
+        bool first = true;
+        for (auto &x: d) {
+            if (not first) {
+                r.push_back(',');
+            }
+            first = false;
+            encode_string(r, x.first.str());
+            r.push_back(':');
+            encode_value(r, x.second);
+        }
+        r.push_back('}');
+    } else {
+        r.append("?unknown");
+    }
+}
+
+} // namespace
+
+namespace rtl {
+
+namespace ne_json {
+
+Cell decode(const utf8string &json)
+{
+    Decoder decoder(false);
+    decoder.feed(reinterpret_cast<const unsigned char *>(json.data()), json.size());
+    decoder.finish();
+    Cell r;
+    decoder.next(r);
+    return r;
+}
+
+utf8string encode(const std::shared_ptr<Object> &data)
+{
+    std::string r;
+    encode_value(r, data);
+    return utf8string(r);
+}
+
+std::shared_ptr<Object> newDecoder()
+{
+    return std::make_shared<DecoderObject>(false);
+}
+
+std::shared_ptr<Object> newSequenceDecoder()
+{
+    return std::make_shared<DecoderObject>(true);
+}
+
+void decoderFeed(const std::shared_ptr<Object> &decoder, const std::vector<unsigned char> &chunk)
+{
+    Decoder &d = check_decoder(decoder);
+    if (d.is_finished()) {
+        throw RtlException(Exception_JsonException_InvalidDecoder, utf8string("finished"));
+    }
+    d.feed(chunk.data(), chunk.size());
+}
+
+void decoderFinish(const std::shared_ptr<Object> &decoder)
+{
+    Decoder &d = check_decoder(decoder);
+    if (not d.is_finished()) {
+        d.finish();
+    }
+}
+
+bool decoderNext(const std::shared_ptr<Object> &decoder, Cell *result)
+{
+    return check_decoder(decoder).next(*result);
+}
+
+} // namespace ne_json
+
+} // namespace rtl
@@ -11,6 +11,7 @@
 #include <termios.h>
 #include <unistd.h>
 
+#include <cell.h>
 #include <number.h>
 #include <utf8string.h>
 
@@ -75,7 +76,7 @@ void exit(Number status)
     _exit(number_to_sint32(status));
 }
 
-Number execve(const utf8string &path, const std::vector<utf8string> &argv, const std::vector<utf8string> &envp)
+Number execve(const utf8string &path, ArrayView<utf8string> argv, ArrayView<utf8string> envp)
 {
     char *a[argv.size()+1];
     for (size_t i = 0; i < argv.size(); i++) {
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <iso646.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cell.h"
+#include "number.h"
+#include "object.h"
+#include "utf8string.h"
+
+#include "choices.inc"
+
+// The regex module parses and compiles patterns in Neon, and the resulting
+// program (an Array<Opcode>) is decoded once by load() and run here. Instead of backtracking, all the
+// ways the program could proceed are followed together, one character of
+// the target at a time (a Pike VM). This takes time proportional to the
+// length of the target times the size of the program, no matter what the
+// pattern is.
+//
+// The threads are kept in priority order, and a thread reaching an
+// instruction already visited for the current character is dropped, so the
+// captures reported are the same as a backtracking matcher would find.
+
+namespace {
+
+struct Instruction {
+    Instruction(): opcode(0), c(0), complement(false), chars(), targets() {}
+    uint32_t opcode;
+    uint32_t c;
+    bool complement;
+    std::vector<uint32_t> chars;
+    std::vector<size_t> targets;
+};
+
+struct Thread {
+    Thread(size_t pc, const std::vector<Number> &saved): pc(pc), saved(saved) {}
+    size_t pc;
+    std::vector<Number> saved;
+};
+
+uint32_t code_point(const utf8string &s)
+{
+    auto i = s.str().begin();
+    if (i == s.str().end()) {
+        return 0;
+    }
+    return utf8::next(i, s.str().end());
+}
+
+std::vector<Instruction> decode(Cell &regex, size_t &nsaved)
+{
+    std::vector<Instruction> program;
+    nsaved = 0;
+    size_t size = regex.array().size();
+    for (size_t i = 0; i < size; i++) {
+        Cell &choice = regex.array_index_for_read(i);
+        Instruction inst;
+        inst.opcode = number_to_uint32(choice.array_index_for_read(0).number());
+        if (inst.opcode == CHOICE_Opcode_char) {
+            inst.c = code_point(choice.array_index_for_read(1).string());
+        } else if (inst.opcode == CHOICE_Opcode_class) {
+            Cell &cls = choice.array_index_for_read(1);
+            for (auto &c: cls.array_index_for_read(0).dictionary()) {
+                inst.chars.push_back(code_point(c.first));
+            }
+            std::sort(inst.chars.begin(), inst.chars.end());
+            inst.complement = cls.array_index_for_read(1).boolean();
+        } else if (inst.opcode == CHOICE_Opcode_save) {
+            inst.c = number_to_uint32(choice.array_index_for_read(1).number());
+            nsaved = std::max(nsaved, static_cast<size_t>(inst.c + 1));
+        } else if (inst.opcode == CHOICE_Opcode_jump) {
+            Cell &targets = choice.array_index_for_read(1);
+            for (size_t j = 0; j < targets.array().size(); j++) {
+                inst.targets.push_back(number_to_uint32(targets.array_index_for_read(j).number()));
+            }
+        }
+        program.push_back(inst);
+    }
+    return program;
+}
+
+// A decoded program, kept in the Regex record so each match can use it
+// directly.
+class RegexObject: public Object {
+public:
+    RegexObject(): program(), nsaved(0) {}
+    RegexObject(const RegexObject &) = delete;
+    RegexObject &operator=(const RegexObject &) = delete;
+    virtual utf8string toString() const override { return utf8string("<REGEX>"); }
+    std::vector<Instruction> program;
+    size_t nsaved;
+};
+
+class Machine {
+public:
+    Machine(const std::vector<Instruction> &program, const std::vector<uint32_t> &target): program(program), target(target), visited(program.size(), SIZE_MAX), stack() {}
+    Machine(const Machine &) = delete;
+    Machine &operator=(const Machine &) = delete;
+
+    // Add the thread starting at pc to list, after following every
+    // instruction that doesn't consume a character. The instructions are
+    // followed depth first in priority order, using a stack instead of
+    // recursion because a large repeat count makes a long chain of jumps.
+    void add(std::vector<Thread> &list, size_t generation, size_t pc, const std::vector<Number> &saved, size_t pos) {
+        stack.emplace_back(pc, saved);
+        while (not stack.empty()) {
+            Thread t = std::move(stack.back());
+            stack.pop_back();
+            if (t.pc >= program.size() || visited[t.pc] == generation) {
+                continue;
+            }
+            visited[t.pc] = generation;
+            const Instruction &inst = program[t.pc];
+            switch (inst.opcode) {
+                case CHOICE_Opcode_begin:
+                    if (pos == 0) {
+                        t.pc++;
+                        stack.push_back(std::move(t));
+                    }
+                    break;
+                case CHOICE_Opcode_end:
+                    if (pos >= target.size()) {
+                        t.pc++;
+                        stack.push_back(std::move(t));
+                    }
+                    break;
+                case CHOICE_Opcode_save:
+                    t.saved[inst.c] = number_from_uint64(pos);
+                    t.pc++;
+                    stack.push_back(std::move(t));
+                    break;
+                case CHOICE_Opcode_jump:
+                    for (auto j = inst.targets.rbegin(); j != inst.targets.rend(); ++j) {
+                        stack.emplace_back(*j, t.saved);
+                    }
+                    break;
+                default:
+                    list.push_back(std::move(t));
+                    break;
+            }
+        }
+    }
+
+    bool accepts(const Instruction &inst, size_t pos) const {
+        if (pos >= target.size()) {
+            return false;
+        }
+        uint32_t c = target[pos];
+        switch (inst.opcode) {
+            case CHOICE_Opcode_any:
+                return true;
+            case CHOICE_Opcode_char:
+                return c == inst.c;
+            case CHOICE_Opcode_class:
+                return std::binary_search(inst.chars.begin(), inst.chars.end(), c) != inst.complement;
+            default:
+                return false;
+        }
+    }
+
+    bool run(size_t nsaved, std::vector<Number> &result) {
+        std::vector<Thread> current;
+        std::vector<Thread> next;
+        size_t generation = 0;
+        add(current, generation, 0, std::vector<Number>(nsaved, number_from_sint32(-1)), 0);
+        bool matched = false;
+        for (size_t pos = 0; not current.empty(); pos++) {
+            generation++;
+            next.clear();
+            for (auto &t: current) {
+                const Instruction &inst = program[t.pc];
+                if (inst.opcode == CHOICE_Opcode_match) {
+                    // Threads after this one have lower priority, so the
+                    // matches they might find are never reported.
+                    matched = true;
+                    result = t.saved;
+                    break;
+                }
+                if (accepts(inst, pos)) {
+                    add(next, generation, t.pc + 1, t.saved, pos + 1);
+                }
+            }
+            std::swap(current, next);
+        }
+        return matched;
+    }
+
+private:
+    const std::vector<Instruction> &program;
+    const std::vector<uint32_t> &target;
+    std::vector<size_t> visited;
+    std::vector<Thread> stack;
+};
+
+} // namespace
+
+namespace rtl {
+
+namespace ne_regex {
+
+std::shared_ptr<Object> load(Cell &program)
+{
+    auto r = std::make_shared<RegexObject>();
+    r->program = decode(program, r->nsaved);
+    r->nsaved += r->nsaved % 2;
+    return r;
+}
+
+std::vector<Cell> execute(const std::shared_ptr<Object> &program, const utf8string &target)
+{
+    // A Regex that was never prepared has no program, and matches nothing.
+    const RegexObject *regex = dynamic_cast<const RegexObject *>(program.get());
+    if (regex == nullptr) {
+        return std::vector<Cell>();
+    }
+    std::vector<uint32_t> chars;
+    for (auto i = target.str().begin(); i != target.str().end(); ) {
+        chars.push_back(utf8::next(i, target.str().end()));
+    }
+    Machine machine(regex->program, chars);
+    std::vector<Number> saved;
+    std::vector<Cell> r;
+    if (machine.run(regex->nsaved, saved)) {
+        r.reserve(saved.size());
+        for (auto x: saved) {
+            r.push_back(Cell(x));
+        }
+    }
+    return r;
+}
+
+} // namespace ne_regex
+
+} // namespace rtl
@@ -31,6 +31,21 @@ Number getAllocatedObjectCount()
     return number_from_uint64(executor_get_allocated_object_count());
 }
 
+Number getGarbageCollectionCount()
+{
+    return number_from_uint64(executor_get_garbage_collection_count());
+}
+
+Number getGarbageCollectionPauseMaximum()
+{
+    return number_from_uint64(executor_get_garbage_collection_pause_maximum());
+}
+
+Number getGarbageCollectionPauseTotal()
+{
+    return number_from_uint64(executor_get_garbage_collection_pause_total());
+}
+
 bool isModuleImported(const utf8string &module)
 {
     return executor_is_module_imported(module.str());
@@ -46,6 +61,11 @@ void setGarbageCollectionInterval(Number count)
     executor_set_garbage_collection_interval(number_to_uint64(count));
 }
 
+void setGarbageCollectionPauseBudget(Number microseconds)
+{
+    executor_set_garbage_collection_pause_budget(number_to_uint64(microseconds));
+}
+
 void setRecursionLimit(Number depth)
 {
     executor_set_recursion_limit(number_to_uint64(depth));
@@ -1,4 +1,7 @@
+#include <limits>
+#include <list>
 #include <string>
+#include <unordered_map>
 
 #include <sqlite3.h>
 
@@ -7,13 +10,99 @@
 
 #include "choices.inc"
 
+// Number of prepared statements kept for each database connection.
+const size_t StatementCacheSize = 32;
+
 class DatabaseObject: public Object {
 public:
-    explicit DatabaseObject(sqlite3 *db): db(db) {}
+    explicit DatabaseObject(sqlite3 *db): db(db), lru(), statements() {}
     DatabaseObject(const DatabaseObject &) = delete;
     DatabaseObject &operator=(const DatabaseObject &) = delete;
+    virtual ~DatabaseObject() {
+        if (db != NULL) {
+            finalize_statements();
+            sqlite3_close_v2(db);
+        }
+    }
     virtual utf8string toString() const { return utf8string("<SQLITE " + std::to_string(reinterpret_cast<intptr_t>(db)) + ">"); }
+
+    // Return a prepared statement for sql from the cache, preparing it if
+    // necessary. The caller never finalizes it, see StatementUse below.
+    sqlite3_stmt *prepare(const utf8string &sql) {
+        auto s = statements.find(sql.str());
+        if (s != statements.end()) {
+            lru.splice(lru.begin(), lru, s->second);
+            return s->second->second;
+        }
+        sqlite3_stmt *stmt;
+        int r = sqlite3_prepare_v2(db, sql.c_str(), static_cast<int>(sql.length()), &stmt, NULL);
+        if (r != SQLITE_OK) {
+            throw RtlException(rtl::ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db)));
+        }
+        if (lru.size() >= StatementCacheSize) {
+            sqlite3_finalize(lru.back().second);
+            statements.erase(lru.back().first);
+            lru.pop_back();
+        }
+        lru.emplace_front(sql.str(), stmt);
+        statements[sql.str()] = lru.begin();
+        return stmt;
+    }
+    void finalize_statements() {
+        for (auto &s: lru) {
+            sqlite3_finalize(s.second);
+        }
+        lru.clear();
+        statements.clear();
+    }
+
     sqlite3 *db;
+private:
+    std::list<std::pair<std::string, sqlite3_stmt *>> lru;
+    std::unordered_map<std::string, std::list<std::pair<std::string, sqlite3_stmt *>>::iterator> statements;
+};
+
+// Resets a cached statement when the caller is done with it (including by
+// an exception), so that it holds no locks or parameter data in the cache.
+class StatementUse {
+public:
+    explicit StatementUse(sqlite3_stmt *stmt): stmt(stmt) {}
+    StatementUse(const StatementUse &) = delete;
+    StatementUse &operator=(const StatementUse &) = delete;
+    ~StatementUse() {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+    sqlite3_stmt *const stmt;
+};
+
+// Starts a transaction unless the connection is already in one, and rolls
+// it back when it goes out of scope unless commit() succeeded.
+class Transaction {
+public:
+    explicit Transaction(sqlite3 *db): db(db), active(sqlite3_get_autocommit(db) != 0) {
+        if (active && sqlite3_exec(db, "BEGIN", NULL, NULL, NULL) != SQLITE_OK) {
+            throw RtlException(rtl::ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db)));
+        }
+    }
+    Transaction(const Transaction &) = delete;
+    Transaction &operator=(const Transaction &) = delete;
+    ~Transaction() {
+        if (active) {
+            sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+        }
+    }
+    void commit() {
+        if (active) {
+            if (sqlite3_exec(db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+                throw RtlException(rtl::ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db)));
+            }
+            active = false;
+        }
+    }
+private:
+    sqlite3 *const db;
+    bool active;
 };
 
 static DatabaseObject *check_database(const std::shared_ptr<Object> &pdb)
@@ -25,6 +114,111 @@ static DatabaseObject *check_database(const std::shared_ptr<Object> &pdb)
     return db;
 }
 
+static int bind_index(sqlite3_stmt *stmt, const utf8string &name)
+{
+    int c = sqlite3_bind_parameter_index(stmt, name.c_str());
+    if (c == 0) {
+        throw RtlException(rtl::ne_sqlite::Exception_SqliteException_ParameterName, name);
+    }
+    return c;
+}
+
+// The parameter strings outlive the statement execution, so they are bound
+// without copying.
+static void bind_strings(DatabaseObject *db, sqlite3_stmt *stmt, const std::map<utf8string, utf8string> &parameters)
+{
+    for (auto &p: parameters) {
+        int r = sqlite3_bind_text(stmt, bind_index(stmt, p.first), p.second.c_str(), static_cast<int>(p.second.length()), SQLITE_STATIC);
+        if (r != SQLITE_OK) {
+            throw RtlException(rtl::ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db->db)));
+        }
+    }
+}
+
+static void bind_object(DatabaseObject *db, sqlite3_stmt *stmt, const utf8string &name, const std::shared_ptr<Object> &o)
+{
+    int c = bind_index(stmt, name);
+    bool b;
+    Number n;
+    utf8string s;
+    std::vector<unsigned char> bytes;
+    int r;
+    if (o == nullptr) {
+        r = sqlite3_bind_null(stmt, c);
+    } else if (o->getNumber(n)) {
+        // Integers too big for an int64 are bound as a real instead.
+        if (number_is_integer(n)
+         && number_is_greater_equal(n, number_from_sint64(std::numeric_limits<int64_t>::min()))
+         && number_is_less_equal(n, number_from_sint64(std::numeric_limits<int64_t>::max()))) {
+            r = sqlite3_bind_int64(stmt, c, number_to_sint64(n));
+        } else {
+            r = sqlite3_bind_double(stmt, c, number_to_double(n));
+        }
+    } else if (o->getString(s)) {
+        r = sqlite3_bind_text(stmt, c, s.c_str(), static_cast<int>(s.length()), SQLITE_TRANSIENT);
+    } else if (o->getBytes(bytes)) {
+        r = sqlite3_bind_blob(stmt, c, bytes.data(), static_cast<int>(bytes.size()), SQLITE_TRANSIENT);
+    } else if (o->getBoolean(b)) {
+        r = sqlite3_bind_int(stmt, c, b);
+    } else {
+        throw RtlException(rtl::ne_sqlite::Exception_SqliteException_ParameterType, name);
+    }
+    if (r != SQLITE_OK) {
+        throw RtlException(rtl::ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db->db)));
+    }
+}
+
+static Cell column_text(sqlite3_stmt *stmt, int i)
+{
+    const char *value = reinterpret_cast<const char *>(sqlite3_column_text(stmt, i));
+    if (value == nullptr) {
+        return Cell("");
+    }
+    return Cell(utf8string(std::string(value, sqlite3_column_bytes(stmt, i))));
+}
+
+static Cell column_object(sqlite3_stmt *stmt, int i)
+{
+    switch (sqlite3_column_type(stmt, i)) {
+        case SQLITE_INTEGER:
+            return Cell(std::shared_ptr<Object> { new ObjectNumber(number_from_sint64(sqlite3_column_int64(stmt, i))) });
+        case SQLITE_FLOAT:
+            return Cell(std::shared_ptr<Object> { new ObjectNumber(number_from_double(sqlite3_column_double(stmt, i))) });
+        case SQLITE_TEXT:
+            return Cell(std::shared_ptr<Object> { new ObjectString(column_text(stmt, i).string()) });
+        case SQLITE_BLOB: {
+            const unsigned char *p = static_cast<const unsigned char *>(sqlite3_column_blob(stmt, i));
+            return Cell(std::shared_ptr<Object> { new ObjectBytes(std::vector<unsigned char>(p, p + sqlite3_column_bytes(stmt, i))) });
+        }
+        default:
+            return Cell(std::shared_ptr<Object>());
+    }
+}
+
+// Run a prepared statement to completion, appending each row made by
+// column(stmt, i) to rows (if not null).
+static void step_all(DatabaseObject *db, sqlite3_stmt *stmt, Cell (*column)(sqlite3_stmt *, int), std::vector<Cell> *rows)
+{
+    int columns = sqlite3_column_count(stmt);
+    for (;;) {
+        int r = sqlite3_step(stmt);
+        if (r == SQLITE_DONE) {
+            break;
+        }
+        if (r != SQLITE_ROW) {
+            throw RtlException(rtl::ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db->db)));
+        }
+        if (rows != nullptr) {
+            std::vector<Cell> row;
+            row.reserve(columns);
+            for (int i = 0; i < columns; i++) {
+                row.push_back(column(stmt, i));
+            }
+            rows->push_back(Cell(row));
+        }
+    }
+}
+
 static int callback(void *rowscell, int columns, char **values, char ** /*names*/)
 {
     std::vector<Cell> *rows = static_cast<std::vector<Cell> *>(rowscell);
@@ -51,7 +245,7 @@ Cell open(const utf8string &name)
         });
     }
     return Cell(std::vector<Cell> {
-        Cell(number_from_uint32(CHOICE_OpenResult_file)), // TODO: db
+        Cell(number_from_uint32(CHOICE_OpenResult_db)),
         Cell(std::shared_ptr<Object> { new DatabaseObject(db) })
     });
 }
@@ -60,81 +254,68 @@ Cell exec(const std::shared_ptr<Object> &pdb, const utf8string &sql, const std::
 {
     DatabaseObject *db = check_database(pdb);
     std::vector<Cell> rows;
-    sqlite3_stmt *stmt;
-    int r = sqlite3_prepare_v2(db->db, sql.c_str(), -1, &stmt, NULL);
-    if (r != SQLITE_OK) {
-        throw RtlException(ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db->db)));
-    }
-    for (auto p: parameters) {
-        int c = sqlite3_bind_parameter_index(stmt, p.first.c_str());
-        if (c == 0) {
-            throw RtlException(Exception_SqliteException_ParameterName, utf8string(p.first.c_str()));
-        }
-        r = sqlite3_bind_text(stmt, c, p.second.c_str(), -1, SQLITE_TRANSIENT);
-        if (r != SQLITE_OK) {
-            throw RtlException(ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db->db)));
-        }
-    }
-    int columns = sqlite3_column_count(stmt);
-    for (;;) {
-        r = sqlite3_step(stmt);
-        if (r == SQLITE_DONE) {
-            break;
-        }
-        if (r == SQLITE_ROW) {
-            std::vector<Cell> row;
-            for (int i = 0; i < columns; i++) {
-                row.push_back(Cell(reinterpret_cast<const char *>(sqlite3_column_text(stmt, i))));
-            }
-            rows.push_back(Cell(row));
-        } else {
-            throw RtlException(ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db->db)));
-        }
-    }
-    sqlite3_finalize(stmt);
+    StatementUse use(db->prepare(sql));
+    sqlite3_stmt *stmt = use.stmt;
+    bind_strings(db, stmt, parameters);
+    step_all(db, stmt, column_text, &rows);
     return Cell(rows);
 }
 
 bool execOne(const std::shared_ptr<Object> &pdb, const utf8string &sql, const std::map<utf8string, utf8string> &parameters, Cell *result)
 {
     DatabaseObject *db = check_database(pdb);
-    sqlite3_stmt *stmt;
-    int r = sqlite3_prepare_v2(db->db, sql.c_str(), -1, &stmt, NULL);
-    if (r != SQLITE_OK) {
-        throw RtlException(ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db->db)));
-    }
-    for (auto p: parameters) {
-        int c = sqlite3_bind_parameter_index(stmt, p.first.c_str());
-        if (c == 0) {
-            throw RtlException(Exception_SqliteException_ParameterName, utf8string(p.first.c_str()));
-        }
-        r = sqlite3_bind_text(stmt, c, p.second.c_str(), -1, SQLITE_TRANSIENT);
-        if (r != SQLITE_OK) {
-            throw RtlException(ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db->db)));
-        }
-    }
+    StatementUse use(db->prepare(sql));
+    sqlite3_stmt *stmt = use.stmt;
+    bind_strings(db, stmt, parameters);
     int columns = sqlite3_column_count(stmt);
-    r = sqlite3_step(stmt);
+    int r = sqlite3_step(stmt);
     if (r == SQLITE_DONE) {
-        //fprintf(stderr, "sqlite no data: %s\n", sql.c_str());
         return false;
     }
-    if (r == SQLITE_ROW) {
-        for (int i = 0; i < columns; i++) {
-            const unsigned char *value = sqlite3_column_text(stmt, i);
-            if (value != nullptr) {
-                result->array_for_write().push_back(Cell(reinterpret_cast<const char *>(value)));
-            } else {
-                result->array_for_write().push_back(Cell(""));
-            }
-        }
-    } else {
+    if (r != SQLITE_ROW) {
         throw RtlException(ne_global::Exception_SqlException, utf8string(sqlite3_errmsg(db->db)));
     }
-    sqlite3_finalize(stmt);
+    for (int i = 0; i < columns; i++) {
+        result->array_for_write().push_back(column_text(stmt, i));
+    }
     return true;
 }
 
+Cell execTyped(const std::shared_ptr<Object> &pdb, const utf8string &sql, std::map<utf8string, std::shared_ptr<Object>> parameters)
+{
+    DatabaseObject *db = check_database(pdb);
+    std::vector<Cell> rows;
+    StatementUse use(db->prepare(sql));
+    sqlite3_stmt *stmt = use.stmt;
+    for (auto &p: parameters) {
+        bind_object(db, stmt, p.first, p.second);
+    }
+    step_all(db, stmt, column_object, &rows);
+    return Cell(rows);
+}
+
+Number execMany(const std::shared_ptr<Object> &pdb, const utf8string &sql, Cell &parameters)
+{
+    DatabaseObject *db = check_database(pdb);
+    Transaction transaction(db->db);
+    int64_t changes = 0;
+    {
+        StatementUse use(db->prepare(sql));
+        sqlite3_stmt *stmt = use.stmt;
+        for (auto &p: parameters.array()) {
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+            for (auto &q: const_cast<Cell &>(p).dictionary()) {
+                bind_object(db, stmt, q.first, const_cast<Cell &>(q.second).object());
+            }
+            step_all(db, stmt, column_object, nullptr);
+            changes += sqlite3_changes(db->db);
+        }
+    }
+    transaction.commit();
+    return number_from_sint64(changes);
+}
+
 Cell execRaw(const std::shared_ptr<Object> &pdb, const utf8string &sql)
 {
     DatabaseObject *db = check_database(pdb);
@@ -150,6 +331,7 @@ Cell execRaw(const std::shared_ptr<Object> &pdb, const utf8string &sql)
 void close(const std::shared_ptr<Object> &pdb)
 {
     DatabaseObject *db = check_database(pdb);
+    db->finalize_statements();
     sqlite3_close(db->db);
     db->db = NULL;
 }
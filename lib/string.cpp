@@ -80,37 +80,37 @@ utf8string quoted(const utf8string &s)
     return r;
 }
 
-std::vector<utf8string> split(const utf8string &ss, const utf8string &dd)
+std::vector<Cell> split(const utf8string &ss, const utf8string &dd)
 {
     const std::string &s = ss.str(); // TODO: utf8
     const std::string &d = dd.str(); // TODO: utf8
-    std::vector<utf8string> r;
+    std::vector<Cell> r;
     std::string::size_type i = 0;
     while (i < s.length()) {
         std::string::size_type nd = s.find(d, i);
         if (nd == std::string::npos) {
-            r.push_back(utf8string(s.substr(i)));
+            r.push_back(Cell(utf8string(s.substr(i))));
             break;
         } else if (nd > i) {
-            r.push_back(utf8string(s.substr(i, nd-i)));
+            r.push_back(Cell(utf8string(s.substr(i, nd-i))));
         }
         i = nd + d.length();
     }
     return r;
 }
 
-std::vector<utf8string> splitLines(const utf8string &ss)
+std::vector<Cell> splitLines(const utf8string &ss)
 {
     const std::string &s = ss.str(); // TODO: utf8
-    std::vector<utf8string> r;
+    std::vector<Cell> r;
     std::string::size_type i = 0;
     while (i < s.length()) {
         std::string::size_type nl = s.find_first_of("\r\n", i);
         if (nl == std::string::npos) {
-            r.push_back(utf8string(s.substr(i)));
+            r.push_back(Cell(utf8string(s.substr(i))));
             break;
         }
-        r.push_back(utf8string(s.substr(i, nl-i)));
+        r.push_back(Cell(utf8string(s.substr(i, nl-i))));
         if (s[nl] == '\r' && nl+1 < s.length() && s[nl+1] == '\n') {
             i = nl + 2;
         } else {
@@ -1321,6 +1321,29 @@ Ne_Exception *Ne_builtin_string__length(Ne_Number *result, const Ne_String *str)
     return NULL;
 }
 
+Ne_Exception *Ne_builtin_string__nextCharacter(Ne_String *result, Ne_String *str, Ne_Number *offset)
+{
+    int i = (int)offset->dval;
+    if (i >= str->len) {
+        Ne_String_init_literal(result, "");
+        return NULL;
+    }
+    unsigned char c = str->ptr[i];
+    int n = (c & 0x80) == 0x00 ? 1
+          : (c & 0xe0) == 0xc0 ? 2
+          : (c & 0xf0) == 0xe0 ? 3
+          : (c & 0xf8) == 0xf0 ? 4
+          : 1;
+    if (i + n > str->len) {
+        n = str->len - i;
+    }
+    result->ptr = malloc(n);
+    memcpy(result->ptr, str->ptr + i, n);
+    result->len = n;
+    offset->dval = i + n;
+    return NULL;
+}
+
 Ne_Exception *Ne_builtin_string__encodeUTF8(Ne_Bytes *result, const Ne_String *str)
 {
     result->data = malloc(str->len);
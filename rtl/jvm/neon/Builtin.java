@@ -373,6 +373,23 @@ public class Builtin {
         return new neon.type.Number(s.length());
     }
 
+    public static Object[] string__nextCharacter(java.lang.String self, neon.type.Number offset) {
+        int i = offset.intValue();
+        if (i >= self.length()) {
+            return new Object[] {
+                "",
+                self,
+                offset
+            };
+        }
+        int n = Character.charCount(self.codePointAt(i));
+        return new Object[] {
+            self.substring(i, i + n),
+            self,
+            new neon.type.Number(i + n)
+        };
+    }
+
     public static java.lang.String string__splice(java.lang.String t, java.lang.String s, neon.type.Number first, boolean first_from_end, neon.type.Number last, boolean last_from_end) {
         int f = first.intValue();
         int l = last.intValue();
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+
+# Compare the run time of the threaded (computed goto) instruction
+# dispatch in the C++ executor with the plain switch dispatch.
+#
+# Usage: scripts/benchmark_dispatch.py [-n repeat] [neon] [sample.neon ...]
+#
+# samples/benchmark/whetstone.neon is not in the default list because
+# it takes much longer than the others; name it explicitly to include it.
+
+import os
+import subprocess
+import sys
+import time
+
+DEFAULT_SAMPLES = [
+    "samples/benchmark/dhrystone.neon",
+    "samples/99-bottles/99-bottles.neon",
+    "samples/fizzbuzz/fizzbuzz.neon",
+    "samples/quine/quine.neon",
+    "samples/sieve/sieve.neon",
+]
+
+def run(neon, options, fn):
+    start = time.perf_counter()
+    subprocess.check_call([neon] + options + [fn], stdout=subprocess.DEVNULL)
+    return time.perf_counter() - start
+
+def best(neon, options, fn, repeat):
+    return min(run(neon, options, fn) for _ in range(repeat))
+
+def main():
+    args = sys.argv[1:]
+    repeat = 3
+    if args[:1] == ["-n"]:
+        repeat = int(args[1])
+        args = args[2:]
+    neon = "bin/neon"
+    if args and not args[0].endswith(".neon"):
+        neon = args[0]
+        args = args[1:]
+    samples = args or DEFAULT_SAMPLES
+
+    print("{:40} {:>10} {:>10} {:>8}".format("sample", "switch", "threaded", "speedup"))
+    total_switch = 0
+    total_threaded = 0
+    for fn in samples:
+        if not os.path.exists(fn):
+            print("{:40} not found".format(fn))
+            continue
+        # Run once first so that any .neonx files are already up to date.
+        run(neon, [], fn)
+        t_switch = best(neon, ["--no-threaded-dispatch"], fn, repeat)
+        t_threaded = best(neon, [], fn, repeat)
+        total_switch += t_switch
+        total_threaded += t_threaded
+        print("{:40} {:10.3f} {:10.3f} {:7.2f}x".format(fn, t_switch, t_threaded, t_switch / t_threaded))
+    if total_threaded > 0:
+        print("{:40} {:10.3f} {:10.3f} {:7.2f}x".format("total", total_switch, total_threaded, total_switch / total_threaded))
+
+main()
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+
+# Compare the start up time of the C++ executor without the compiled
+# module cache, with an empty cache (cold), and with a cache that already
+# holds the program (warm). The samples are short programs, so the time
+# is mostly spent before the first instruction runs.
+#
+# Usage: scripts/benchmark_startup.py [-n repeat] [neon] [sample.neon ...]
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+DEFAULT_SAMPLES = [
+    "samples/hello/hello.neon",
+    "samples/99-bottles/99-bottles.neon",
+    "samples/fizzbuzz/fizzbuzz.neon",
+    "samples/cal/cal.neon",
+    "samples/lisp/lisp.neon",
+]
+
+def run(neon, options, fn, cachedir):
+    env = dict(os.environ)
+    env.pop("NEONCACHE", None)
+    if cachedir is not None:
+        env["NEONCACHE"] = cachedir
+    start = time.perf_counter()
+    subprocess.check_call([neon] + options + [fn], stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL, env=env)
+    return time.perf_counter() - start
+
+def cold(neon, fn, cachedir):
+    shutil.rmtree(cachedir, ignore_errors=True)
+    return run(neon, [], fn, cachedir)
+
+def main():
+    args = sys.argv[1:]
+    repeat = 5
+    if args[:1] == ["-n"]:
+        repeat = int(args[1])
+        args = args[2:]
+    neon = "bin/neon"
+    if args and not args[0].endswith(".neon"):
+        neon = args[0]
+        args = args[1:]
+    samples = args or DEFAULT_SAMPLES
+
+    cachedir = os.path.join(tempfile.mkdtemp(), "cache")
+    print("{:40} {:>10} {:>10} {:>10} {:>8}".format("sample", "no cache", "cold", "warm", "speedup"))
+    for fn in samples:
+        if not os.path.exists(fn):
+            print("{:40} not found".format(fn))
+            continue
+        # Run once first so that any .neonx files for imports are already up to date.
+        run(neon, [], fn, None)
+        t_none = min(run(neon, ["--no-cache"], fn, cachedir) for _ in range(repeat))
+        t_cold = min(cold(neon, fn, cachedir) for _ in range(repeat))
+        t_warm = min(run(neon, [], fn, cachedir) for _ in range(repeat))
+        print("{:40} {:10.3f} {:10.3f} {:10.3f} {:7.2f}x".format(fn, t_none, t_cold, t_warm, t_none / t_warm))
+    shutil.rmtree(os.path.dirname(cachedir), ignore_errors=True)
+
+main()
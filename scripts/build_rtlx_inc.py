@@ -1,20 +1,20 @@
 #!/usr/bin/env python3
 
+# Embed compiled standard library modules (*.neonx) in an executable
+# built with USE_RTLX. See EmbeddedModule in src/support.h.
+
 import os
 import sys
 
 with open("gen/rtlx.inc", "w") as f:
     for fn in sys.argv[1:]:
+        modname = os.path.basename(fn).replace(".neonx", "")
         bytecode = open(fn, "rb").read()
-        print("static const unsigned char bytecode_{}[] = {{{}}};".format(
-            os.path.basename(fn).replace(".neonx", ""),
-            ",".join("0x{:02x}".format(ord(x)) for x in bytecode)
-        ), file=f)
-    print("static struct {", file=f)
-    print("    const char *name;", file=f)
-    print("    size_t length;", file=f)
-    print("    const unsigned char *bytecode;", file=f)
-    print("} rtl_bytecode[] = {", file=f)
+        print("static const unsigned char bytecode_{}[] = {{".format(modname), file=f)
+        for i in range(0, len(bytecode), 16):
+            print("    {},".format(",".join("0x{:02x}".format(x) for x in bytecode[i:i+16])), file=f)
+        print("};", file=f)
+    print("static const EmbeddedModule rtl_bytecode[] = {", file=f)
     for fn in sys.argv[1:]:
         modname = os.path.basename(fn).replace(".neonx", "")
         bytecode = open(fn, "rb").read()
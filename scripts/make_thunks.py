@@ -59,11 +59,11 @@ CppFromAstParam = {
     ("TYPE_OBJECT", VALUE): "std::shared_ptr<Object>",
     ("TYPE_ARRAY", VALUE): "Cell",
     ("TYPE_ARRAY", REF): "Cell *",
-    ("TYPE_ARRAY_NUMBER", VALUE): "std::vector<Number>",
-    ("TYPE_ARRAY_STRING", VALUE): "std::vector<utf8string>",
-    ("TYPE_ARRAY_STRING", REF): "std::vector<utf8string>",
-    ("TYPE_ARRAY_STRING", OUT): "std::vector<utf8string>",
-    ("TYPE_ARRAY_OBJECT", VALUE): "std::vector<std::shared_ptr<Object>>",
+    ("TYPE_ARRAY_NUMBER", VALUE): "ArrayView<Number>",
+    ("TYPE_ARRAY_STRING", VALUE): "ArrayView<utf8string>",
+    ("TYPE_ARRAY_STRING", REF): "std::vector<Cell> *",
+    ("TYPE_ARRAY_STRING", OUT): "std::vector<Cell>",
+    ("TYPE_ARRAY_OBJECT", VALUE): "ArrayView<std::shared_ptr<Object>>",
     ("TYPE_DICTIONARY", VALUE): "Cell",
     ("TYPE_DICTIONARY", REF): "Cell *",
     ("TYPE_DICTIONARY_NUMBER", VALUE): "std::map<utf8string, Number>",
@@ -87,10 +87,10 @@ CppFromAstReturn = {
     ("TYPE_BYTES", REF): "std::vector<unsigned char> *",
     ("TYPE_OBJECT", VALUE): "std::shared_ptr<Object>",
     ("TYPE_ARRAY", VALUE): "Cell",
-    ("TYPE_ARRAY_NUMBER", VALUE): "std::vector<Number>",
-    ("TYPE_ARRAY_STRING", VALUE): "std::vector<utf8string>",
-    ("TYPE_ARRAY_STRING", REF): "std::vector<utf8string> *",
-    ("TYPE_ARRAY_OBJECT", VALUE): "std::vector<std::shared_ptr<Object>>",
+    ("TYPE_ARRAY_NUMBER", VALUE): "std::vector<Cell>",
+    ("TYPE_ARRAY_STRING", VALUE): "std::vector<Cell>",
+    ("TYPE_ARRAY_STRING", REF): "std::vector<Cell> *",
+    ("TYPE_ARRAY_OBJECT", VALUE): "std::vector<Cell>",
     ("TYPE_DICTIONARY_OBJECT", VALUE): "std::map<utf8string, std::shared_ptr<Object>>",
 }
 
@@ -115,11 +115,11 @@ CppFromAstArg = {
     ("TYPE_OBJECT", VALUE): "const std::shared_ptr<Object> &",
     ("TYPE_ARRAY", VALUE): "Cell &",
     ("TYPE_ARRAY", REF): "Cell *",
-    ("TYPE_ARRAY_NUMBER", VALUE): "const std::vector<Number> &",
-    ("TYPE_ARRAY_STRING", VALUE): "const std::vector<utf8string> &",
-    ("TYPE_ARRAY_STRING", REF): "std::vector<utf8string> *",
-    ("TYPE_ARRAY_STRING", OUT): "std::vector<utf8string> *",
-    ("TYPE_ARRAY_OBJECT", VALUE): "std::vector<std::shared_ptr<Object>>",
+    ("TYPE_ARRAY_NUMBER", VALUE): "ArrayView<Number>",
+    ("TYPE_ARRAY_STRING", VALUE): "ArrayView<utf8string>",
+    ("TYPE_ARRAY_STRING", REF): "std::vector<Cell> *",
+    ("TYPE_ARRAY_STRING", OUT): "std::vector<Cell> *",
+    ("TYPE_ARRAY_OBJECT", VALUE): "ArrayView<std::shared_ptr<Object>>",
     ("TYPE_DICTIONARY", VALUE): "Cell &",
     ("TYPE_DICTIONARY", REF): "Cell *",
     ("TYPE_DICTIONARY_NUMBER", VALUE): "const std::map<utf8string, Number> &",
@@ -180,10 +180,6 @@ CellField = {
 }
 
 ArrayElementField = {
-    ("TYPE_ARRAY_NUMBER", VALUE): "number()",
-    ("TYPE_ARRAY_STRING", VALUE): "string()",
-    ("TYPE_ARRAY_STRING", REF): "string()",
-    ("TYPE_ARRAY_OBJECT", VALUE): "object()",
     ("TYPE_DICTIONARY_NUMBER", VALUE): "number()",
     ("TYPE_DICTIONARY_STRING", VALUE): "string()",
     ("TYPE_DICTIONARY_OBJECT", VALUE): "object()",
@@ -265,8 +261,10 @@ for fn in sys.argv[1:]:
                         in_enum = name
                     elif atype == "CHOICE":
                         AstFromNeon[name] = ("TYPE_GENERIC", VALUE)
-                        choices[name] = []
-                        in_choice = name
+                        AstFromNeon["INOUT "+name] = ("TYPE_GENERIC", REF)
+                        AstFromNeon["OUT "+name] = ("TYPE_GENERIC", OUT)
+                        choices[(prefix[:-1], name)] = []
+                        in_choice = (prefix[:-1], name)
                     elif atype == "Object":
                         AstFromNeon[name] = ("TYPE_OBJECT", VALUE)
                         AstFromNeon["INOUT "+name] = ("TYPE_OBJECT", REF)
@@ -354,13 +352,12 @@ with open("gen/thunks.inc", "w") as inc:
         d = 0
         for i, a in reversed(list(enumerate(params))):
             from_stack = True
+            # Typed arrays are passed as views of (or pointers to) the
+            # array on the stack, so the elements are never copied.
             if a[0].startswith("TYPE_ARRAY_") and a[1] == VALUE:
-                print("    {} a{};".format(CppFromAstParam[a], i), file=inc)
-                print("    for (auto x: stack.peek({}).array()) a{}.push_back(x.{});".format(d, i, ArrayElementField[a]), file=inc)
+                print("    {} a{}(stack.peek({}).array());".format(CppFromAstParam[a], i, d), file=inc)
             elif a[0].startswith("TYPE_ARRAY_") and a[1] == REF:
-                print("    {} t{};".format(CppFromAstParam[a], i), file=inc)
-                print("    for (auto x: stack.peek({}).address()->array()) t{}.push_back(x.{});".format(d, i, ArrayElementField[a]), file=inc)
-                print("    {} *a{} = &t{};".format(CppFromAstParam[a], i, i), file=inc)
+                print("    {} a{} = &stack.peek({}).address()->array_for_write();".format(CppFromAstParam[a], i, d), file=inc)
             elif a[0].startswith("TYPE_ARRAY_") and a[1] == OUT:
                 print("    {} t{};".format(CppFromAstParam[a], i), file=inc)
                 print("    {} *a{} = &t{};".format(CppFromAstParam[a], i, i), file=inc)
@@ -386,20 +383,13 @@ with open("gen/thunks.inc", "w") as inc:
         assert d == stack_count
         print("    try {", file=inc)
         print("        {}reinterpret_cast<{} (*)({})>(func)({});".format("auto r = " if rtype[0] != "TYPE_NOTHING" else "", CppFromAstReturn[rtype], ",".join(CppFromAstArg[x] for x in params), ",".join("a{}".format(x) for x in range(len(params)))), file=inc)
-        for i, a in reversed(list(enumerate(params))):
-            d = len(params) - 1 - i
-            if a[0].startswith("TYPE_ARRAY_") and a[1] == REF:
-                print("        stack.peek({}).address()->array_for_write().clear();".format(d), file=inc)
-                print("        for (auto x: t{}) stack.peek({}).address()->array_for_write().push_back(Cell(x));".format(i, d), file=inc)
         if params:
             print("        stack.drop({});".format(stack_count), file=inc)
         if rtype[0] != "TYPE_NOTHING":
             if rtype[0].startswith("TYPE_ARRAY_"):
-                print("        std::vector<Cell> t;", file=inc)
-                print("        for (auto x: r) t.push_back(Cell(x));", file=inc)
-                print("        stack.push(Cell(t));", file=inc)
+                print("        stack.push(Cell(std::move(r)));", file=inc)
             elif rtype[0].startswith("TYPE_DICTIONARY_"):
-                print("        std::map<utf8string, Cell> t;", file=inc)
+                print("        HashDictionary<Cell> t;", file=inc)
                 print("        for (auto x: r) t[x.first] = Cell(x.second);", file=inc)
                 print("        stack.push(Cell(t));", file=inc)
             elif rtype[0] == "TYPE_POINTER":
@@ -409,9 +399,7 @@ with open("gen/thunks.inc", "w") as inc:
         for i, a in reversed(list(enumerate(params))):
             if a[1] == OUT:
                 if a[0].startswith("TYPE_ARRAY_"):
-                    print("        std::vector<Cell> o{};".format(i), file=inc)
-                    print("        for (auto x: t{}) o{}.push_back(Cell(x));".format(i, i), file=inc)
-                    print("        stack.push(Cell(o{}));".format(i), file=inc)
+                    print("        stack.push(Cell(std::move(t{})));".format(i), file=inc)
                 else:
                     print("        stack.push(Cell(t{}));".format(i), file=inc)
         print("    } catch (RtlException &) {", file=inc)
@@ -452,7 +440,8 @@ with open("gen/functions_compile.inc", "w") as inc:
     print("    const ast::Type *type;", file=inc)
     print("    const char *modtypename;", file=inc)
     print("};", file=inc)
-    print("static struct {", file=inc)
+    # Refers to the predefined types, which belong to each thread.
+    print("static thread_local struct {", file=inc)
     print("    const char *name;", file=inc)
     print("    PredefinedType returntype;", file=inc)
     print("    bool exported;", file=inc)
@@ -515,13 +504,9 @@ with open("gen/functions_exec.inc", "w") as inc:
         cpp_name[name] = "{}::{}".format(*a)
         print("namespace ne_{} {{ extern {} {}({}); }}".format(a[0], CppFromAstReturn[rtype], a[1], ", ".join(CppFromAstArg[x] for x in params)), file=inc)
     print("}", file=inc)
-    print("static struct {", file=inc)
-    print("    const char *name;", file=inc)
-    print("    Thunk thunk;", file=inc)
-    print("    void *func;", file=inc)
-    print("} BuiltinFunctions[] = {", file=inc)
+    print("static const RtlFunction BuiltinFunctions[] = {", file=inc)
     for name, rtype, rtypename, exported, params, paramtypes, paramnames, variadic in functions.values():
-        print("    {{\"{}\", {}, reinterpret_cast<void *>(rtl::ne_{})}},".format(name, "thunk_{}_{}".format(rtype[0], "_".join("{}_{}".format(p, m) for p, m in params)), cpp_name[name]), file=inc)
+        print("    {{\"{}\", \"{}\", {}, reinterpret_cast<void *>(rtl::ne_{})}},".format(name, name.split("$", 1)[1], "thunk_{}_{}".format(rtype[0], "_".join("{}_{}".format(p, m) for p, m in params)), cpp_name[name]), file=inc)
     print("};", file=inc)
 
 with open("gen/enums.inc", "w") as inc:
@@ -529,10 +514,18 @@ with open("gen/enums.inc", "w") as inc:
         for i, v in enumerate(values):
             print("static const uint32_t ENUM_{}_{} = {};".format(name, v, i), file=inc)
 
+# Several modules declare a choice type with the same name (such as Result),
+# so the constants for those go in the namespace of each module.
 with open("gen/choices.inc", "w") as inc:
-    for name, values in choices.items():
+    names = [name for _, name in choices]
+    for (module, name), values in choices.items():
+        shared = names.count(name) > 1
+        if shared:
+            print("namespace rtl {{ namespace ne_{} {{".format(module), file=inc)
         for i, v in enumerate(values):
             print("static const uint32_t CHOICE_{}_{} = {};".format(name, v, i), file=inc)
+        if shared:
+            print("} }", file=inc)
 
 with open("gen/exceptions.inc", "w") as inc:
     print("struct ExceptionName {", file=inc)
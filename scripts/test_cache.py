@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+
+import os
+import shutil
+import subprocess
+import sys
+
+neon = sys.argv[1]
+
+shutil.rmtree("tmp/cache", ignore_errors=True)
+os.makedirs("tmp/cache/src")
+env = dict(os.environ, NEONCACHE="tmp/cache/modules")
+
+def write(name, text):
+    with open("tmp/cache/src/" + name, "w") as f:
+        f.write(text)
+
+def run(expected):
+    out = subprocess.check_output([neon, "--neonpath", "lib", "tmp/cache/src/main.neon"], env=env, universal_newlines=True)
+    if out != expected:
+        print("{}: Failed: expected {!r}, got {!r}".format(sys.argv[0], expected, out), file=sys.stderr)
+        sys.exit(1)
+
+write("main.neon", "IMPORT helper\nprint(helper.greeting)\n")
+write("helper.neon", "EXPORT CONSTANT greeting: String := \"hello\"\n")
+run("hello\n")
+if not any(n.endswith(".neonx") for n in os.listdir("tmp/cache/modules")):
+    print("{}: Failed: nothing written to cache".format(sys.argv[0]), file=sys.stderr)
+    sys.exit(1)
+run("hello\n")
+
+# Changing an imported module must not use the cached main program.
+write("helper.neon", "EXPORT CONSTANT greeting: String := \"goodbye\"\n")
+run("goodbye\n")
+
+def remove_bytecode():
+    for n in os.listdir("tmp/cache/src"):
+        if n.endswith(".neonx"):
+            os.remove("tmp/cache/src/" + n)
+
+# A cached module must not be used once a module it imports has changed.
+write("main.neon", "IMPORT a\nprint(a.value())\n")
+write("a.neon", "IMPORT b\nEXPORT FUNCTION value(): Number\n    RETURN b.kval\nEND FUNCTION\n")
+write("b.neon", "EXPORT CONSTANT kval: Number := 1\n")
+run("1\n")
+write("b.neon", "EXPORT CONSTANT kval: Number := 2\n")
+remove_bytecode()
+run("2\n")
+
+# Nor once a file it embeds has changed.
+write("main.neon", "IMPORT c\nprint(c.text())\n")
+write("c.neon", "EXPORT FUNCTION text(): String\n    RETURN (EMBED \"c.txt\").decodeUTF8().expectString()\nEND FUNCTION\n")
+write("c.txt", "first")
+run("first\n")
+write("c.txt", "second")
+remove_bytecode()
+run("second\n")
@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+
+import os
+import shutil
+import subprocess
+import sys
+
+neonc = sys.argv[1]
+neonx = sys.argv[2]
+
+shutil.rmtree("tmp/parallel", ignore_errors=True)
+os.makedirs("tmp/parallel")
+
+def write(name, text):
+    with open("tmp/parallel/" + name, "w") as f:
+        f.write(text)
+
+# main imports four modules, and d imports two of the others, all of which
+# import base (a diamond below a fan-out).
+write("base.neon", "EXPORT FUNCTION value(): Number\n    RETURN 1\nEND FUNCTION\n")
+write("a.neon", "IMPORT base\nEXPORT FUNCTION value(): Number\n    RETURN base.value() + 10\nEND FUNCTION\n")
+write("b.neon", "IMPORT base\nEXPORT FUNCTION value(): Number\n    RETURN base.value() + 100\nEND FUNCTION\n")
+write("c.neon", "IMPORT base\nEXPORT FUNCTION value(): Number\n    RETURN base.value() + 1000\nEND FUNCTION\n")
+write("d.neon", "IMPORT a\nIMPORT b\nEXPORT FUNCTION value(): Number\n    RETURN a.value() + b.value()\nEND FUNCTION\n")
+write("main.neon", "IMPORT a\nIMPORT b\nIMPORT c\nIMPORT d\nprint(\"\\(a.value() + b.value() + c.value() + d.value())\")\n")
+
+modules = ["base", "a", "b", "c", "d", "main"]
+
+def build(jobs):
+    for m in modules:
+        try:
+            os.remove("tmp/parallel/{}.neonx".format(m))
+        except FileNotFoundError:
+            pass
+    env = dict(os.environ, NEONJOBS=str(jobs))
+    subprocess.check_call([neonc, "-q", "tmp/parallel/main.neon"], env=env)
+    out = subprocess.check_output([neonx, "tmp/parallel/main.neonx"], universal_newlines=True)
+    if out != "1225\n":
+        print("{}: Failed: NEONJOBS={} printed {!r}".format(sys.argv[0], jobs, out), file=sys.stderr)
+        sys.exit(1)
+    r = {}
+    for m in modules:
+        with open("tmp/parallel/{}.neonx".format(m), "rb") as f:
+            r[m] = f.read()
+    return r
+
+serial = build(1)
+for jobs in [2, 4, 8]:
+    if build(jobs) != serial:
+        print("{}: Failed: NEONJOBS={} output differs from a serial build".format(sys.argv[0], jobs), file=sys.stderr)
+        sys.exit(1)
@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+
+import os
+import re
+import subprocess
+import sys
+
+neon = sys.argv[1]
+
+os.makedirs("tmp", exist_ok=True)
+with open("tmp/profile.neon", "w") as f:
+    f.write("""
+FUNCTION factorial(x: Number): Number
+    IF x = 0 THEN
+        RETURN 1
+    END IF
+    RETURN x * factorial(x - 1)
+END FUNCTION
+
+VAR s: Number := 0
+FOR i := 1 TO 10000 DO
+    s := s + factorial(10)
+END FOR
+print(str(s))
+""")
+if os.path.exists("tmp/profile.folded"):
+    os.remove("tmp/profile.folded")
+
+p = subprocess.run([neon, "--profile", "tmp/profile.neon"], stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+sys.stderr.write(p.stderr)
+if p.returncode != 0:
+    sys.exit(p.returncode)
+for expected in ["Profile: ", "CALLF", "factorial", "tmp/profile.neon:"]:
+    if expected not in p.stderr:
+        print("{}: Failed: expected {} in profile".format(sys.argv[0], expected), file=sys.stderr)
+        sys.exit(1)
+
+with open("tmp/profile.folded") as f:
+    stacks = f.readlines()
+if not any(s.startswith("(main);factorial;factorial ") for s in stacks):
+    print("{}: Failed: expected recursive stack in collapsed stacks".format(sys.argv[0]), file=sys.stderr)
+    sys.exit(1)
+for s in stacks:
+    if not re.match(r"\S+ \d+$", s):
+        print("{}: Failed: unexpected collapsed stack line: {}".format(sys.argv[0], s), file=sys.stderr)
+        sys.exit(1)
@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+
+import os
+import shutil
+import subprocess
+import sys
+
+make_thunks = os.path.abspath("scripts/make_thunks.py")
+
+shutil.rmtree("tmp/thunks", ignore_errors=True)
+os.makedirs("tmp/thunks/gen")
+
+# A native function can take a CHOICE type declared in the same module
+# as an INOUT or OUT parameter, as json.decoderNext does.
+with open("tmp/thunks/sample.neon", "w") as f:
+    f.write("""TYPE Result IS CHOICE
+    value: Number
+    error: String
+END CHOICE
+
+DECLARE NATIVE FUNCTION fill(OUT result: Result): Boolean
+DECLARE NATIVE FUNCTION update(INOUT result: Result)
+""")
+
+subprocess.check_call([sys.executable, make_thunks, "sample.neon"], cwd="tmp/thunks")
+
+with open("tmp/thunks/gen/functions_exec.inc") as f:
+    functions = f.read()
+for name, thunk in [
+    ("fill", "thunk_TYPE_BOOLEAN_TYPE_GENERIC_OUT"),
+    ("update", "thunk_TYPE_NOTHING_TYPE_GENERIC_REF"),
+]:
+    if '{{"sample${}", "{}", {},'.format(name, name, thunk) not in functions:
+        print("{}: Failed: expected sample${} to use {}".format(sys.argv[0], name, thunk), file=sys.stderr)
+        sys.exit(1)
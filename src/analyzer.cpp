@@ -1126,7 +1126,7 @@ std::function<const ast::Expression *(Analyzer *analyzer, const ast::Expression
             );
         };
     }
-    if (from == TYPE_OBJECT) {
+    if (from == TYPE_OBJECT || from == this) {
         return identity_conversion;
     }
     const TypeArray *atype = dynamic_cast<const TypeArray *>(from);
@@ -1811,7 +1811,9 @@ std::string Analyzer::extract_module_name(const pt::Program *program)
 
 ast::Module *Analyzer::import_module(const Token &token, const std::string &name, bool optional)
 {
-    static std::vector<std::string> s_importing;
+    // The modules being imported on this thread, innermost last. Loading a
+    // module may compile it, which imports its own modules in turn.
+    static thread_local std::vector<std::string> s_importing;
 
     auto m = modules.find(name);
     if (m != modules.end()) {
@@ -1820,7 +1822,14 @@ ast::Module *Analyzer::import_module(const Token &token, const std::string &name
     if (std::find(s_importing.begin(), s_importing.end(), name) != s_importing.end()) {
         error(3181, token, "recursive import detected: " + name);
     }
-    s_importing.push_back(name);
+    // Popped however this returns, since a failed import can be caught
+    // and the thread reused to compile another module.
+    struct Importing {
+        explicit Importing(const std::string &module) { s_importing.push_back(module); }
+        ~Importing() { s_importing.pop_back(); }
+        Importing(const Importing &) = delete;
+        Importing &operator=(const Importing &) = delete;
+    } importing(name);
     Bytecode object;
     try {
         support->loadBytecode(name, object);
@@ -1925,7 +1934,6 @@ ast::Module *Analyzer::import_module(const Token &token, const std::string &name
             module->scope->addName(Token(IDENTIFIER, ""), object.strtable[e.name], new ast::Exception(Token(), object.strtable[e.name]));
         }
     }
-    s_importing.pop_back();
     rtl_import(name, module);
     modules[name] = module;
     return module;
@@ -6204,6 +6212,18 @@ const ast::Statement *Analyzer::analyze(const pt::ForeachStatement *statement)
         error2(3169, var_name, "duplicate identifier", scope.top()->getDeclaration(var_name.text), "first declaration here");
     }
     const ast::Expression *array = analyze(statement->array.get());
+    // A range literal with a constant step is iterated with a counter,
+    // instead of building the whole array first.
+    const ast::FunctionCall *range = dynamic_cast<const ast::FunctionCall *>(array);
+    if (range != nullptr) {
+        const ast::VariableExpression *func = dynamic_cast<const ast::VariableExpression *>(range->func);
+        if (func == nullptr
+         || func->var != scope.top()->lookupName("builtin$array__range")
+         || not range->args[2]->is_constant
+         || number_is_zero(range->args[2]->eval_number(statement->array->token))) {
+            range = nullptr;
+        }
+    }
     const ast::TypeArray *arrtype = dynamic_cast<const ast::TypeArray *>(array->type);
     const ast::Type *strtype = dynamic_cast<const ast::TypeString *>(array->type);
     const ast::Type *atype;
@@ -6231,7 +6251,7 @@ const ast::Statement *Analyzer::analyze(const pt::ForeachStatement *statement)
     } else {
         error(3170, statement->array->token, "array or string expected");
     }
-    ast::Variable *array_copy = scope.top()->makeTemporary(atype);
+    ast::Variable *array_copy = range == nullptr ? scope.top()->makeTemporary(atype) : nullptr;
 
     ast::Variable *var = frame.top()->createVariable(var_name, var_name.text, elementtype, false);
     scope.top()->addName(var->declaration, var->name, var, true);
@@ -6261,6 +6281,86 @@ const ast::Statement *Analyzer::analyze(const pt::ForeachStatement *statement)
         scope.top()->addName(statement->label, statement->label.text, new ast::LoopLabel(statement->label));
     }
     loops.top().push_back(LoopInfo(statement->label.text, loop_id));
+    if (range != nullptr) {
+        std::vector<const ast::Statement *> init_statements {
+            new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(index) }, new ast::ConstantNumberExpression(number_from_uint32(0))),
+            new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(var) }, range->args[0]),
+            new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(bound) }, range->args[1]),
+        };
+        std::vector<const ast::Statement *> statements {
+            new ast::IfStatement(
+                statement->token,
+                std::vector<ast::IfStatement::ConditionBlock> {
+                    ast::IfStatement::ConditionBlock(
+                        statement->token.line,
+                        new ast::NumericComparisonExpression(
+                            new ast::VariableExpression(var),
+                            new ast::VariableExpression(bound),
+                            number_is_negative(range->args[2]->eval_number(statement->array->token)) ? ast::ComparisonExpression::Comparison::LT : ast::ComparisonExpression::Comparison::GT
+                        ),
+                        std::vector<const ast::Statement *> { new ast::ExitStatement(statement->token, loop_id) }
+                    ),
+                },
+                std::vector<const ast::Statement *>()
+            ),
+        };
+        std::vector<const ast::Statement *> body = analyze(statement->body);
+        std::copy(body.begin(), body.end(), std::back_inserter(statements));
+        std::vector<const ast::Statement *> tail_statements {
+            new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(var) }, new ast::AdditionExpression(new ast::VariableExpression(var), range->args[2])),
+            new ast::IncrementStatement(statement->token, new ast::VariableExpression(index), 1),
+        };
+        scope.pop();
+        bool has_exit = loops.top().back().has_exit;
+        loops.top().pop_back();
+        var->is_readonly = false;
+        return new ast::BaseLoopStatement(statement->token, loop_id, init_statements, statements, tail_statements, false, has_exit);
+    }
+    if (strtype != nullptr) {
+        // A string is walked with a cursor that the executor advances by
+        // one character each time, instead of locating the character at
+        // each index from the start of the string. The cursor returns an
+        // empty string once it has reached the end.
+        ast::Variable *offset = scope.top()->makeTemporary(ast::TYPE_NUMBER);
+        std::vector<const ast::Statement *> init_statements {
+            new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(index) }, new ast::ConstantNumberExpression(number_from_uint32(0))),
+            new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(array_copy) }, array),
+            new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(offset) }, new ast::ConstantNumberExpression(number_from_uint32(0))),
+        };
+        std::vector<const ast::Statement *> statements {
+            new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(var) },
+                new ast::FunctionCall(
+                    new ast::VariableExpression(dynamic_cast<const ast::Variable *>(global_scope->lookupName("builtin$string__nextCharacter"))),
+                    { new ast::VariableExpression(array_copy), new ast::VariableExpression(offset) }
+                )
+            ),
+            new ast::IfStatement(
+                statement->token,
+                std::vector<ast::IfStatement::ConditionBlock> {
+                    ast::IfStatement::ConditionBlock(
+                        statement->token.line,
+                        new ast::StringComparisonExpression(
+                            new ast::VariableExpression(var),
+                            new ast::ConstantStringExpression(utf8string("")),
+                            ast::ComparisonExpression::Comparison::EQ
+                        ),
+                        std::vector<const ast::Statement *> { new ast::ExitStatement(statement->token, loop_id) }
+                    ),
+                },
+                std::vector<const ast::Statement *>()
+            ),
+        };
+        std::vector<const ast::Statement *> body = analyze(statement->body);
+        std::copy(body.begin(), body.end(), std::back_inserter(statements));
+        std::vector<const ast::Statement *> tail_statements {
+            new ast::IncrementStatement(statement->token, new ast::VariableExpression(index), 1),
+        };
+        scope.pop();
+        bool has_exit = loops.top().back().has_exit;
+        loops.top().pop_back();
+        var->is_readonly = false;
+        return new ast::BaseLoopStatement(statement->token, loop_id, init_statements, statements, tail_statements, false, has_exit);
+    }
     std::vector<const ast::Statement *> init_statements {
         new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(index) }, new ast::ConstantNumberExpression(number_from_uint32(0))),
         new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(array_copy) }, array),
@@ -7043,6 +7143,10 @@ private:
 
 const ast::Program *Analyzer::analyze()
 {
+    // Bring every module this program imports up to date first, so that
+    // stale modules can be compiled side by side instead of one at a time
+    // as each import is reached.
+    support->prepareImports(module_name, program);
     ast::Program *r = new ast::Program(program->source_path, program->source_hash, module_name);
     global_scope = r->scope;
     frame.push(r->frame);
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <iso646.h>
+#include <memory>
 #include <sstream>
 #include <string.h>
 
@@ -12,23 +13,46 @@
 
 namespace ast {
 
-TypeNothing *TYPE_NOTHING = new TypeNothing();
-TypeDummy *TYPE_DUMMY = new TypeDummy();
-TypeBoolean *TYPE_BOOLEAN = new TypeBoolean();
-TypeNumber *TYPE_NUMBER = new TypeNumber(Token());
-TypeString *TYPE_STRING = new TypeString();
-TypeBytes *TYPE_BYTES = new TypeBytes();
-TypeObject *TYPE_OBJECT = new TypeObject();
-TypeArray *TYPE_ARRAY_NUMBER = new TypeArray(Token(), TYPE_NUMBER);
-TypeArray *TYPE_ARRAY_STRING = new TypeArray(Token(), TYPE_STRING);
-TypeArray *TYPE_ARRAY_OBJECT = new TypeArray(Token(), TYPE_OBJECT);
-TypeDictionary *TYPE_DICTIONARY_NUMBER = new TypeDictionary(Token(), TYPE_NUMBER);
-TypeDictionary *TYPE_DICTIONARY_STRING = new TypeDictionary(Token(), TYPE_STRING);
-TypeDictionary *TYPE_DICTIONARY_OBJECT = new TypeDictionary(Token(), TYPE_OBJECT);
-TypeModule *TYPE_MODULE = new TypeModule();
-TypeException *TYPE_EXCEPTION = new TypeException();
-TypeInterface *TYPE_INTERFACE = new TypeInterface();
-Module *MODULE_MISSING = new Module(Token(), new Scope(nullptr, nullptr), "", false);
+// The predefined types are shared by every program that is compiled, and
+// they keep state for the compile that is in progress (such as their
+// predeclared flags and their methods). Each thread gets its own set so
+// that modules can be compiled on more than one thread at once, and the
+// set is freed when the thread exits.
+static thread_local std::unique_ptr<TypeNothing> type_nothing(new TypeNothing());
+thread_local TypeNothing *TYPE_NOTHING = type_nothing.get();
+static thread_local std::unique_ptr<TypeDummy> type_dummy(new TypeDummy());
+thread_local TypeDummy *TYPE_DUMMY = type_dummy.get();
+static thread_local std::unique_ptr<TypeBoolean> type_boolean(new TypeBoolean());
+thread_local TypeBoolean *TYPE_BOOLEAN = type_boolean.get();
+static thread_local std::unique_ptr<TypeNumber> type_number(new TypeNumber(Token()));
+thread_local TypeNumber *TYPE_NUMBER = type_number.get();
+static thread_local std::unique_ptr<TypeString> type_string(new TypeString());
+thread_local TypeString *TYPE_STRING = type_string.get();
+static thread_local std::unique_ptr<TypeBytes> type_bytes(new TypeBytes());
+thread_local TypeBytes *TYPE_BYTES = type_bytes.get();
+static thread_local std::unique_ptr<TypeObject> type_object(new TypeObject());
+thread_local TypeObject *TYPE_OBJECT = type_object.get();
+static thread_local std::unique_ptr<TypeArray> type_array_number(new TypeArray(Token(), TYPE_NUMBER));
+thread_local TypeArray *TYPE_ARRAY_NUMBER = type_array_number.get();
+static thread_local std::unique_ptr<TypeArray> type_array_string(new TypeArray(Token(), TYPE_STRING));
+thread_local TypeArray *TYPE_ARRAY_STRING = type_array_string.get();
+static thread_local std::unique_ptr<TypeArray> type_array_object(new TypeArray(Token(), TYPE_OBJECT));
+thread_local TypeArray *TYPE_ARRAY_OBJECT = type_array_object.get();
+static thread_local std::unique_ptr<TypeDictionary> type_dictionary_number(new TypeDictionary(Token(), TYPE_NUMBER));
+thread_local TypeDictionary *TYPE_DICTIONARY_NUMBER = type_dictionary_number.get();
+static thread_local std::unique_ptr<TypeDictionary> type_dictionary_string(new TypeDictionary(Token(), TYPE_STRING));
+thread_local TypeDictionary *TYPE_DICTIONARY_STRING = type_dictionary_string.get();
+static thread_local std::unique_ptr<TypeDictionary> type_dictionary_object(new TypeDictionary(Token(), TYPE_OBJECT));
+thread_local TypeDictionary *TYPE_DICTIONARY_OBJECT = type_dictionary_object.get();
+static thread_local std::unique_ptr<TypeModule> type_module(new TypeModule());
+thread_local TypeModule *TYPE_MODULE = type_module.get();
+static thread_local std::unique_ptr<TypeException> type_exception(new TypeException());
+thread_local TypeException *TYPE_EXCEPTION = type_exception.get();
+static thread_local std::unique_ptr<TypeInterface> type_interface(new TypeInterface());
+thread_local TypeInterface *TYPE_INTERFACE = type_interface.get();
+static thread_local std::unique_ptr<Scope> module_missing_scope(new Scope(nullptr, nullptr));
+static thread_local std::unique_ptr<Module> module_missing(new Module(Token(), module_missing_scope.get(), "", false));
+thread_local Module *MODULE_MISSING = module_missing.get();
 
 void AstNode::dump(std::ostream &out, int depth) const
 {
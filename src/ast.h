@@ -361,7 +361,7 @@ public:
     virtual std::string text() const override { return "TypeNothing"; }
 };
 
-extern TypeNothing *TYPE_NOTHING;
+extern thread_local TypeNothing *TYPE_NOTHING;
 
 class TypeDummy: public Type {
 public:
@@ -380,7 +380,7 @@ public:
     virtual std::string text() const override { return "TypeDummy"; }
 };
 
-extern TypeDummy *TYPE_DUMMY;
+extern thread_local TypeDummy *TYPE_DUMMY;
 
 class TypeBoolean: public Type {
 public:
@@ -399,7 +399,7 @@ public:
     virtual std::string text() const override { return "TypeBoolean"; }
 };
 
-extern TypeBoolean *TYPE_BOOLEAN;
+extern thread_local TypeBoolean *TYPE_BOOLEAN;
 
 class TypeNumber: public Type {
 public:
@@ -419,7 +419,7 @@ public:
     virtual std::string text() const override { return "TypeNumber"; }
 };
 
-extern TypeNumber *TYPE_NUMBER;
+extern thread_local TypeNumber *TYPE_NUMBER;
 
 class TypeString: public Type {
 public:
@@ -440,7 +440,7 @@ public:
     virtual std::string text() const override { return "TypeString"; }
 };
 
-extern TypeString *TYPE_STRING;
+extern thread_local TypeString *TYPE_STRING;
 
 class TypeBytes: public Type {
 public:
@@ -460,7 +460,7 @@ public:
     virtual std::string text() const override { return "TypeBytes"; }
 };
 
-extern TypeBytes *TYPE_BYTES;
+extern thread_local TypeBytes *TYPE_BYTES;
 
 class TypeObject: public Type {
 public:
@@ -481,7 +481,7 @@ public:
     virtual std::string text() const override { return "TypeObject"; }
 };
 
-extern TypeObject *TYPE_OBJECT;
+extern thread_local TypeObject *TYPE_OBJECT;
 
 class ParameterType {
 public:
@@ -565,9 +565,9 @@ public:
     virtual std::string text() const override { return "TypeArray(" + (elementtype != nullptr ? elementtype->text() : "any") + ")"; }
 };
 
-extern TypeArray *TYPE_ARRAY_NUMBER;
-extern TypeArray *TYPE_ARRAY_STRING;
-extern TypeArray *TYPE_ARRAY_OBJECT;
+extern thread_local TypeArray *TYPE_ARRAY_NUMBER;
+extern thread_local TypeArray *TYPE_ARRAY_STRING;
+extern thread_local TypeArray *TYPE_ARRAY_OBJECT;
 
 class TypeArrayLiteral: public TypeArray {
 public:
@@ -601,9 +601,9 @@ public:
     virtual std::string text() const override { return "TypeDictionary(" + (elementtype != nullptr ? elementtype->text() : "any") + ")"; }
 };
 
-extern TypeDictionary *TYPE_DICTIONARY_NUMBER;
-extern TypeDictionary *TYPE_DICTIONARY_STRING;
-extern TypeDictionary *TYPE_DICTIONARY_OBJECT;
+extern thread_local TypeDictionary *TYPE_DICTIONARY_NUMBER;
+extern thread_local TypeDictionary *TYPE_DICTIONARY_STRING;
+extern thread_local TypeDictionary *TYPE_DICTIONARY_OBJECT;
 
 class TypeDictionaryLiteral: public TypeDictionary {
 public:
@@ -837,7 +837,7 @@ public:
     virtual std::string text() const override { return "TypeModule(...)"; }
 };
 
-extern TypeModule *TYPE_MODULE;
+extern thread_local TypeModule *TYPE_MODULE;
 
 class TypeException: public Type {
 public:
@@ -856,7 +856,7 @@ public:
     virtual std::string text() const override { return "TypeException"; }
 };
 
-extern TypeException *TYPE_EXCEPTION;
+extern thread_local TypeException *TYPE_EXCEPTION;
 
 class TypeInterface: public Type {
 public:
@@ -875,7 +875,7 @@ public:
     virtual std::string text() const override { return "TypeInterface"; }
 };
 
-extern TypeInterface *TYPE_INTERFACE;
+extern thread_local TypeInterface *TYPE_INTERFACE;
 
 class LoopLabel: public Name {
 public:
@@ -3145,7 +3145,7 @@ public:
     virtual std::string text() const override { return "Module"; }
 };
 
-extern Module *MODULE_MISSING;
+extern thread_local Module *MODULE_MISSING;
 
 class Program: public AstNode {
 public:
@@ -0,0 +1,45 @@
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "atomic_file.h"
+
+#include <atomic>
+#include <fstream>
+#include <iso646.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+bool write_file_atomically(const std::string &name, const void *data, size_t size)
+{
+    // The serial number keeps the temporary names of threads writing the
+    // same file apart, and the process id those of other processes.
+    static std::atomic<unsigned int> serial(0);
+    const std::string tmpname = name + "." + std::to_string(getpid()) + "-" + std::to_string(serial++) + ".tmp";
+    {
+        std::ofstream f(tmpname, std::ios::binary);
+        if (not f) {
+            return false;
+        }
+        f.write(static_cast<const char *>(data), size);
+        f.close();
+        if (not f) {
+            remove(tmpname.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    remove(name.c_str());
+#endif
+    if (rename(tmpname.c_str(), name.c_str()) != 0) {
+        remove(tmpname.c_str());
+        return false;
+    }
+    return true;
+}
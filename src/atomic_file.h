@@ -0,0 +1,13 @@
+#ifndef ATOMIC_FILE_H
+#define ATOMIC_FILE_H
+
+#include <stddef.h>
+#include <string>
+
+// Write a file under a temporary name next to it and then rename it into
+// place, so that another process or thread reading the file at the same
+// time never sees it partly written. Returns false, leaving any existing
+// file alone, if any part of this fails.
+bool write_file_atomically(const std::string &name, const void *data, size_t size);
+
+#endif
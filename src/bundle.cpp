@@ -1,10 +1,11 @@
 #include "bundle.h"
 
-#include <fstream>
 #include <iostream>
 #include <iso646.h>
 #include <map>
-#include <sstream>
+#include <memory>
+#include <stdint.h>
+#include <string.h>
 #include <vector>
 
 #include <unzip.h>
@@ -13,31 +14,52 @@
 #include "exec.h"
 #include "support.h"
 
-std::map<std::string, std::vector<unsigned char>> g_Contents;
+namespace {
 
-class ZipSupport: public ICompilerSupport {
+// A module inside a mapped indexed bundle.
+class BundledImage: public BytecodeImage {
+public:
+    BundledImage(std::shared_ptr<const BytecodeImage> bundle, size_t offset, size_t a_length): bundle(bundle) {
+        bytes = bundle->data() + offset;
+        length = a_length;
+    }
+    const std::shared_ptr<const BytecodeImage> bundle;
+};
+
+class IndexedSupport: public ICompilerSupport {
 public:
+    IndexedSupport(): modules() {}
     virtual void loadBytecode(const std::string &module, Bytecode &bytecode) override;
     virtual void writeOutput(const std::string &, const std::vector<unsigned char> &) override {}
+    std::map<std::string, std::shared_ptr<const BytecodeImage>> modules;
 };
 
-void ZipSupport::loadBytecode(const std::string &module, Bytecode &bytecode)
+void IndexedSupport::loadBytecode(const std::string &module, Bytecode &bytecode)
 {
-    const std::string module_name = module + ".neonx";
-    auto i = g_Contents.find(module_name);
-    if (i == g_Contents.end()) {
+    auto i = modules.find(module);
+    if (i == modules.end()) {
         throw BytecodeException("file not found");
     }
-    bytecode.load(module_name, i->second);
+    bytecode.load(module + ".neonx", i->second);
 }
 
-void run_from_bundle(const std::string &name, bool enable_assert, unsigned short debug_port, int argc, char *argv[])
+// Modules in a zip bundle are only inflated when they are imported.
+class ZipSupport: public ICompilerSupport {
+public:
+    explicit ZipSupport(unzFile zip);
+    ZipSupport(const ZipSupport &) = delete;
+    ZipSupport &operator=(const ZipSupport &) = delete;
+    virtual void loadBytecode(const std::string &module, Bytecode &bytecode) override;
+    virtual void writeOutput(const std::string &, const std::vector<unsigned char> &) override {}
+    std::vector<unsigned char> read(const std::string &filename);
+    unzFile zip;
+    std::map<std::string, unz_file_pos> entries;
+};
+
+ZipSupport::ZipSupport(unzFile zip)
+  : zip(zip),
+    entries()
 {
-    unzFile zip = unzOpen(name.c_str());
-    if (zip == NULL) {
-        fprintf(stderr, "zip open error\n");
-        exit(1);
-    }
     int r = unzGoToFirstFile(zip);
     if (r != UNZ_OK) {
         fprintf(stderr, "zip first\n");
@@ -51,38 +73,158 @@ void run_from_bundle(const std::string &name, bool enable_assert, unsigned short
             fprintf(stderr, "zip file info\n");
             exit(1);
         }
-        r = unzOpenCurrentFile(zip);
+        unz_file_pos pos;
+        unzGetFilePos(zip, &pos);
+        entries[filename] = pos;
+        r = unzGoToNextFile(zip);
         if (r != UNZ_OK) {
-            fprintf(stderr, "zip file open\n");
-            exit(1);
+            break;
         }
-        std::vector<unsigned char> bytecode;
-        for (;;) {
-            char buf[4096];
-            int n = unzReadCurrentFile(zip, buf, sizeof(buf));
-            if (n == 0) {
-                break;
-            } else if (n < 0) {
-                fprintf(stderr, "zip read\n");
-                exit(1);
-            }
-            for (auto i = 0; i < n; i++) {
-                bytecode.push_back(buf[i]);
-            }
+    }
+}
+
+std::vector<unsigned char> ZipSupport::read(const std::string &filename)
+{
+    auto e = entries.find(filename);
+    if (e == entries.end()) {
+        throw BytecodeException("file not found");
+    }
+    int r = unzGoToFilePos(zip, &e->second);
+    if (r != UNZ_OK) {
+        fprintf(stderr, "zip file position\n");
+        exit(1);
+    }
+    unz_file_info file_info;
+    r = unzGetCurrentFileInfo(zip, &file_info, NULL, 0, NULL, 0, NULL, 0);
+    if (r != UNZ_OK) {
+        fprintf(stderr, "zip file info\n");
+        exit(1);
+    }
+    r = unzOpenCurrentFile(zip);
+    if (r != UNZ_OK) {
+        fprintf(stderr, "zip file open\n");
+        exit(1);
+    }
+    std::vector<unsigned char> bytecode(file_info.uncompressed_size);
+    size_t size = 0;
+    for (;;) {
+        if (size == bytecode.size()) {
+            bytecode.resize(size + 4096);
         }
-        unzCloseCurrentFile(zip);
-        g_Contents[filename] = bytecode;
-        r = unzGoToNextFile(zip);
-        if (r != UNZ_OK) {
+        int n = unzReadCurrentFile(zip, bytecode.data() + size, static_cast<unsigned int>(bytecode.size() - size));
+        if (n == 0) {
             break;
+        } else if (n < 0) {
+            fprintf(stderr, "zip read\n");
+            exit(1);
         }
+        size += n;
     }
-    unzClose(zip);
+    unzCloseCurrentFile(zip);
+    bytecode.resize(size);
+    return bytecode;
+}
+
+void ZipSupport::loadBytecode(const std::string &module, Bytecode &bytecode)
+{
+    const std::string module_name = module + ".neonx";
+    bytecode.load(module_name, BytecodeImage::own(read(module_name)));
+}
+
+uint64_t get_uint(const unsigned char *p, size_t size)
+{
+    uint64_t r = 0;
+    for (size_t i = size; i > 0; i--) {
+        r = (r << 8) | p[i-1];
+    }
+    return r;
+}
+
+bool read_index(const std::shared_ptr<const BytecodeImage> &bundle, std::map<std::string, std::shared_ptr<const BytecodeImage>> &modules)
+{
+    const unsigned char *p = bundle->data();
+    const size_t size = bundle->size();
+    if (size < BUNDLE_TRAILER_SIZE) {
+        return false;
+    }
+    const unsigned char *trailer = p + size - BUNDLE_TRAILER_SIZE;
+    if (memcmp(trailer + 24, BUNDLE_SIGNATURE, BUNDLE_SIGNATURE_SIZE) != 0) {
+        return false;
+    }
+    if (get_uint(trailer + 20, 4) != BUNDLE_VERSION) {
+        fprintf(stderr, "bundle version mismatch\n");
+        exit(1);
+    }
+    const uint64_t index = get_uint(trailer, 8);
+    const uint64_t indexlen = get_uint(trailer + 8, 8);
+    uint64_t count = get_uint(trailer + 16, 4);
+    const uint64_t end = size - BUNDLE_TRAILER_SIZE;
+    // The index ends where the trailer starts, which gives the position
+    // of the start of the bundle in the file.
+    if (indexlen > end || index > end - indexlen) {
+        fprintf(stderr, "bundle index corrupt\n");
+        exit(1);
+    }
+    const uint64_t base = end - indexlen - index;
+    uint64_t i = base + index;
+    while (count > 0) {
+        if (i > end || end - i < 20) {
+            fprintf(stderr, "bundle index corrupt\n");
+            exit(1);
+        }
+        uint64_t offset = base + get_uint(p + i, 8);
+        uint64_t length = get_uint(p + i + 8, 8);
+        uint64_t namelen = get_uint(p + i + 16, 4);
+        i += 20;
+        if (end - i < namelen || offset > end || end - offset < length) {
+            fprintf(stderr, "bundle index corrupt\n");
+            exit(1);
+        }
+        std::string name(reinterpret_cast<const char *>(p + i), static_cast<size_t>(namelen));
+        i += namelen;
+        modules[name] = std::make_shared<BundledImage>(bundle, static_cast<size_t>(offset), static_cast<size_t>(length));
+        count--;
+    }
+    return true;
+}
 
-    ZipSupport zip_support;
+} // namespace
 
+void run_from_bundle(const std::string &name, bool enable_assert, unsigned short debug_port, int argc, char *argv[])
+{
     struct ExecOptions options;
     options.enable_assert = enable_assert;
     options.enable_trace = false;
-    exit(exec(name, g_Contents[".neonx"], nullptr, &zip_support, &options, debug_port, argc, argv));
+
+    std::shared_ptr<const BytecodeImage> bundle = BytecodeImage::map(name);
+    if (bundle == nullptr) {
+        fprintf(stderr, "bundle open error\n");
+        exit(1);
+    }
+    IndexedSupport indexed_support;
+    if (read_index(bundle, indexed_support.modules)) {
+        auto program = indexed_support.modules.find("");
+        if (program == indexed_support.modules.end()) {
+            fprintf(stderr, "bundle has no main module\n");
+            exit(1);
+        }
+        std::vector<unsigned char> bytecode(program->second->data(), program->second->data() + program->second->size());
+        exit(exec(name, bytecode, nullptr, &indexed_support, &options, debug_port, argc, argv));
+    }
+    bundle.reset();
+
+    unzFile zip = unzOpen(name.c_str());
+    if (zip == NULL) {
+        fprintf(stderr, "zip open error\n");
+        exit(1);
+    }
+    ZipSupport zip_support(zip);
+    std::vector<unsigned char> bytecode;
+    try {
+        bytecode = zip_support.read(".neonx");
+    } catch (BytecodeException &) {
+        fprintf(stderr, "bundle has no main module\n");
+        exit(1);
+    }
+    exit(exec(name, bytecode, nullptr, &zip_support, &options, debug_port, argc, argv));
 }
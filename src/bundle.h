@@ -3,6 +3,39 @@
 
 #include <string>
 
+// A bundle holds a compiled program and every module it imports, either
+// as a zip file or in the indexed format below. neonbind writes either
+// one, and a bundle can be appended to neonstub to make an executable.
+//
+// The indexed format stores each module uncompressed, starting at a
+// multiple of BUNDLE_ALIGNMENT from the start of the bundle, so that a
+// module can be used straight from the mapped file and the pages of
+// modules that are never imported are never read. After the modules
+// comes the index, with one entry for each module:
+//
+//      offset      8 bytes     position of the module in the bundle
+//      length      8 bytes     size of the module
+//      namelen     4 bytes     length of the name
+//      name        namelen     module name (empty for the main program)
+//
+// The file ends with a trailer:
+//
+//      index       8 bytes     position of the index in the bundle
+//      indexlen    8 bytes     size of the index
+//      count       4 bytes     number of modules
+//      version     4 bytes     BUNDLE_VERSION
+//      signature   8 bytes     BUNDLE_SIGNATURE
+//
+// All positions are relative to the start of the bundle, which is found
+// from the end of the file. Anything in front of the bundle, such as the
+// stub executable, is left alone. All numbers are little endian.
+
+const size_t BUNDLE_ALIGNMENT = 4096;
+const unsigned int BUNDLE_VERSION = 2;
+const char BUNDLE_SIGNATURE[] = "Ne\0nBndl";
+const size_t BUNDLE_SIGNATURE_SIZE = 8;
+const size_t BUNDLE_TRAILER_SIZE = 8 + 8 + 4 + 4 + BUNDLE_SIGNATURE_SIZE;
+
 void run_from_bundle(const std::string &name, bool enable_assert, unsigned short debug_port, int argc, char *argv[]);
 
 #endif
@@ -6,8 +6,151 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "opcode.h"
 
+namespace {
+
+// Files smaller than this are read into memory instead of being mapped.
+// Setting up and tearing down a mapping costs more than copying a few
+// pages, and most modules are only a few kilobytes.
+const size_t MAP_THRESHOLD = 65536;
+
+class MappedImage: public BytecodeImage {
+public:
+#ifdef _WIN32
+    MappedImage(): file(INVALID_HANDLE_VALUE), map(NULL) {}
+    virtual ~MappedImage() {
+        if (bytes != nullptr) {
+            UnmapViewOfFile(bytes);
+        }
+        if (map != NULL) {
+            CloseHandle(map);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+    }
+    HANDLE file;
+    HANDLE map;
+#else
+    virtual ~MappedImage() {
+        if (bytes != nullptr) {
+            munmap(const_cast<unsigned char *>(bytes), length);
+        }
+    }
+#endif
+    void set(const unsigned char *a_bytes, size_t a_length) {
+        bytes = a_bytes;
+        length = a_length;
+    }
+};
+
+class BorrowedImage: public BytecodeImage {
+public:
+    BorrowedImage(const unsigned char *a_bytes, size_t a_length) {
+        bytes = a_bytes;
+        length = a_length;
+    }
+};
+
+class OwnedImage: public BytecodeImage {
+public:
+    explicit OwnedImage(std::vector<unsigned char> &&a_content): content(std::move(a_content)) {
+        bytes = content.data();
+        length = content.size();
+    }
+    const std::vector<unsigned char> content;
+};
+
+} // namespace
+
+std::shared_ptr<const BytecodeImage> BytecodeImage::map(const std::string &path)
+{
+#ifdef _WIN32
+    std::shared_ptr<MappedImage> r = std::make_shared<MappedImage>();
+    r->file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (r->file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER size;
+    if (not GetFileSizeEx(r->file, &size)) {
+        return nullptr;
+    }
+    if (static_cast<unsigned long long>(size.QuadPart) < MAP_THRESHOLD) {
+        std::vector<unsigned char> content(static_cast<size_t>(size.QuadPart));
+        DWORD n = 0;
+        if (not content.empty() && (not ReadFile(r->file, content.data(), static_cast<DWORD>(content.size()), &n, NULL) || n != content.size())) {
+            return nullptr;
+        }
+        return own(std::move(content));
+    }
+    r->map = CreateFileMapping(r->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (r->map == NULL) {
+        return nullptr;
+    }
+    void *view = MapViewOfFile(r->map, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL) {
+        return nullptr;
+    }
+    r->set(static_cast<const unsigned char *>(view), static_cast<size_t>(size.QuadPart));
+    return r;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    if (static_cast<size_t>(st.st_size) < MAP_THRESHOLD) {
+        std::vector<unsigned char> content(static_cast<size_t>(st.st_size));
+        size_t n = 0;
+        while (n < content.size()) {
+            ssize_t r = read(fd, content.data() + n, content.size() - n);
+            if (r <= 0) {
+                close(fd);
+                return nullptr;
+            }
+            n += static_cast<size_t>(r);
+        }
+        close(fd);
+        return own(std::move(content));
+    }
+    // The mapping stays valid after the descriptor is closed. A module
+    // is replaced by renaming a new file over it, so a mapped file is
+    // never changed underneath.
+    void *view = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return nullptr;
+    }
+    std::shared_ptr<MappedImage> r = std::make_shared<MappedImage>();
+    r->set(static_cast<const unsigned char *>(view), static_cast<size_t>(st.st_size));
+    return r;
+#endif
+}
+
+std::shared_ptr<const BytecodeImage> BytecodeImage::borrow(const unsigned char *bytes, size_t length)
+{
+    return std::make_shared<BorrowedImage>(bytes, length);
+}
+
+std::shared_ptr<const BytecodeImage> BytecodeImage::own(std::vector<unsigned char> &&bytes)
+{
+    return std::make_shared<OwnedImage>(std::move(bytes));
+}
+
 void Bytecode::put_vint(std::vector<unsigned char> &obj, unsigned int x)
 {
     std::vector<unsigned char> t;
@@ -39,9 +182,14 @@ void Bytecode::put_vint_size(std::vector<unsigned char> &obj, size_t x)
 }
 
 unsigned int Bytecode::get_vint(const std::vector<unsigned char> &obj, size_t &i)
+{
+    return get_vint(obj.data(), obj.size(), i);
+}
+
+unsigned int Bytecode::get_vint(const unsigned char *obj, size_t size, size_t &i)
 {
     unsigned int r = 0;
-    while (i < obj.size()) {
+    while (i < size) {
         unsigned int x = obj[i];
         i++;
         if (r & ~(UINT_MAX >> 7)) {
@@ -56,22 +204,95 @@ unsigned int Bytecode::get_vint(const std::vector<unsigned char> &obj, size_t &i
     return r;
 }
 
-static std::vector<std::string> getstrtable(const std::vector<unsigned char> &obj, size_t start, size_t size)
+const size_t Bytecode::StringTable::DECODED;
+
+Bytecode::StringTable::StringTable(const StringTable &rhs)
+  : strings(),
+    offsets(),
+    image(nullptr),
+    limit(0),
+    mutex()
 {
-    size_t i = 0;
-    std::vector<std::string> r;
-    while (i < size) {
-        size_t j = start + i;
-        size_t len = Bytecode::get_vint(obj, j);
-        i = j - start;
-        r.push_back(std::string(reinterpret_cast<const char *>(&obj[start+i]), len));
+    *this = rhs;
+}
+
+Bytecode::StringTable &Bytecode::StringTable::operator=(const StringTable &rhs)
+{
+    if (this != &rhs) {
+        std::lock_guard<std::mutex> lock(rhs.mutex);
+        strings = rhs.strings;
+        offsets.clear();
+        for (auto &offset: rhs.offsets) {
+            offsets.emplace_back(offset.load(std::memory_order_relaxed));
+        }
+        image = rhs.image;
+        limit = rhs.limit;
+    }
+    return *this;
+}
+
+void Bytecode::StringTable::load(const unsigned char *a_image, size_t start, size_t size)
+{
+    image = a_image;
+    limit = start + size;
+    strings.clear();
+    offsets.clear();
+    size_t i = start;
+    while (i < limit) {
+        offsets.emplace_back(i);
+        size_t len = get_vint(image, limit, i);
+        if (i + len > limit) {
+            throw BytecodeException("unexpected end of bytecode");
+        }
         i += len;
     }
-    return r;
+    strings.resize(offsets.size());
+}
+
+void Bytecode::StringTable::decode(size_t i) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t j = offsets[i].load(std::memory_order_relaxed);
+    if (j == DECODED) {
+        return;
+    }
+    size_t len = get_vint(image, limit, j);
+    strings[i].assign(reinterpret_cast<const char *>(image + j), len);
+    offsets[i].store(DECODED, std::memory_order_release);
+}
+
+const std::string &Bytecode::StringTable::at(size_t i) const
+{
+    if (i >= strings.size()) {
+        throw std::out_of_range("string table index");
+    }
+    return (*this)[i];
+}
+
+void Bytecode::StringTable::push_back(const std::string &s)
+{
+    strings.push_back(s);
+    offsets.emplace_back(DECODED);
+}
+
+std::vector<std::string>::const_iterator Bytecode::StringTable::begin() const
+{
+    for (size_t i = 0; i < strings.size(); i++) {
+        if (offsets[i].load(std::memory_order_acquire) != DECODED) {
+            decode(i);
+        }
+    }
+    return strings.begin();
+}
+
+std::vector<std::string>::const_iterator Bytecode::StringTable::end() const
+{
+    return strings.end();
 }
 
 Bytecode::Bytecode()
-  : obj(),
+  : image(),
+    obj(),
     source_path(),
     source_hash(),
     version(0),
@@ -92,102 +313,110 @@ Bytecode::Bytecode()
 }
 
 void Bytecode::load(const std::string &a_source_path, const std::vector<unsigned char> &bytes)
+{
+    load(a_source_path, BytecodeImage::own(std::vector<unsigned char>(bytes)));
+}
+
+void Bytecode::load(const std::string &a_source_path, std::shared_ptr<const BytecodeImage> a_image)
 {
     source_path = a_source_path;
-    obj = bytes;
+    image = a_image;
+    const unsigned char *const bytes = image->data();
+    const size_t size = image->size();
+    obj = View(bytes, bytes + size);
 
     size_t i = 0;
 
-    if (i + 4 > obj.size()) {
+    if (i + 4 > size) {
         throw BytecodeException("unexpected end of bytecode");
     }
-    std::string sig(&obj[i], &obj[i]+4);
+    std::string sig(&bytes[i], &bytes[i]+4);
     if (sig != std::string("Ne\0n", 4)) {
         throw BytecodeException("bytecode signature missing");
     }
     i += 4;
 
-    version = get_vint(obj, i);
+    version = get_vint(bytes, size, i);
     if (version != BYTECODE_VERSION) {
         throw BytecodeException("bytecode version mismatch");
     }
 
-    if (i + 32 > obj.size()) {
+    if (i + 32 > size) {
         throw BytecodeException("unexpected end of bytecode");
     }
-    source_hash = std::string(&obj[i], &obj[i]+32);
+    source_hash = std::string(&bytes[i], &bytes[i]+32);
     i += 32;
 
-    global_size = get_vint(obj, i);
+    global_size = get_vint(bytes, size, i);
 
-    unsigned int strtablesize = get_vint(obj, i);
-    if (i+strtablesize > obj.size()) {
+    unsigned int strtablesize = get_vint(bytes, size, i);
+    if (i+strtablesize > size) {
         throw BytecodeException("unexpected end of bytecode");
     }
-    strtable = getstrtable(obj, i, strtablesize);
+    strtable.load(bytes, i, strtablesize);
     i += strtablesize;
 
-    unsigned int typesize = get_vint(obj, i);
+    unsigned int typesize = get_vint(bytes, size, i);
     while (typesize > 0) {
         Type t;
-        t.name = get_vint(obj, i);
-        t.descriptor = get_vint(obj, i);
+        t.name = get_vint(bytes, size, i);
+        t.descriptor = get_vint(bytes, size, i);
         export_types.push_back(t);
         typesize--;
     }
 
-    unsigned int constantsize = get_vint(obj, i);
+    unsigned int constantsize = get_vint(bytes, size, i);
     while (constantsize > 0) {
         Constant c;
-        c.name = get_vint(obj, i);
-        c.type = get_vint(obj, i);
-        unsigned int size = get_vint(obj, i);
-        if (i+size > obj.size()) {
+        c.name = get_vint(bytes, size, i);
+        c.type = get_vint(bytes, size, i);
+        unsigned int valuesize = get_vint(bytes, size, i);
+        if (i+valuesize > size) {
             throw BytecodeException("unexpected end of bytecode");
         }
-        c.value = Bytes(&obj[i], &obj[i+size]);
-        i += size;
+        c.value = Bytes(bytes + i, bytes + i + valuesize);
+        i += valuesize;
         export_constants.push_back(c);
         constantsize--;
     }
 
-    unsigned int variablesize = get_vint(obj, i);
+    unsigned int variablesize = get_vint(bytes, size, i);
     while (variablesize > 0) {
         Variable v;
-        v.name = get_vint(obj, i);
-        v.type = get_vint(obj, i);
-        v.index = get_vint(obj, i);
+        v.name = get_vint(bytes, size, i);
+        v.type = get_vint(bytes, size, i);
+        v.index = get_vint(bytes, size, i);
         export_variables.push_back(v);
         variablesize--;
     }
 
-    unsigned int functionsize = get_vint(obj, i);
+    unsigned int functionsize = get_vint(bytes, size, i);
     while (functionsize > 0) {
         Function f;
-        f.name = get_vint(obj, i);
-        f.descriptor = get_vint(obj, i);
-        f.index = get_vint(obj, i);
+        f.name = get_vint(bytes, size, i);
+        f.descriptor = get_vint(bytes, size, i);
+        f.index = get_vint(bytes, size, i);
         export_functions.push_back(f);
         functionsize--;
     }
 
-    unsigned int exceptionexportsize = get_vint(obj, i);
+    unsigned int exceptionexportsize = get_vint(bytes, size, i);
     while (exceptionexportsize > 0) {
         ExceptionExport e;
-        e.name = get_vint(obj, i);
+        e.name = get_vint(bytes, size, i);
         export_exceptions.push_back(e);
         exceptionexportsize--;
     }
 
-    unsigned int interfaceexportsize = get_vint(obj, i);
+    unsigned int interfaceexportsize = get_vint(bytes, size, i);
     while (interfaceexportsize > 0) {
         Interface iface;
-        iface.name = get_vint(obj, i);
-        unsigned int methoddescriptorsize = get_vint(obj, i);
+        iface.name = get_vint(bytes, size, i);
+        unsigned int methoddescriptorsize = get_vint(bytes, size, i);
         while (methoddescriptorsize > 0) {
             std::pair<unsigned int, unsigned int> m;
-            m.first = get_vint(obj, i);
-            m.second = get_vint(obj, i);
+            m.first = get_vint(bytes, size, i);
+            m.second = get_vint(bytes, size, i);
             iface.method_descriptors.push_back(m);
             methoddescriptorsize--;
         }
@@ -195,54 +424,54 @@ void Bytecode::load(const std::string &a_source_path, const std::vector<unsigned
         interfaceexportsize--;
     }
 
-    unsigned int importsize = get_vint(obj, i);
+    unsigned int importsize = get_vint(bytes, size, i);
     while (importsize > 0) {
         ModuleImport imp;
-        imp.name = get_vint(obj, i);
-        imp.optional = get_vint(obj, i) != 0;
-        if (i+32 > obj.size()) {
+        imp.name = get_vint(bytes, size, i);
+        imp.optional = get_vint(bytes, size, i) != 0;
+        if (i+32 > size) {
             throw BytecodeException("unexpected end of bytecode");
         }
-        imp.hash = std::string(&obj[i], &obj[i]+32);
+        imp.hash = std::string(&bytes[i], &bytes[i]+32);
         i += 32;
         imports.push_back(imp);
         importsize--;
     }
 
-    /*unsigned int*/ functionsize = get_vint(obj, i);
+    /*unsigned int*/ functionsize = get_vint(bytes, size, i);
     while (functionsize > 0) {
         FunctionInfo f;
-        f.name = get_vint(obj, i);
-        f.nest = get_vint(obj, i);
-        f.params = get_vint(obj, i);
-        f.locals = get_vint(obj, i);
-        f.entry = get_vint(obj, i);
+        f.name = get_vint(bytes, size, i);
+        f.nest = get_vint(bytes, size, i);
+        f.params = get_vint(bytes, size, i);
+        f.locals = get_vint(bytes, size, i);
+        f.entry = get_vint(bytes, size, i);
         functions.push_back(f);
         functionsize--;
     }
 
-    unsigned int exceptionsize = get_vint(obj, i);
+    unsigned int exceptionsize = get_vint(bytes, size, i);
     while (exceptionsize > 0) {
         ExceptionInfo e;
-        e.start = get_vint(obj, i);
-        e.end = get_vint(obj, i);
-        e.excid = get_vint(obj, i);
-        e.handler = get_vint(obj, i);
-        e.stack_depth = get_vint(obj, i);
+        e.start = get_vint(bytes, size, i);
+        e.end = get_vint(bytes, size, i);
+        e.excid = get_vint(bytes, size, i);
+        e.handler = get_vint(bytes, size, i);
+        e.stack_depth = get_vint(bytes, size, i);
         exceptions.push_back(e);
         exceptionsize--;
     }
 
-    unsigned int classsize = get_vint(obj, i);
+    unsigned int classsize = get_vint(bytes, size, i);
     while (classsize > 0) {
         ClassInfo c;
-        c.name = get_vint(obj, i);
-        unsigned int interfacecount = get_vint(obj, i);
+        c.name = get_vint(bytes, size, i);
+        unsigned int interfacecount = get_vint(bytes, size, i);
         while (interfacecount > 0) {
             std::vector<unsigned int> methods;
-            unsigned int methodcount = get_vint(obj, i);
+            unsigned int methodcount = get_vint(bytes, size, i);
             while (methodcount > 0) {
-                methods.push_back(get_vint(obj, i));
+                methods.push_back(get_vint(bytes, size, i));
                 methodcount--;
             }
             c.interfaces.push_back(methods);
@@ -252,7 +481,7 @@ void Bytecode::load(const std::string &a_source_path, const std::vector<unsigned
         classsize--;
     }
 
-    code = Bytes(obj.begin() + i, obj.end());
+    code = Bytes(bytes + i, bytes + size);
 
 }
 
@@ -1,6 +1,10 @@
 #ifndef BYTECODE_H
 #define BYTECODE_H
 
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -10,15 +14,89 @@ public:
     BytecodeException(const char *what): std::runtime_error(what) {}
 };
 
+// The bytes of a compiled module. A large .neonx file is mapped into
+// memory rather than read, and every Bytecode loaded from an image shares
+// it instead of holding a copy.
+class BytecodeImage {
+public:
+    BytecodeImage(const BytecodeImage &) = delete;
+    BytecodeImage &operator=(const BytecodeImage &) = delete;
+    virtual ~BytecodeImage() {}
+    const unsigned char *data() const { return bytes; }
+    size_t size() const { return length; }
+
+    // Maps the file, or reads it if it is small. Returns nullptr if the
+    // file cannot be opened.
+    static std::shared_ptr<const BytecodeImage> map(const std::string &path);
+    // For bytes that outlive every Bytecode, such as those embedded in
+    // the executable.
+    static std::shared_ptr<const BytecodeImage> borrow(const unsigned char *bytes, size_t length);
+    static std::shared_ptr<const BytecodeImage> own(std::vector<unsigned char> &&bytes);
+protected:
+    BytecodeImage(): bytes(nullptr), length(0) {}
+    const unsigned char *bytes;
+    size_t length;
+};
+
 class Bytecode {
 public:
     Bytecode();
     void load(const std::string &source_path, const std::vector<unsigned char> &bytes);
+    void load(const std::string &source_path, std::shared_ptr<const BytecodeImage> image);
 
     static const int BYTECODE_VERSION = 3;
 
     typedef std::vector<unsigned char> Bytes;
 
+    // A range of bytes in the image this was loaded from.
+    class View {
+    public:
+        View(): first(nullptr), last(nullptr) {}
+        View(const unsigned char *first, const unsigned char *last): first(first), last(last) {}
+        const unsigned char *data() const { return first; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        const unsigned char *begin() const { return first; }
+        const unsigned char *end() const { return last; }
+    private:
+        const unsigned char *first;
+        const unsigned char *last;
+    };
+
+    // The strings used by a module. When loaded from an image, only the
+    // position of each string is found up front, and a string is copied
+    // out of the image the first time it is used. Most of the strings in
+    // a module are never needed by an importer. Strings may be looked up
+    // from more than one thread at once, so each is decoded under a lock,
+    // and a decoded string is then read without one.
+    class StringTable {
+    public:
+        StringTable(): strings(), offsets(), image(nullptr), limit(0), mutex() {}
+        StringTable(const StringTable &rhs);
+        StringTable &operator=(const StringTable &rhs);
+        void load(const unsigned char *image, size_t start, size_t size);
+        size_t size() const { return strings.size(); }
+        const std::string &operator[](size_t i) const {
+            if (offsets[i].load(std::memory_order_acquire) != DECODED) {
+                decode(i);
+            }
+            return strings[i];
+        }
+        const std::string &at(size_t i) const;
+        void push_back(const std::string &s);
+        std::vector<std::string>::const_iterator begin() const;
+        std::vector<std::string>::const_iterator end() const;
+    private:
+        static const size_t DECODED = ~static_cast<size_t>(0);
+        void decode(size_t i) const;
+        mutable std::vector<std::string> strings;
+        // Offset in the image of the length of each string not yet decoded,
+        // or DECODED. A deque, because atomics can't be moved.
+        mutable std::deque<std::atomic<size_t>> offsets;
+        const unsigned char *image;
+        size_t limit;
+        mutable std::mutex mutex;
+    };
+
     /*
      * Type descriptors are one of the following patterns:
      *
@@ -102,12 +180,13 @@ public:
         std::vector<std::vector<unsigned int>> interfaces;
     };
 
-    Bytes obj;
+    std::shared_ptr<const BytecodeImage> image;
+    View obj;
     std::string source_path;
     std::string source_hash;
     int version;
     size_t global_size;
-    std::vector<std::string> strtable;
+    StringTable strtable;
     std::vector<Type> export_types;
     std::vector<Constant> export_constants;
     std::vector<Variable> export_variables;
@@ -126,6 +205,7 @@ public:
     static void put_vint(std::vector<unsigned char> &obj, unsigned int x, size_t width);
     static void put_vint_size(std::vector<unsigned char> &obj, size_t x);
     static unsigned int get_vint(const std::vector<unsigned char> &obj, size_t &i);
+    static unsigned int get_vint(const unsigned char *obj, size_t size, size_t &i);
 };
 
 #endif
@@ -0,0 +1,244 @@
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "cache.h"
+
+#include <cstdlib>
+#include <errno.h>
+#include <fstream>
+#include <iso646.h>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+
+#include <sys/stat.h>
+
+#include <sha256.h>
+
+#include "atomic_file.h"
+#include "bytecode.h"
+#include "debuginfo.h"
+#include "lexer.h"
+#include "util.h"
+#include "version.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define mkdir(x,y) _mkdir(x)
+#endif
+
+namespace {
+
+std::vector<unsigned char> read_file(const std::string &name, bool &ok)
+{
+    std::ifstream f(name, std::ios::binary);
+    ok = f.good();
+    if (not ok) {
+        return std::vector<unsigned char>();
+    }
+    std::stringstream buf;
+    buf << f.rdbuf();
+    std::string s = buf.str();
+    return std::vector<unsigned char>(s.begin(), s.end());
+}
+
+bool make_directories(const std::string &path)
+{
+    std::string::size_type slash = 0;
+    for (;;) {
+        slash = path.find_first_of("/\\", slash+1);
+        if (mkdir(path.substr(0, slash).c_str(), 0700) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (slash == std::string::npos) {
+            return true;
+        }
+    }
+}
+
+// The files named by EMBED expressions in a module, relative to the
+// directory of the module as the analyzer finds them.
+std::vector<std::string> embedded_files(const std::string &source_path, const std::string &source)
+{
+    std::string dir;
+    std::string::size_type i = source_path.find_last_of("/\\");
+    if (i != std::string::npos) {
+        dir = source_path.substr(0, i + 1);
+    }
+    std::vector<std::string> r;
+    auto tokens = tokenize(source_path, source);
+    for (size_t t = 0; t+1 < tokens->tokens.size(); t++) {
+        if (tokens->tokens[t].type == EMBED && tokens->tokens[t+1].type == STRING) {
+            r.push_back(dir + tokens->tokens[t+1].text);
+        }
+    }
+    return r;
+}
+
+std::string hex_from_binary(const std::string &bin)
+{
+    static const char hex[] = "0123456789abcdef";
+    std::string r;
+    for (auto b: bin) {
+        r.push_back(hex[(b >> 4) & 0xf]);
+        r.push_back(hex[b & 0xf]);
+    }
+    return r;
+}
+
+std::string binary_from_hex(const std::string &hex)
+{
+    std::string r;
+    for (size_t i = 0; i+1 < hex.length(); i += 2) {
+        r.push_back(static_cast<char>(strtol(hex.substr(i, 2).c_str(), NULL, 16)));
+    }
+    return r;
+}
+
+} // namespace
+
+ModuleCache::ModuleCache(const std::string &directory)
+  : directory(directory)
+{
+}
+
+std::string ModuleCache::default_directory()
+{
+    const char *dir = std::getenv("NEONCACHE");
+    return dir != NULL ? dir : "";
+}
+
+std::string ModuleCache::entry_name(const std::string &source_path, const std::string &source, bool debug) const
+{
+    SHA256 sha256;
+    sha256.add(GIT_DESCRIBE, strlen(GIT_DESCRIBE) + 1);
+    std::string version = std::to_string(Bytecode::BYTECODE_VERSION) + (debug ? "d" : "") + '\0';
+    sha256.add(version.data(), version.size());
+    sha256.add(source_path.c_str(), source_path.size() + 1);
+    sha256.add(source.data(), source.size());
+    std::vector<std::string> files;
+    try {
+        files = embedded_files(source_path, source);
+    } catch (CompilerError *error) {
+        delete error;
+        return "";
+    }
+    for (auto &file: files) {
+        bool ok;
+        std::vector<unsigned char> contents = read_file(file, ok);
+        if (not ok) {
+            return "";
+        }
+        SHA256 file_sha256;
+        file_sha256.add(contents.data(), contents.size());
+        std::string entry = '\0' + file + '\0' + file_sha256.getHash();
+        sha256.add(entry.data(), entry.size());
+    }
+    std::string r = directory;
+    if (r.find_last_of("/\\") != r.length()-1) {
+        r.append("/");
+    }
+    return r + sha256.getHash();
+}
+
+bool ModuleCache::load(const std::string &source_path, const std::string &source, bool debug, std::vector<unsigned char> &bytecode, std::map<std::string, std::string> *imports, DebugInfo *debuginfo)
+{
+    if (not enabled()) {
+        return false;
+    }
+    const std::string name = entry_name(source_path, source, debug);
+    if (name.empty()) {
+        return false;
+    }
+    bool ok;
+    std::vector<unsigned char> obj = read_file(name + ".neonx", ok);
+    if (not ok) {
+        return false;
+    }
+    if (imports != nullptr || debuginfo != nullptr) {
+        std::ifstream f(name + ".neond");
+        std::string section;
+        size_t count;
+        if (not (f >> section >> count) || section != "imports") {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            std::string hash;
+            std::string module;
+            if (not (f >> hash >> module)) {
+                return false;
+            }
+            if (imports != nullptr) {
+                (*imports)[module] = binary_from_hex(hash);
+            }
+        }
+        if (not (f >> section >> count) || section != "line_numbers") {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            size_t offset;
+            int line;
+            if (not (f >> offset >> line)) {
+                return false;
+            }
+            if (debuginfo != nullptr) {
+                debuginfo->line_numbers[offset] = line;
+            }
+        }
+        if (not (f >> section >> count) || section != "stack_depth") {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            size_t offset;
+            int depth;
+            if (not (f >> offset >> depth)) {
+                return false;
+            }
+            if (debuginfo != nullptr) {
+                debuginfo->stack_depth[offset] = depth;
+            }
+        }
+    }
+    bytecode = obj;
+    return true;
+}
+
+void ModuleCache::store(const std::string &source_path, const std::string &source, bool debug, const std::vector<unsigned char> &bytecode, const std::map<std::string, std::string> *imports, const DebugInfo *debuginfo)
+{
+    if (not enabled() || not make_directories(directory)) {
+        return;
+    }
+    const std::string name = entry_name(source_path, source, debug);
+    if (name.empty()) {
+        return;
+    }
+    // Write the .neond first, so that a .neonx in the cache always has
+    // its .neond next to it.
+    if (imports != nullptr || debuginfo != nullptr) {
+        std::stringstream out;
+        out << "imports " << (imports != nullptr ? imports->size() : 0) << "\n";
+        if (imports != nullptr) {
+            for (auto &i: *imports) {
+                out << hex_from_binary(i.second) << " " << i.first << "\n";
+            }
+        }
+        out << "line_numbers " << (debuginfo != nullptr ? debuginfo->line_numbers.size() : 0) << "\n";
+        if (debuginfo != nullptr) {
+            for (auto &n: debuginfo->line_numbers) {
+                out << n.first << " " << n.second << "\n";
+            }
+        }
+        out << "stack_depth " << (debuginfo != nullptr ? debuginfo->stack_depth.size() : 0) << "\n";
+        if (debuginfo != nullptr) {
+            for (auto &d: debuginfo->stack_depth) {
+                out << d.first << " " << d.second << "\n";
+            }
+        }
+        const std::string neond = out.str();
+        if (not write_file_atomically(name + ".neond", neond.data(), neond.size())) {
+            return;
+        }
+    }
+    write_file_atomically(name + ".neonx", bytecode.data(), bytecode.size());
+}
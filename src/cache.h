@@ -0,0 +1,47 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+class DebugInfo;
+
+// An on-disk cache of compiled modules. Entries are keyed by a hash of
+// the source path (which also gives the module its name), the source text,
+// the contents of every file it embeds with EMBED, the compiler version,
+// and whether debug information was requested, so the same source compiled
+// by a different build of the compiler is never reused. Each entry is a
+// .neonx file with a .neond file next to it, which has the source hash of
+// each module that was loaded while compiling it. For the main program, the
+// .neond also has its line number and stack depth tables.
+//
+// The key doesn't cover the modules imported by a module. The caller is
+// responsible for checking that those haven't changed (see
+// CompilerSupport::importsCurrent).
+
+class ModuleCache {
+public:
+    explicit ModuleCache(const std::string &directory);
+    ModuleCache(const ModuleCache &) = delete;
+    ModuleCache &operator=(const ModuleCache &) = delete;
+
+    // The directory named by the NEONCACHE environment variable, or an
+    // empty string if it is not set.
+    static std::string default_directory();
+
+    bool enabled() const { return not directory.empty(); }
+    // The imports and debuginfo tables are only read and written when
+    // they are not null.
+    bool load(const std::string &source_path, const std::string &source, bool debug, std::vector<unsigned char> &bytecode, std::map<std::string, std::string> *imports, DebugInfo *debuginfo);
+    void store(const std::string &source_path, const std::string &source, bool debug, const std::vector<unsigned char> &bytecode, const std::map<std::string, std::string> *imports, const DebugInfo *debuginfo);
+
+private:
+    const std::string directory;
+
+    // Empty if the source can't be tokenized or a file it embeds can't be
+    // read, in which case nothing is cached.
+    std::string entry_name(const std::string &source_path, const std::string &source, bool debug) const;
+};
+
+#endif
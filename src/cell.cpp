@@ -2,170 +2,103 @@
 
 #include <assert.h>
 #include <iso646.h>
+#include <new>
+#include <utility>
 
 Cell::Cell()
   : gc(),
     type(Type::None),
-    address_value(nullptr),
-    boolean_value(false),
-    number_value(),
-    string_ptr(),
-    bytes_ptr(),
-    object_ptr(),
-    array_ptr(),
-    dictionary_ptr(),
     other_ptr(nullptr)
 {
 }
 
 Cell::Cell(const Cell &rhs)
   : gc(),
-    type(rhs.type),
-    address_value(rhs.address_value),
-    boolean_value(rhs.boolean_value),
-    number_value(rhs.number_value),
-    string_ptr(rhs.string_ptr),
-    bytes_ptr(rhs.bytes_ptr),
-    object_ptr(rhs.object_ptr),
-    array_ptr(rhs.array_ptr),
-    dictionary_ptr(rhs.dictionary_ptr),
-    other_ptr(rhs.other_ptr)
+    type(Type::None)
 {
+    copy_from(rhs);
+}
+
+Cell::Cell(Cell &&rhs) noexcept
+  : gc(),
+    type(Type::None)
+{
+    move_from(rhs);
 }
 
 Cell::Cell(Cell *value)
   : gc(),
     type(Type::Address),
-    address_value(value),
-    boolean_value(false),
-    number_value(),
-    string_ptr(),
-    bytes_ptr(),
-    object_ptr(),
-    array_ptr(),
-    dictionary_ptr(),
-    other_ptr(nullptr)
+    address_value(value)
 {
 }
 
 Cell::Cell(bool value)
   : gc(),
     type(Type::Boolean),
-    address_value(nullptr),
-    boolean_value(value),
-    number_value(),
-    string_ptr(),
-    bytes_ptr(),
-    object_ptr(),
-    array_ptr(),
-    dictionary_ptr(),
-    other_ptr(nullptr)
+    boolean_value(value)
 {
 }
 
 Cell::Cell(Number value)
   : gc(),
     type(Type::Number),
-    address_value(nullptr),
-    boolean_value(false),
-    number_value(value),
-    string_ptr(),
-    bytes_ptr(),
-    object_ptr(),
-    array_ptr(),
-    dictionary_ptr(),
-    other_ptr(nullptr)
+    number_value(value)
 {
 }
 
 Cell::Cell(const utf8string &value)
   : gc(),
     type(Type::String),
-    address_value(nullptr),
-    boolean_value(false),
-    number_value(),
-    string_ptr(std::make_shared<utf8string>(value)),
-    bytes_ptr(),
-    object_ptr(),
-    array_ptr(),
-    dictionary_ptr(),
-    other_ptr(nullptr)
+    string_ptr(std::make_shared<utf8string>(value))
 {
 }
 
 Cell::Cell(const char *value)
   : gc(),
     type(Type::String),
-    address_value(nullptr),
-    boolean_value(false),
-    number_value(),
-    string_ptr(std::make_shared<utf8string>(value)),
-    bytes_ptr(),
-    object_ptr(),
-    array_ptr(),
-    dictionary_ptr(),
-    other_ptr(nullptr)
+    string_ptr(std::make_shared<utf8string>(value))
 {
 }
 
 Cell::Cell(const std::vector<unsigned char> &value)
   : gc(),
     type(Type::Bytes),
-    address_value(nullptr),
-    boolean_value(false),
-    number_value(),
-    string_ptr(),
-    bytes_ptr(std::make_shared<std::vector<unsigned char>>(value)),
-    object_ptr(),
-    array_ptr(),
-    dictionary_ptr(),
-    other_ptr(nullptr)
+    bytes_ptr(std::make_shared<std::vector<unsigned char>>(value))
 {
 }
 
 Cell::Cell(const std::shared_ptr<Object> &value)
   : gc(),
     type(Type::Object),
-    address_value(nullptr),
-    boolean_value(false),
-    number_value(),
-    string_ptr(),
-    bytes_ptr(),
-    object_ptr(value),
-    array_ptr(),
-    dictionary_ptr(),
-    other_ptr(nullptr)
+    object_ptr(value)
 {
 }
 
 Cell::Cell(const std::vector<Cell> &value, bool alloced)
   : gc(alloced),
     type(Type::Array),
-    address_value(nullptr),
-    boolean_value(false),
-    number_value(),
-    string_ptr(),
-    bytes_ptr(),
-    object_ptr(),
-    array_ptr(std::make_shared<std::vector<Cell>>(value)),
-    dictionary_ptr(),
-    other_ptr(nullptr)
+    array_ptr(std::make_shared<std::vector<Cell>>(value))
+{
+}
+
+Cell::Cell(std::vector<Cell> &&value)
+  : gc(),
+    type(Type::Array),
+    array_ptr(std::make_shared<std::vector<Cell>>(std::move(value)))
 {
 }
 
-Cell::Cell(const std::map<utf8string, Cell> &value)
+Cell::Cell(const HashDictionary<Cell> &value)
   : gc(),
     type(Type::Dictionary),
-    address_value(nullptr),
-    boolean_value(false),
-    number_value(),
-    string_ptr(),
-    bytes_ptr(),
-    object_ptr(),
-    array_ptr(),
-    dictionary_ptr(std::make_shared<std::map<utf8string, Cell>>(value)),
-    other_ptr(nullptr)
+    dictionary_ptr(std::make_shared<HashDictionary<Cell>>(value))
+{
+}
+
+Cell::~Cell()
 {
+    destroy();
 }
 
 Cell &Cell::operator=(const Cell &rhs)
@@ -173,19 +106,97 @@ Cell &Cell::operator=(const Cell &rhs)
     if (&rhs == this) {
         return *this;
     }
-    type = rhs.type;
-    address_value = rhs.address_value;
-    boolean_value = rhs.boolean_value;
-    number_value = rhs.number_value;
-    string_ptr = rhs.string_ptr;
-    bytes_ptr = rhs.bytes_ptr;
-    object_ptr = rhs.object_ptr;
-    array_ptr = rhs.array_ptr;
-    dictionary_ptr = rhs.dictionary_ptr;
-    other_ptr = rhs.other_ptr;
+    // Copy first, because rhs might be owned by this cell (for
+    // example, an element of this cell's array).
+    Cell tmp(rhs);
+    destroy();
+    move_from(tmp);
+    return *this;
+}
+
+Cell &Cell::operator=(Cell &&rhs) noexcept
+{
+    if (&rhs == this) {
+        return *this;
+    }
+    Cell tmp(std::move(rhs));
+    destroy();
+    move_from(tmp);
     return *this;
 }
 
+void Cell::init(Type t)
+{
+    assert(type == Type::None);
+    type = t;
+    switch (type) {
+        case Type::None:         break;
+        case Type::Address:      address_value = nullptr; break;
+        case Type::Boolean:      boolean_value = false; break;
+        case Type::Number:       new (&number_value) Number(); break;
+        case Type::String:       new (&string_ptr) std::shared_ptr<utf8string>(); break;
+        case Type::Bytes:        new (&bytes_ptr) std::shared_ptr<std::vector<unsigned char>>(); break;
+        case Type::Object:       new (&object_ptr) std::shared_ptr<Object>(); break;
+        case Type::Array:        new (&array_ptr) std::shared_ptr<std::vector<Cell>>(); break;
+        case Type::Dictionary:   new (&dictionary_ptr) std::shared_ptr<HashDictionary<Cell>>(); break;
+        case Type::Other:        other_ptr = nullptr; break;
+    }
+}
+
+void Cell::copy_from(const Cell &rhs)
+{
+    assert(type == Type::None);
+    type = rhs.type;
+    switch (type) {
+        case Type::None:         break;
+        case Type::Address:      address_value = rhs.address_value; break;
+        case Type::Boolean:      boolean_value = rhs.boolean_value; break;
+        case Type::Number:       new (&number_value) Number(rhs.number_value); break;
+        case Type::String:       new (&string_ptr) std::shared_ptr<utf8string>(rhs.string_ptr); break;
+        case Type::Bytes:        new (&bytes_ptr) std::shared_ptr<std::vector<unsigned char>>(rhs.bytes_ptr); break;
+        case Type::Object:       new (&object_ptr) std::shared_ptr<Object>(rhs.object_ptr); break;
+        case Type::Array:        new (&array_ptr) std::shared_ptr<std::vector<Cell>>(rhs.array_ptr); break;
+        case Type::Dictionary:   new (&dictionary_ptr) std::shared_ptr<HashDictionary<Cell>>(rhs.dictionary_ptr); break;
+        case Type::Other:        other_ptr = rhs.other_ptr; break;
+    }
+}
+
+void Cell::move_from(Cell &rhs)
+{
+    assert(type == Type::None);
+    type = rhs.type;
+    switch (type) {
+        case Type::None:         break;
+        case Type::Address:      address_value = rhs.address_value; break;
+        case Type::Boolean:      boolean_value = rhs.boolean_value; break;
+        case Type::Number:       new (&number_value) Number(rhs.number_value); break;
+        case Type::String:       new (&string_ptr) std::shared_ptr<utf8string>(std::move(rhs.string_ptr)); break;
+        case Type::Bytes:        new (&bytes_ptr) std::shared_ptr<std::vector<unsigned char>>(std::move(rhs.bytes_ptr)); break;
+        case Type::Object:       new (&object_ptr) std::shared_ptr<Object>(std::move(rhs.object_ptr)); break;
+        case Type::Array:        new (&array_ptr) std::shared_ptr<std::vector<Cell>>(std::move(rhs.array_ptr)); break;
+        case Type::Dictionary:   new (&dictionary_ptr) std::shared_ptr<HashDictionary<Cell>>(std::move(rhs.dictionary_ptr)); break;
+        case Type::Other:        other_ptr = rhs.other_ptr; break;
+    }
+    rhs.destroy();
+}
+
+void Cell::destroy()
+{
+    switch (type) {
+        case Type::None:         break;
+        case Type::Address:      break;
+        case Type::Boolean:      break;
+        case Type::Number:       number_value.~Number(); break;
+        case Type::String:       string_ptr.~shared_ptr(); break;
+        case Type::Bytes:        bytes_ptr.~shared_ptr(); break;
+        case Type::Object:       object_ptr.~shared_ptr(); break;
+        case Type::Array:        array_ptr.~shared_ptr(); break;
+        case Type::Dictionary:   dictionary_ptr.~shared_ptr(); break;
+        case Type::Other:        break;
+    }
+    type = Type::None;
+}
+
 bool Cell::operator==(const Cell &rhs) const
 {
     if (type == Type::None || rhs.type == Type::None) {
@@ -210,7 +221,7 @@ bool Cell::operator==(const Cell &rhs) const
 Cell *&Cell::address()
 {
     if (type == Type::None) {
-        type = Type::Address;
+        init(Type::Address);
     }
     assert(type == Type::Address);
     return address_value;
@@ -219,7 +230,7 @@ Cell *&Cell::address()
 bool &Cell::boolean()
 {
     if (type == Type::None) {
-        type = Type::Boolean;
+        init(Type::Boolean);
     }
     assert(type == Type::Boolean);
     return boolean_value;
@@ -234,7 +245,7 @@ Number Cell::get_number() const
 Number &Cell::number()
 {
     if (type == Type::None) {
-        type = Type::Number;
+        init(Type::Number);
     }
     assert(type == Type::Number);
     return number_value;
@@ -243,7 +254,7 @@ Number &Cell::number()
 const utf8string &Cell::string()
 {
     if (type == Type::None) {
-        type = Type::String;
+        init(Type::String);
     }
     assert(type == Type::String);
     if (not string_ptr) {
@@ -255,7 +266,7 @@ const utf8string &Cell::string()
 utf8string &Cell::string_for_write()
 {
     if (type == Type::None) {
-        type = Type::String;
+        init(Type::String);
     }
     assert(type == Type::String);
     if (not string_ptr) {
@@ -270,7 +281,7 @@ utf8string &Cell::string_for_write()
 const std::vector<unsigned char> &Cell::bytes()
 {
     if (type == Type::None) {
-        type = Type::Bytes;
+        init(Type::Bytes);
     }
     assert(type == Type::Bytes);
     if (not bytes_ptr) {
@@ -282,7 +293,7 @@ const std::vector<unsigned char> &Cell::bytes()
 std::vector<unsigned char> &Cell::bytes_for_write()
 {
     if (type == Type::None) {
-        type = Type::Bytes;
+        init(Type::Bytes);
     }
     assert(type == Type::Bytes);
     if (not bytes_ptr) {
@@ -297,16 +308,35 @@ std::vector<unsigned char> &Cell::bytes_for_write()
 void Cell::set_bytes(const std::vector<unsigned char> &bytes)
 {
     if (type == Type::None) {
-        type = Type::Bytes;
+        init(Type::Bytes);
     }
     assert(type == Type::Bytes);
     bytes_ptr = std::make_shared<std::vector<unsigned char>>(bytes);
 }
 
+const utf8string &Cell::get_string() const
+{
+    static const utf8string empty;
+    if (type == Type::None) {
+        return empty;
+    }
+    assert(type == Type::String);
+    return string_ptr ? *string_ptr : empty;
+}
+
+std::shared_ptr<Object> Cell::get_object() const
+{
+    if (type == Type::None) {
+        return nullptr;
+    }
+    assert(type == Type::Object);
+    return object_ptr;
+}
+
 std::shared_ptr<Object> Cell::object()
 {
     if (type == Type::None) {
-        type = Type::Object;
+        init(Type::Object);
     }
     assert(type == Type::Object);
     return object_ptr;
@@ -315,7 +345,7 @@ std::shared_ptr<Object> Cell::object()
 std::shared_ptr<Object> &Cell::object_for_write()
 {
     if (type == Type::None) {
-        type = Type::Object;
+        init(Type::Object);
     }
     assert(type == Type::Object);
     return object_ptr;
@@ -324,7 +354,7 @@ std::shared_ptr<Object> &Cell::object_for_write()
 const std::vector<Cell> &Cell::array()
 {
     if (type == Type::None) {
-        type = Type::Array;
+        init(Type::Array);
     }
     assert(type == Type::Array);
     if (not array_ptr) {
@@ -336,7 +366,7 @@ const std::vector<Cell> &Cell::array()
 std::vector<Cell> &Cell::array_for_write()
 {
     if (type == Type::None) {
-        type = Type::Array;
+        init(Type::Array);
     }
     assert(type == Type::Array);
     if (not array_ptr) {
@@ -351,7 +381,7 @@ std::vector<Cell> &Cell::array_for_write()
 Cell &Cell::array_index_for_read(size_t i)
 {
     if (type == Type::None) {
-        type = Type::Array;
+        init(Type::Array);
     }
     assert(type == Type::Array);
     if (not array_ptr) {
@@ -363,7 +393,7 @@ Cell &Cell::array_index_for_read(size_t i)
 Cell &Cell::array_index_for_write(size_t i)
 {
     if (type == Type::None) {
-        type = Type::Array;
+        init(Type::Array);
     }
     assert(type == Type::Array);
     if (not array_ptr) {
@@ -378,29 +408,29 @@ Cell &Cell::array_index_for_write(size_t i)
     return array_ptr->at(i);
 }
 
-const std::map<utf8string, Cell> &Cell::dictionary()
+const HashDictionary<Cell> &Cell::dictionary()
 {
     if (type == Type::None) {
-        type = Type::Dictionary;
+        init(Type::Dictionary);
     }
     assert(type == Type::Dictionary);
     if (not dictionary_ptr) {
-        dictionary_ptr = std::make_shared<std::map<utf8string, Cell>>();
+        dictionary_ptr = std::make_shared<HashDictionary<Cell>>();
     }
     return *dictionary_ptr;
 }
 
-std::map<utf8string, Cell> &Cell::dictionary_for_write()
+HashDictionary<Cell> &Cell::dictionary_for_write()
 {
     if (type == Type::None) {
-        type = Type::Dictionary;
+        init(Type::Dictionary);
     }
     assert(type == Type::Dictionary);
     if (not dictionary_ptr) {
-        dictionary_ptr = std::make_shared<std::map<utf8string, Cell>>();
+        dictionary_ptr = std::make_shared<HashDictionary<Cell>>();
     }
     if (not dictionary_ptr.unique()) {
-        dictionary_ptr = std::make_shared<std::map<utf8string, Cell>>(*dictionary_ptr);
+        dictionary_ptr = std::make_shared<HashDictionary<Cell>>(*dictionary_ptr);
     }
     return *dictionary_ptr;
 }
@@ -408,11 +438,11 @@ std::map<utf8string, Cell> &Cell::dictionary_for_write()
 Cell &Cell::dictionary_index_for_read(const utf8string &index)
 {
     if (type == Type::None) {
-        type = Type::Dictionary;
+        init(Type::Dictionary);
     }
     assert(type == Type::Dictionary);
     if (not dictionary_ptr) {
-        dictionary_ptr = std::make_shared<std::map<utf8string, Cell>>();
+        dictionary_ptr = std::make_shared<HashDictionary<Cell>>();
     }
     return dictionary_ptr->at(index);
 }
@@ -420,14 +450,14 @@ Cell &Cell::dictionary_index_for_read(const utf8string &index)
 Cell &Cell::dictionary_index_for_write(const utf8string &index)
 {
     if (type == Type::None) {
-        type = Type::Dictionary;
+        init(Type::Dictionary);
     }
     assert(type == Type::Dictionary);
     if (not dictionary_ptr) {
-        dictionary_ptr = std::make_shared<std::map<utf8string, Cell>>();
+        dictionary_ptr = std::make_shared<HashDictionary<Cell>>();
     }
     if (not dictionary_ptr.unique()) {
-        dictionary_ptr = std::make_shared<std::map<utf8string, Cell>>(*dictionary_ptr);
+        dictionary_ptr = std::make_shared<HashDictionary<Cell>>(*dictionary_ptr);
     }
     return dictionary_ptr->operator[](index);
 }
@@ -435,7 +465,7 @@ Cell &Cell::dictionary_index_for_write(const utf8string &index)
 void *&Cell::other()
 {
     if (type == Type::None) {
-        type = Type::Other;
+        init(Type::Other);
     }
     assert(type == Type::Other);
     return other_ptr;
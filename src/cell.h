@@ -1,20 +1,24 @@
 #ifndef CELL_H
 #define CELL_H
 
-#include <map>
 #include <memory>
 #include <vector>
 
+#include "hashdictionary.h"
 #include "number.h"
 #include "object.h"
 #include "utf8string.h"
 
-// TODO: See if we can use std::variant (C++17) for this.
+// A Cell holds exactly one value at a time. The value is stored in a
+// union, so only the member that corresponds to the current type is
+// constructed. A Cell with type None becomes whatever type is first
+// asked for through one of the accessors.
 
 class Cell {
 public:
     Cell();
     Cell(const Cell &rhs);
+    Cell(Cell &&rhs) noexcept;
     explicit Cell(Cell *value);
     explicit Cell(bool value);
     explicit Cell(Number value);
@@ -23,9 +27,12 @@ public:
     explicit Cell(const std::vector<unsigned char> &value);
     explicit Cell(const std::shared_ptr<Object> &value);
     explicit Cell(const std::vector<Cell> &value, bool alloced = false);
-    explicit Cell(const std::map<utf8string, Cell> &value);
+    explicit Cell(std::vector<Cell> &&value);
+    explicit Cell(const HashDictionary<Cell> &value);
+    ~Cell();
     static Cell makeOther(void *p) { Cell r; r.type = Type::Other; r.other_ptr = p; return r; }
     Cell &operator=(const Cell &rhs);
+    Cell &operator=(Cell &&rhs) noexcept;
     bool operator==(const Cell &rhs) const;
 
     enum class Type {
@@ -51,37 +58,92 @@ public:
     const std::vector<unsigned char> &bytes();
     std::vector<unsigned char> &bytes_for_write();
     void set_bytes(const std::vector<unsigned char> &bytes);
+    const utf8string &get_string() const;
+    std::shared_ptr<Object> get_object() const;
     std::shared_ptr<Object> object();
     std::shared_ptr<Object> &object_for_write();
     const std::vector<Cell> &array();
     std::vector<Cell> &array_for_write();
     Cell &array_index_for_read(size_t i);
     Cell &array_index_for_write(size_t i);
-    const std::map<utf8string, Cell> &dictionary();
-    std::map<utf8string, Cell> &dictionary_for_write();
+    const HashDictionary<Cell> &dictionary();
+    HashDictionary<Cell> &dictionary_for_write();
     Cell &dictionary_index_for_read(const utf8string &index);
     Cell &dictionary_index_for_write(const utf8string &index);
     void *&other();
 
     struct GC {
-        explicit GC(bool alloced = false): alloced(alloced), marked(false) {}
+        explicit GC(bool alloced = false): alloced(alloced) {}
         GC(const GC &) = delete;
         GC &operator=(const GC &) = delete;
         const bool alloced;
-        bool marked;
     } gc;
 
 private:
     Type type;
-    Cell *address_value;
-    bool boolean_value;
-    Number number_value;
-    std::shared_ptr<utf8string> string_ptr;
-    std::shared_ptr<std::vector<unsigned char>> bytes_ptr;
-    std::shared_ptr<Object> object_ptr;
-    std::shared_ptr<std::vector<Cell>> array_ptr;
-    std::shared_ptr<std::map<utf8string, Cell>> dictionary_ptr;
-    void *other_ptr;
+    union {
+        Cell *address_value;
+        bool boolean_value;
+        Number number_value;
+        std::shared_ptr<utf8string> string_ptr;
+        std::shared_ptr<std::vector<unsigned char>> bytes_ptr;
+        std::shared_ptr<Object> object_ptr;
+        std::shared_ptr<std::vector<Cell>> array_ptr;
+        std::shared_ptr<HashDictionary<Cell>> dictionary_ptr;
+        void *other_ptr;
+    };
+
+    void init(Type t);
+    void copy_from(const Cell &rhs);
+    void move_from(Cell &rhs);
+    void destroy();
+};
+
+// How an element of a typed array reads through an ArrayView. An element
+// that has never been assigned (such as one added by resize()) reads as
+// the empty value of its type, without being changed.
+template <typename T> struct ArrayElement;
+
+template <> struct ArrayElement<Number> {
+    typedef Number reference;
+    static Number get(const Cell &c) { return c.get_type() == Cell::Type::None ? Number() : c.get_number(); }
+};
+
+template <> struct ArrayElement<utf8string> {
+    typedef const utf8string &reference;
+    static const utf8string &get(const Cell &c) { return c.get_string(); }
+};
+
+template <> struct ArrayElement<std::shared_ptr<Object>> {
+    typedef std::shared_ptr<Object> reference;
+    static std::shared_ptr<Object> get(const Cell &c) { return c.get_object(); }
+};
+
+// A borrowed, read-only view of the elements of an array Cell, which is
+// how native functions receive typed array parameters such as
+// Array<String>. The view refers to the array on the caller's stack, so
+// it is only valid for the duration of the call.
+template <typename T> class ArrayView {
+public:
+    typedef typename ArrayElement<T>::reference reference;
+    class const_iterator {
+    public:
+        explicit const_iterator(std::vector<Cell>::const_iterator i): i(i) {}
+        reference operator*() const { return ArrayElement<T>::get(*i); }
+        const_iterator &operator++() { ++i; return *this; }
+        bool operator==(const const_iterator &rhs) const { return i == rhs.i; }
+        bool operator!=(const const_iterator &rhs) const { return i != rhs.i; }
+    private:
+        std::vector<Cell>::const_iterator i;
+    };
+    explicit ArrayView(const std::vector<Cell> &a): a(a) {}
+    bool empty() const { return a.empty(); }
+    size_t size() const { return a.size(); }
+    reference operator[](size_t i) const { return ArrayElement<T>::get(a[i]); }
+    const_iterator begin() const { return const_iterator(a.begin()); }
+    const_iterator end() const { return const_iterator(a.end()); }
+private:
+    const std::vector<Cell> &a;
 };
 
 #endif
@@ -2,15 +2,17 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <chrono>
 #include <fstream>
 #include <iso646.h>
 #include <iostream>
-#include <list>
 #include <map>
+#include <new>
 #include <set>
 #include <sstream>
 #include <stdlib.h>
 #include <string.h>
+#include <type_traits>
 
 #include <minijson_writer.hpp>
 
@@ -35,6 +37,11 @@
 #define LIBRARY_NAME_PREFIX "lib"
 #endif
 
+// Computed goto (labels as values) is a GNU extension, also supported by clang.
+#if defined(__GNUC__) && !defined(NEON_NO_THREADED_DISPATCH)
+#define NEON_THREADED_DISPATCH
+#endif
+
 std::set<std::string> g_ExtensionModules;
 
 void executor_raise_exception(size_t ip, const utf8string &name, const utf8string &info);
@@ -96,13 +103,442 @@ public:
 
 class ActivationFrame {
 public:
-    ActivationFrame(uint32_t nesting_depth, ActivationFrame *outer, size_t count, size_t opstack_depth): nesting_depth(nesting_depth), outer(outer), locals(count), opstack_depth(opstack_depth) {}
+    ActivationFrame(uint32_t nesting_depth, ActivationFrame *outer, ActivationFrame *caller, Cell *locals, size_t count, size_t opstack_depth, size_t chunk, size_t offset)
+      : nesting_depth(nesting_depth),
+        outer(outer),
+        caller(caller),
+        locals(locals),
+        count(count),
+        opstack_depth(opstack_depth),
+        chunk(chunk),
+        offset(offset) {}
     ActivationFrame(const ActivationFrame &) = delete;
     ActivationFrame &operator=(const ActivationFrame &) = delete;
+    Cell &local(size_t i) { assert(i < count); return locals[i]; }
     uint32_t nesting_depth;
     ActivationFrame *outer;
-    std::vector<Cell> locals;
+    ActivationFrame *caller;
+    Cell *const locals;
+    const size_t count;
     size_t opstack_depth;
+    // Where this frame starts in the FrameStack, so that popping it
+    // can hand the space back.
+    const size_t chunk;
+    const size_t offset;
+};
+
+// Activation frames are kept in a stack of large chunks. Each frame is a
+// header followed directly by its locals, so once the chunks have grown to
+// the deepest call seen, a call only advances an offset. A chunk is never
+// moved or freed while it holds frames, because outer links and the local
+// addresses pushed by PUSHPL point into it.
+class FrameStack {
+public:
+    FrameStack(): chunks(), top(nullptr), depth(0) {}
+    FrameStack(const FrameStack &) = delete;
+    FrameStack &operator=(const FrameStack &) = delete;
+    ~FrameStack();
+
+    bool empty() const { return top == nullptr; }
+    size_t size() const { return depth; }
+    ActivationFrame &back() { return *top; }
+    // The innermost frame; follow caller links for the rest.
+    ActivationFrame *innermost() { return top; }
+    void emplace_back(uint32_t nesting_depth, ActivationFrame *outer, size_t count, size_t opstack_depth);
+    void pop_back();
+
+private:
+    typedef std::aligned_storage<sizeof(Cell), alignof(Cell)>::type Slot;
+    static const size_t CHUNK_SLOTS = 4096;
+    static const size_t HEADER_SLOTS = (sizeof(ActivationFrame) + sizeof(Slot) - 1) / sizeof(Slot);
+    static_assert(alignof(ActivationFrame) <= alignof(Slot), "frame header alignment");
+
+    struct Chunk {
+        explicit Chunk(size_t size): slots(new Slot[size]), size(size), used(0) {}
+        std::unique_ptr<Slot[]> slots;
+        size_t size;
+        size_t used;
+    };
+    std::vector<Chunk> chunks;
+    ActivationFrame *top;
+    size_t depth;
+};
+
+FrameStack::~FrameStack()
+{
+    while (top != nullptr) {
+        pop_back();
+    }
+}
+
+void FrameStack::emplace_back(uint32_t nesting_depth, ActivationFrame *outer, size_t count, size_t opstack_depth)
+{
+    size_t need = HEADER_SLOTS + count;
+    size_t c = 0;
+    if (top != nullptr) {
+        c = top->chunk;
+        if (chunks[c].size - chunks[c].used < need) {
+            c++;
+        }
+    }
+    // Every chunk past the one holding the innermost frame is empty, so
+    // one that is too small can simply be replaced.
+    size_t size = need > CHUNK_SLOTS ? need : CHUNK_SLOTS;
+    if (c == chunks.size()) {
+        chunks.emplace_back(size);
+    } else if (chunks[c].size < need) {
+        assert(chunks[c].used == 0);
+        chunks[c] = Chunk(size);
+    }
+    Chunk &chunk = chunks[c];
+    Slot *p = &chunk.slots[chunk.used];
+    Cell *locals = reinterpret_cast<Cell *>(p + HEADER_SLOTS);
+    for (size_t i = 0; i < count; i++) {
+        new (&locals[i]) Cell();
+    }
+    top = new (p) ActivationFrame(nesting_depth, outer, top, locals, count, opstack_depth, c, chunk.used);
+    chunk.used += need;
+    depth++;
+}
+
+void FrameStack::pop_back()
+{
+    ActivationFrame *f = top;
+    for (size_t i = 0; i < f->count; i++) {
+        f->locals[i].~Cell();
+    }
+    chunks[f->chunk].used = f->offset;
+    top = f->caller;
+    f->~ActivationFrame();
+    depth--;
+}
+
+// Records allocated with NEW live in a segmented heap. Each segment holds a
+// fixed number of cell slots, and keeps bitmaps recording which slots are in
+// use, which have been marked by the current collection, and which were
+// allocated since the last collection (the nursery). Cells never move once
+// allocated, because Address cells point directly at them.
+//
+// Marking is incremental, using the usual tri-colour scheme. A record is
+// white while its mark bit is clear, grey while it is marked and waiting in
+// the grey stack, and black once its contents have been scanned. Records
+// allocated while marking is in progress start out black. Every store that
+// can put a pointer into a record shades the stored value first (see
+// Executor::write_barrier), so a black record never refers to a white one.
+// That holds whichever way the pointer reached the stack, and whenever the
+// address being stored through was computed. The roots are not covered by
+// the barrier, so they are scanned again in the final step of marking,
+// which is not incremental.
+//
+// A minor collection only sweeps the nursery, so its cost depends on how
+// many records were allocated recently rather than on the size of the whole
+// heap. Survivors are promoted to the old generation simply by clearing
+// their nursery bits. Old records are swept by a major collection, which
+// runs when the old generation has doubled since the last one.
+class Heap {
+public:
+    Heap(): segments(), nursery(), current(0), young_count(0), old_count(0), major_threshold(MIN_MAJOR_THRESHOLD), marking(false), grey(), scan_stack() {}
+    Heap(const Heap &) = delete;
+    Heap &operator=(const Heap &) = delete;
+    ~Heap();
+
+    Cell *allocate(size_t size);
+    void start_marking();
+    void shade(Cell *c);
+    bool mark_step(std::chrono::steady_clock::time_point deadline);
+    void finish_marking();
+    void sweep_nursery();
+    void sweep_all();
+    bool is_marking() const { return marking; }
+    size_t count() const { return young_count + old_count; }
+    bool major_due() const { return old_count >= major_threshold; }
+
+private:
+    static const size_t SLOTS = 1024;
+    static const size_t WORDS = SLOTS / 64;
+    static const size_t MIN_MAJOR_THRESHOLD = 4 * SLOTS;
+
+    struct Segment {
+        Segment(): used(), marked(), young(), count(0), in_nursery(false), slots() {}
+        Segment(const Segment &) = delete;
+        Segment &operator=(const Segment &) = delete;
+        uint64_t used[WORDS];
+        uint64_t marked[WORDS];
+        uint64_t young[WORDS];
+        size_t count;
+        bool in_nursery;
+        std::aligned_storage<sizeof(Cell), alignof(Cell)>::type slots[SLOTS];
+        Cell *slot(size_t i) { return reinterpret_cast<Cell *>(&slots[i]); }
+    };
+
+    // Sorted by address, so the segment holding a cell can be found
+    // with a binary search.
+    std::vector<Segment *> segments;
+    std::vector<Segment *> nursery;
+    // Segments before this index have no free slots. Slots are only freed
+    // by a sweep, which resets this to zero.
+    size_t current;
+    size_t young_count;
+    size_t old_count;
+    size_t major_threshold;
+    bool marking;
+    // Only records (which never move) are kept between marking steps.
+    // Cells inside a record's array or dictionary may be moved by the
+    // program, so they are only ever held in scan_stack while scanning.
+    std::vector<Cell *> grey;
+    std::vector<Cell *> scan_stack;
+
+    Segment *find_segment(const Cell *c) const;
+    void scan(Cell *c);
+    size_t sweep(Segment *s, bool young_only);
+};
+
+namespace {
+
+inline unsigned lowest_bit(uint64_t w)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(w);
+#else
+    unsigned r = 0;
+    while ((w & 1) == 0) {
+        w >>= 1;
+        r++;
+    }
+    return r;
+#endif
+}
+
+} // namespace
+
+Heap::~Heap()
+{
+    for (auto s: segments) {
+        for (size_t w = 0; w < WORDS; w++) {
+            for (uint64_t bits = s->used[w]; bits != 0; bits &= bits - 1) {
+                s->slot(w * 64 + lowest_bit(bits))->~Cell();
+            }
+        }
+        delete s;
+    }
+}
+
+Cell *Heap::allocate(size_t size)
+{
+    while (current < segments.size() && segments[current]->count == SLOTS) {
+        current++;
+    }
+    if (current == segments.size()) {
+        Segment *s = new Segment;
+        auto p = std::upper_bound(segments.begin(), segments.end(), s);
+        current = p - segments.begin();
+        segments.insert(p, s);
+    }
+    Segment *s = segments[current];
+    size_t w = 0;
+    while (s->used[w] == ~UINT64_C(0)) {
+        w++;
+    }
+    unsigned b = lowest_bit(~s->used[w]);
+    Cell *r = new (s->slot(w * 64 + b)) Cell(std::vector<Cell>(size), true);
+    s->used[w] |= UINT64_C(1) << b;
+    s->young[w] |= UINT64_C(1) << b;
+    if (marking) {
+        s->marked[w] |= UINT64_C(1) << b;
+    }
+    s->count++;
+    if (not s->in_nursery) {
+        s->in_nursery = true;
+        nursery.push_back(s);
+    }
+    young_count++;
+    return r;
+}
+
+Heap::Segment *Heap::find_segment(const Cell *c) const
+{
+    auto p = std::upper_bound(segments.begin(), segments.end(), c, [](const Cell *c, Segment *s) { return reinterpret_cast<const void *>(c) < reinterpret_cast<const void *>(s); });
+    assert(p != segments.begin());
+    return *(p - 1);
+}
+
+void Heap::start_marking()
+{
+    assert(not marking);
+    for (auto s: segments) {
+        memset(s->marked, 0, sizeof(s->marked));
+    }
+    marking = true;
+}
+
+// Make a white record grey. A cell that is not a record is part of a root
+// or of some other value, so its contents are scanned straight away.
+void Heap::shade(Cell *c)
+{
+    if (c == nullptr) {
+        return;
+    }
+    if (c->gc.alloced) {
+        Segment *s = find_segment(c);
+        size_t i = c - s->slot(0);
+        uint64_t bit = UINT64_C(1) << (i % 64);
+        if ((s->marked[i / 64] & bit) == 0) {
+            s->marked[i / 64] |= bit;
+            grey.push_back(c);
+        }
+    } else {
+        scan(c);
+    }
+}
+
+// Shade every record that the given cell refers to.
+void Heap::scan(Cell *c)
+{
+    scan_stack.push_back(c);
+    while (not scan_stack.empty()) {
+        c = scan_stack.back();
+        scan_stack.pop_back();
+        switch (c->get_type()) {
+            case Cell::Type::None:
+            case Cell::Type::Boolean:
+            case Cell::Type::Number:
+            case Cell::Type::String:
+            case Cell::Type::Bytes:
+            case Cell::Type::Object:
+                // nothing
+                break;
+            case Cell::Type::Address: {
+                Cell *a = c->address();
+                if (a != nullptr) {
+                    if (a->gc.alloced) {
+                        shade(a);
+                    } else {
+                        scan_stack.push_back(a);
+                    }
+                }
+                break;
+            }
+            case Cell::Type::Array:
+                for (auto &x: c->array()) {
+                    scan_stack.push_back(const_cast<Cell *>(&x));
+                }
+                break;
+            case Cell::Type::Dictionary:
+                for (auto &x: c->dictionary().unordered()) {
+                    scan_stack.push_back(const_cast<Cell *>(&x.second));
+                }
+                break;
+            case Cell::Type::Other:
+                break;
+        }
+    }
+}
+
+// Scan grey records until there are none left, or until the deadline has
+// passed. Return true if there are no grey records left.
+bool Heap::mark_step(std::chrono::steady_clock::time_point deadline)
+{
+    // Reading the clock is not free, so only check it every so often.
+    const int CHECK_INTERVAL = 32;
+    int n = 0;
+    while (not grey.empty()) {
+        Cell *c = grey.back();
+        grey.pop_back();
+        scan(c);
+        if (++n == CHECK_INTERVAL) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            n = 0;
+        }
+    }
+    return grey.empty();
+}
+
+// Mark everything reachable from the grey records without stopping.
+// The caller is expected to have shaded the roots again first.
+void Heap::finish_marking()
+{
+    assert(marking);
+    while (not grey.empty()) {
+        Cell *c = grey.back();
+        grey.pop_back();
+        scan(c);
+    }
+    marking = false;
+}
+
+// Destroy the unmarked cells in a segment (only the nursery ones if
+// young_only is set), and return the number destroyed.
+size_t Heap::sweep(Segment *s, bool young_only)
+{
+    size_t freed = 0;
+    for (size_t w = 0; w < WORDS; w++) {
+        uint64_t dead = s->used[w] & ~s->marked[w];
+        if (young_only) {
+            dead &= s->young[w];
+        }
+        for (uint64_t bits = dead; bits != 0; bits &= bits - 1) {
+            s->slot(w * 64 + lowest_bit(bits))->~Cell();
+        }
+        s->used[w] &= ~dead;
+        s->young[w] = 0;
+        while (dead != 0) {
+            dead &= dead - 1;
+            freed++;
+        }
+    }
+    s->count -= freed;
+    s->in_nursery = false;
+    return freed;
+}
+
+void Heap::sweep_nursery()
+{
+    assert(not marking);
+    size_t freed = 0;
+    for (auto s: nursery) {
+        freed += sweep(s, true);
+    }
+    nursery.clear();
+    old_count += young_count - freed;
+    young_count = 0;
+    current = 0;
+}
+
+void Heap::sweep_all()
+{
+    assert(not marking);
+    auto keep = segments.begin();
+    for (auto s: segments) {
+        sweep(s, false);
+        if (s->count > 0) {
+            *keep++ = s;
+        } else {
+            delete s;
+        }
+    }
+    segments.erase(keep, segments.end());
+    nursery.clear();
+    old_count = 0;
+    for (auto s: segments) {
+        old_count += s->count;
+    }
+    young_count = 0;
+    major_threshold = 2 * old_count > MIN_MAJOR_THRESHOLD ? 2 * old_count : MIN_MAJOR_THRESHOLD;
+    current = 0;
+}
+
+// This is the fixed width form of a single instruction that the executor
+// runs. When a module is loaded, its bytecode is decoded into an array of
+// these so that instruction handlers don't need to decode variable length
+// operands every time they run. Jump targets are instruction indexes, not
+// byte offsets.
+struct Instruction {
+    Opcode opcode;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
 };
 
 class Executor;
@@ -116,9 +552,100 @@ public:
     Bytecode object;
     const DebugInfo *debug;
     std::vector<Cell> globals;
-    std::vector<size_t> rtl_call_tokens;
-    std::vector<std::pair<bool, Number>> number_table;
+    std::vector<const RtlFunction *> rtl_functions;
+    // Literal values for PUSHN, PUSHS and PUSHY, built when the module is
+    // loaded. Each of those instructions refers to an entry here by its a
+    // operand, and pushes a copy that shares the literal's storage (strings
+    // and bytes are copied on write, so the pool entry never changes).
+    std::vector<Cell> constants;
     std::map<std::pair<std::string, std::string>, std::pair<Module *, int>> module_functions;
+    std::vector<Instruction> code;
+    // Byte offset in object.code of each instruction in code, plus one
+    // more entry for the end of the code. Debug info, breakpoints, and
+    // exception info all use byte offsets.
+    std::vector<size_t> offsets;
+    std::vector<size_t> function_entries;
+    std::vector<Bytecode::ExceptionInfo> exceptions;
+    // Each CALLX instruction refers to an entry here, by its a operand.
+    // The library and symbol names are worked out when the module is
+    // loaded, and the function is looked up the first time it is called.
+    struct ExtensionCall {
+        ExtensionCall(const std::string &modname, const std::string &funcname, const std::string &library, uint32_t out_param_count)
+          : modname(modname),
+            funcname(funcname),
+            library(library),
+            function(nullptr),
+            out_params(),
+            busy(false) {
+            out_params.array_for_write().resize(out_param_count);
+        }
+        std::string modname;
+        std::string funcname;
+        std::string library;
+        Ne_ExtensionFunction function;
+        // Reused by every call unless the call is reentered from a callback.
+        Cell out_params;
+        bool busy;
+    };
+    std::vector<ExtensionCall> extension_calls;
+private:
+    void decode();
+    size_t instruction_index(size_t offset) const;
+};
+
+// Collects the execution profile for --profile. Each instruction is counted
+// and timed as it runs, and the time is charged to that instruction. These
+// add up to the self time of each opcode, function, and source line. About
+// once a millisecond the call stack is also sampled, which gives the total
+// time of each function and the collapsed stacks for flame graph tools.
+class Profiler {
+public:
+    Profiler(const Module *main, const std::string &stacks_path);
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    void tick(const Module *module, size_t ip, const std::vector<std::pair<Module *, size_t>> &callstack) {
+        auto now = std::chrono::steady_clock::now();
+        if (current != nullptr) {
+            current->nanoseconds[current_ip] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+        }
+        if (module != current_module) {
+            current = &module_profile(module);
+            current_module = module;
+        }
+        current->counts[ip]++;
+        current_ip = ip;
+        last = now;
+        if (now - last_sample >= std::chrono::milliseconds(1)) {
+            sample(module, ip, callstack, now);
+        }
+    }
+    void report();
+
+private:
+    struct ModuleProfile {
+        explicit ModuleProfile(const Module *module);
+        std::vector<uint64_t> counts;
+        std::vector<uint64_t> nanoseconds;
+        // Index into object.functions of the function each instruction is in.
+        std::vector<size_t> function;
+    };
+    const Module *const main;
+    const std::string stacks_path;
+    std::map<const Module *, std::unique_ptr<ModuleProfile>> modules;
+    const Module *current_module;
+    ModuleProfile *current;
+    size_t current_ip;
+    std::chrono::steady_clock::time_point last;
+    std::chrono::steady_clock::time_point last_sample;
+    // Sampled times are in microseconds.
+    std::map<std::string, uint64_t> stacks;
+    std::map<std::string, uint64_t> function_total;
+    bool reported;
+
+    ModuleProfile &module_profile(const Module *module);
+    std::string function_name(const Module *module, size_t ip);
+    void sample(const Module *module, size_t ip, const std::vector<std::pair<Module *, size_t>> &callstack, std::chrono::steady_clock::time_point now);
 };
 
 class Executor: public IHttpServerHandler {
@@ -138,18 +665,26 @@ public:
     // Module: runtime
     void garbage_collect();
     size_t get_allocated_object_count();
+    size_t get_garbage_collection_count();
+    uint64_t get_garbage_collection_pause_maximum();
+    uint64_t get_garbage_collection_pause_total();
     bool is_module_imported(const std::string &module);
     bool module_is_main();
     void set_garbage_collection_interval(size_t count);
+    void set_garbage_collection_pause_budget(uint64_t microseconds);
     void set_recursion_limit(size_t depth);
 
     int exec();
     int exec_loop(size_t min_callstack_depth);
+#ifdef NEON_THREADED_DISPATCH
+    int exec_loop_threaded(size_t min_callstack_depth);
+#endif
 //private:
     const std::string source_path;
     const ExecOptions *options;
 
     size_t param_garbage_collection_interval;
+    uint64_t param_garbage_collection_pause_budget;
     size_t param_recursion_limit;
 
     std::map<std::string, Cell *> *external_globals;
@@ -157,14 +692,25 @@ public:
     std::vector<std::string> init_order;
     Module *module;
     int exit_code;
-    Bytecode::Bytes::size_type ip;
+    size_t ip;
     opstack<Cell> stack;
-    std::vector<std::pair<Module *, Bytecode::Bytes::size_type>> callstack;
-    std::list<ActivationFrame> frames;
+    std::vector<std::pair<Module *, size_t>> callstack;
+    FrameStack frames;
     volatile bool interrupted;
 
-    std::list<Cell> allocs;
+    Heap heap;
     unsigned int allocations;
+    const RtlFunction *const rtl_array_append;
+    const RtlFunction *const rtl_array_extend;
+    // Pause times are in microseconds.
+    struct GarbageCollectionStatistics {
+        GarbageCollectionStatistics(): count(0), pause_total(0), pause_maximum(0) {}
+        size_t count;
+        uint64_t pause_total;
+        uint64_t pause_maximum;
+    } gc_statistics;
+
+    std::unique_ptr<Profiler> profiler;
 
     enum class DebuggerState {
         STOPPED,
@@ -277,6 +823,15 @@ public:
     void exec_PUSHCI();
     void exec_PUSHMFP();
 
+    void collect_garbage(bool finish);
+    void mark_roots();
+    // Shade a value that is about to be stored, in case the cell it is
+    // stored in belongs to a record that has already been scanned.
+    void write_barrier(Cell *value) {
+        if (heap.is_marking()) {
+            heap.shade(value);
+        }
+    }
     void invoke(Module *m, uint32_t index);
     void raise_literal(const utf8string &exception, std::shared_ptr<Object> info);
     void raise(const ExceptionName &exception, std::shared_ptr<Object> info);
@@ -398,7 +953,9 @@ const char *cell_get_string(const struct Ne_Cell *cell)
 
 void cell_set_string(struct Ne_Cell *cell, const char *value)
 {
-    reinterpret_cast<Cell *>(cell)->string_for_write() = utf8string(value);
+    utf8string &s = reinterpret_cast<Cell *>(cell)->string_for_write();
+    s.clear();
+    s.append(value);
 }
 
 const unsigned char *cell_get_bytes(const struct Ne_Cell *cell)
@@ -413,7 +970,7 @@ int cell_get_bytes_size(const struct Ne_Cell *cell)
 
 void cell_set_bytes(struct Ne_Cell *cell, const unsigned char *value, int size)
 {
-    reinterpret_cast<Cell *>(cell)->set_bytes(std::vector<unsigned char>(value, value+size));
+    reinterpret_cast<Cell *>(cell)->bytes_for_write().assign(value, value+size);
 }
 
 void *cell_get_pointer(const struct Ne_Cell *cell)
@@ -457,10 +1014,7 @@ int cell_get_dictionary_size(const struct Ne_Cell *cell)
 
 const char *cell_get_dictionary_key(const struct Ne_Cell *cell, int n)
 {
-    const std::map<utf8string, Cell> &d = reinterpret_cast<Cell *>(const_cast<struct Ne_Cell *>(cell))->dictionary();
-    std::map<utf8string, Cell>::const_iterator i = d.begin();
-    std::advance(i, n);
-    return i->first.c_str();
+    return reinterpret_cast<Cell *>(const_cast<struct Ne_Cell *>(cell))->dictionary().nth(n).first.c_str();
 }
 
 const struct Ne_Cell *cell_get_dictionary_cell(const struct Ne_Cell *cell, const char *key)
@@ -514,6 +1068,38 @@ int raise_exception(struct Ne_Cell *retval, const char *name, const char *info,
     return Ne_EXCEPTION;
 }
 
+int cell_get_string_size(const struct Ne_Cell *cell)
+{
+    return static_cast<int>(reinterpret_cast<Cell *>(const_cast<struct Ne_Cell *>(cell))->string().size());
+}
+
+char *cell_resize_string(struct Ne_Cell *cell, int size)
+{
+    utf8string &s = reinterpret_cast<Cell *>(cell)->string_for_write();
+    s.resize(size);
+    return s.data_for_write();
+}
+
+unsigned char *cell_resize_bytes(struct Ne_Cell *cell, int size)
+{
+    std::vector<unsigned char> &b = reinterpret_cast<Cell *>(cell)->bytes_for_write();
+    b.resize(size);
+    return b.data();
+}
+
+const char *cell_get_dictionary_entry(const struct Ne_Cell *cell, int n, const struct Ne_Cell **value)
+{
+    auto &d = reinterpret_cast<Cell *>(const_cast<struct Ne_Cell *>(cell))->dictionary();
+    if (n < 0 || static_cast<size_t>(n) >= d.size()) {
+        return nullptr;
+    }
+    auto &entry = d.nth(n);
+    if (value != nullptr) {
+        *value = reinterpret_cast<const struct Ne_Cell *>(&entry.second);
+    }
+    return entry.first.c_str();
+}
+
 } // extern "C"
 
 const Ne_MethodTable ExtensionMethodTable = {
@@ -548,13 +1134,204 @@ const Ne_MethodTable ExtensionMethodTable = {
     cell_get_dictionary_cell,
     cell_set_dictionary_cell,
     exec_callback,
-    raise_exception
+    raise_exception,
+    cell_get_string_size,
+    cell_resize_string,
+    cell_resize_bytes,
+    cell_get_dictionary_entry
 };
 
+Profiler::Profiler(const Module *main, const std::string &stacks_path)
+  : main(main),
+    stacks_path(stacks_path),
+    modules(),
+    current_module(nullptr),
+    current(nullptr),
+    current_ip(0),
+    last(std::chrono::steady_clock::now()),
+    last_sample(last),
+    stacks(),
+    function_total(),
+    reported(false)
+{
+}
+
+Profiler::ModuleProfile::ModuleProfile(const Module *module)
+  : counts(module->code.size()),
+    nanoseconds(module->code.size()),
+    function(module->code.size())
+{
+    std::vector<std::pair<size_t, size_t>> entries;
+    for (size_t f = 0; f < module->function_entries.size(); f++) {
+        entries.push_back(std::make_pair(module->function_entries[f], f));
+    }
+    std::sort(entries.begin(), entries.end());
+    auto e = entries.begin();
+    size_t f = 0;
+    for (size_t i = 0; i < function.size(); i++) {
+        while (e != entries.end() && e->first <= i) {
+            f = e->second;
+            ++e;
+        }
+        function[i] = f;
+    }
+}
+
+Profiler::ModuleProfile &Profiler::module_profile(const Module *module)
+{
+    auto &p = modules[module];
+    if (p == nullptr) {
+        p.reset(new ModuleProfile(module));
+    }
+    return *p;
+}
+
+std::string Profiler::function_name(const Module *module, size_t ip)
+{
+    size_t f = module_profile(module).function[ip];
+    std::string name = module->object.strtable[module->object.functions[f].name];
+    if (module == main) {
+        return name.empty() ? "(main)" : name;
+    }
+    return name.empty() ? module->name : module->name + "." + name;
+}
+
+void Profiler::sample(const Module *module, size_t ip, const std::vector<std::pair<Module *, size_t>> &callstack, std::chrono::steady_clock::time_point now)
+{
+    uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(now - last_sample).count();
+    last_sample = now;
+    std::string stack;
+    std::set<std::string> seen;
+    auto add = [&](const Module *m, size_t i) {
+        std::string name = function_name(m, i);
+        if (not stack.empty()) {
+            stack.push_back(';');
+        }
+        stack.append(name);
+        // Count recursive functions only once.
+        if (seen.insert(name).second) {
+            function_total[name] += us;
+        }
+    };
+    for (auto &c: callstack) {
+        // The bottom of the call stack returns past the end of the main module.
+        if (c.second < c.first->code.size()) {
+            // Return addresses point after the call instruction.
+            add(c.first, c.second > 0 ? c.second - 1 : 0);
+        }
+    }
+    add(module, ip);
+    stacks[stack] += us;
+}
+
+void Profiler::report()
+{
+    if (reported) {
+        return;
+    }
+    reported = true;
+    if (current != nullptr) {
+        current->nanoseconds[current_ip] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - last).count();
+    }
+
+    struct Entry {
+        Entry(): count(0), nanoseconds(0) {}
+        uint64_t count;
+        uint64_t nanoseconds;
+    };
+    std::map<std::string, Entry> opcodes;
+    std::map<std::string, Entry> functions;
+    std::map<std::pair<const Module *, int>, Entry> lines;
+    uint64_t total_count = 0;
+    uint64_t total_nanoseconds = 0;
+    for (auto &m: modules) {
+        const Module *module = m.first;
+        const ModuleProfile &p = *m.second;
+        for (size_t i = 0; i < p.counts.size(); i++) {
+            if (p.counts[i] == 0) {
+                continue;
+            }
+            total_count += p.counts[i];
+            total_nanoseconds += p.nanoseconds[i];
+            size_t offset = module->offsets[i];
+            std::string op = disassemble_instruction(module->object, offset);
+            op = op.substr(0, op.find(' '));
+            opcodes[op].count += p.counts[i];
+            opcodes[op].nanoseconds += p.nanoseconds[i];
+            Entry &f = functions[function_name(module, i)];
+            f.count += p.counts[i];
+            f.nanoseconds += p.nanoseconds[i];
+            if (module->debug != nullptr) {
+                auto line = module->debug->line_numbers.upper_bound(module->offsets[i]);
+                if (line != module->debug->line_numbers.begin()) {
+                    --line;
+                    Entry &l = lines[std::make_pair(module, line->second)];
+                    l.count += p.counts[i];
+                    l.nanoseconds += p.nanoseconds[i];
+                }
+            }
+        }
+    }
+
+    auto by_time = [](const std::pair<std::string, Entry> &a, const std::pair<std::string, Entry> &b) {
+        return a.second.nanoseconds > b.second.nanoseconds;
+    };
+    auto percent = [total_nanoseconds](uint64_t ns) {
+        return total_nanoseconds > 0 ? 100.0 * ns / total_nanoseconds : 0.0;
+    };
+    fprintf(stderr, "Profile: %llu instructions in %.3f ms\n", static_cast<unsigned long long>(total_count), total_nanoseconds / 1e6);
+
+    std::vector<std::pair<std::string, Entry>> sorted(opcodes.begin(), opcodes.end());
+    std::sort(sorted.begin(), sorted.end(), by_time);
+    fprintf(stderr, "\n%-10s %14s %12s %7s\n", "opcode", "count", "self ms", "self %");
+    for (auto &e: sorted) {
+        fprintf(stderr, "%-10s %14llu %12.3f %7.2f\n", e.first.c_str(), static_cast<unsigned long long>(e.second.count), e.second.nanoseconds / 1e6, percent(e.second.nanoseconds));
+    }
+
+    sorted.assign(functions.begin(), functions.end());
+    std::sort(sorted.begin(), sorted.end(), by_time);
+    fprintf(stderr, "\n%12s %7s %12s  %s\n", "self ms", "self %", "total ms", "function");
+    for (auto &e: sorted) {
+        fprintf(stderr, "%12.3f %7.2f %12.3f  %s\n", e.second.nanoseconds / 1e6, percent(e.second.nanoseconds), function_total[e.first] / 1e3, e.first.c_str());
+    }
+
+    if (not lines.empty()) {
+        sorted.clear();
+        for (auto &l: lines) {
+            sorted.push_back(std::make_pair(l.first.first->debug->source_path + ":" + std::to_string(l.first.second), l.second));
+        }
+        std::sort(sorted.begin(), sorted.end(), by_time);
+        fprintf(stderr, "\n%12s %7s %14s  %s\n", "self ms", "self %", "count", "line");
+        for (auto &e: sorted) {
+            fprintf(stderr, "%12.3f %7.2f %14llu  %s\n", e.second.nanoseconds / 1e6, percent(e.second.nanoseconds), static_cast<unsigned long long>(e.second.count), e.first.c_str());
+        }
+    }
+
+    if (not stacks_path.empty()) {
+        std::ofstream out(stacks_path);
+        if (not out) {
+            fprintf(stderr, "neon: could not write profile stacks to %s\n", stacks_path.c_str());
+            return;
+        }
+        for (auto &s: stacks) {
+            out << s.first << " " << s.second << "\n";
+        }
+        fprintf(stderr, "\nCollapsed stacks written to %s\n", stacks_path.c_str());
+    }
+}
+
+static void report_profile()
+{
+    if (g_executor != nullptr && g_executor->profiler != nullptr) {
+        g_executor->profiler->report();
+    }
+}
+
 Executor::Executor(const std::string &source_path, const Bytecode::Bytes &bytes, const DebugInfo *debuginfo, ICompilerSupport *support, const ExecOptions *options, unsigned short debug_port, std::map<std::string, Cell *> *external_globals)
   : source_path(source_path),
     options(options),
     param_garbage_collection_interval(1000),
+    param_garbage_collection_pause_budget(0),
     param_recursion_limit(1000),
     external_globals(external_globals),
     modules(),
@@ -566,8 +1343,12 @@ Executor::Executor(const std::string &source_path, const Bytecode::Bytes &bytes,
     callstack(),
     frames(),
     interrupted(false),
-    allocs(),
+    heap(),
     allocations(0),
+    rtl_array_append(rtl_find_function("builtin$array__append")),
+    rtl_array_extend(rtl_find_function("builtin$array__extend")),
+    gc_statistics(),
+    profiler(),
     debug_server(debug_port ? new HttpServer(debug_port, this) : nullptr),
     debugger_state(DebuggerState::STOPPED),
     debugger_step_source_depth(0),
@@ -585,6 +1366,11 @@ Executor::Executor(const std::string &source_path, const Bytecode::Bytes &bytes,
     }
     module = new Module(source_path, b, debuginfo, this, support);
     modules[""] = std::unique_ptr<Module>(module);
+    if (options->enable_profile) {
+        profiler.reset(new Profiler(module, options->profile_stacks_path));
+        // sys.exit() leaves through exit(), so report the profile from there too.
+        atexit(report_profile);
+    }
 }
 
 Executor::~Executor()
@@ -598,10 +1384,16 @@ Module::Module(const std::string &name, const Bytecode &object, const DebugInfo
     object(object),
     debug(debuginfo),
     globals(object.global_size),
-    rtl_call_tokens(object.strtable.size(), SIZE_MAX),
-    number_table(object.strtable.size()),
-    module_functions()
-{
+    rtl_functions(object.strtable.size()),
+    constants(),
+    module_functions(),
+    code(),
+    offsets(),
+    function_entries(),
+    exceptions(),
+    extension_calls()
+{
+    decode();
     for (auto i: object.imports) {
         std::string importname = object.strtable[i.name];
         if (executor->modules.find(importname) != executor->modules.end()) {
@@ -625,67 +1417,254 @@ Module::Module(const std::string &name, const Bytecode &object, const DebugInfo
     }
 }
 
+void Module::decode()
+{
+    const Bytecode::Bytes &bytes = object.code;
+    size_t i = 0;
+    while (i < bytes.size()) {
+        offsets.push_back(i);
+        Instruction instr;
+        instr.opcode = static_cast<Opcode>(bytes[i]);
+        instr.a = 0;
+        instr.b = 0;
+        instr.c = 0;
+        i++;
+        switch (instr.opcode) {
+            case Opcode::PUSHB:
+                instr.a = bytes.at(i) != 0;
+                i++;
+                break;
+            case Opcode::PUSHN:
+            case Opcode::PUSHS:
+            case Opcode::PUSHY:
+            case Opcode::PUSHPG:
+            case Opcode::PUSHPPG:
+            case Opcode::PUSHPL:
+            case Opcode::PUSHI:
+            case Opcode::CALLP:
+            case Opcode::CALLF:
+            case Opcode::JUMP:
+            case Opcode::JF:
+            case Opcode::JT:
+            case Opcode::CONSA:
+            case Opcode::CONSD:
+            case Opcode::EXCEPT:
+            case Opcode::ALLOC:
+            case Opcode::PUSHPEG:
+            case Opcode::JUMPTBL:
+            case Opcode::DROPN:
+            case Opcode::PUSHFP:
+            case Opcode::CALLV:
+            case Opcode::PUSHCI:
+                instr.a = Bytecode::get_vint(bytes, i);
+                break;
+            case Opcode::PUSHPMG:
+            case Opcode::PUSHPOL:
+            case Opcode::CALLMF:
+            case Opcode::PUSHMFP:
+                instr.a = Bytecode::get_vint(bytes, i);
+                instr.b = Bytecode::get_vint(bytes, i);
+                break;
+            case Opcode::CALLX:
+                instr.a = Bytecode::get_vint(bytes, i);
+                instr.b = Bytecode::get_vint(bytes, i);
+                instr.c = Bytecode::get_vint(bytes, i);
+                break;
+            case Opcode::LOADB:
+            case Opcode::LOADN:
+            case Opcode::LOADS:
+            case Opcode::LOADY:
+            case Opcode::LOADA:
+            case Opcode::LOADD:
+            case Opcode::LOADP:
+            case Opcode::LOADJ:
+            case Opcode::STOREB:
+            case Opcode::STOREN:
+            case Opcode::STORES:
+            case Opcode::STOREY:
+            case Opcode::STOREA:
+            case Opcode::STORED:
+            case Opcode::STOREP:
+            case Opcode::STOREJ:
+            case Opcode::NEGN:
+            case Opcode::ADDN:
+            case Opcode::SUBN:
+            case Opcode::MULN:
+            case Opcode::DIVN:
+            case Opcode::MODN:
+            case Opcode::EXPN:
+            case Opcode::EQB:
+            case Opcode::NEB:
+            case Opcode::EQN:
+            case Opcode::NEN:
+            case Opcode::LTN:
+            case Opcode::GTN:
+            case Opcode::LEN:
+            case Opcode::GEN:
+            case Opcode::EQS:
+            case Opcode::NES:
+            case Opcode::LTS:
+            case Opcode::GTS:
+            case Opcode::LES:
+            case Opcode::GES:
+            case Opcode::EQY:
+            case Opcode::NEY:
+            case Opcode::LTY:
+            case Opcode::GTY:
+            case Opcode::LEY:
+            case Opcode::GEY:
+            case Opcode::EQA:
+            case Opcode::NEA:
+            case Opcode::EQD:
+            case Opcode::NED:
+            case Opcode::EQP:
+            case Opcode::NEP:
+            case Opcode::ANDB:
+            case Opcode::ORB:
+            case Opcode::NOTB:
+            case Opcode::INDEXAR:
+            case Opcode::INDEXAW:
+            case Opcode::INDEXAV:
+            case Opcode::INDEXAN:
+            case Opcode::INDEXDR:
+            case Opcode::INDEXDW:
+            case Opcode::INDEXDV:
+            case Opcode::INA:
+            case Opcode::IND:
+            case Opcode::CALLI:
+            case Opcode::DUP:
+            case Opcode::DUPX1:
+            case Opcode::DROP:
+            case Opcode::RET:
+            case Opcode::PUSHNIL:
+            case Opcode::SWAP:
+                break;
+            default:
+                fprintf(stderr, "exec: Unexpected opcode: %d\n", bytes[i-1]);
+                abort();
+        }
+        code.push_back(instr);
+    }
+    offsets.push_back(bytes.size());
+
+    // Now that the offset of every instruction is known, resolve
+    // operands that refer to byte offsets or to other tables.
+    std::map<std::pair<Opcode, uint32_t>, uint32_t> constant_index;
+    for (auto &instr: code) {
+        switch (instr.opcode) {
+            case Opcode::PUSHN:
+            case Opcode::PUSHS:
+            case Opcode::PUSHY: {
+                auto key = std::make_pair(instr.opcode, instr.a);
+                auto c = constant_index.find(key);
+                if (c == constant_index.end()) {
+                    const std::string &str = object.strtable[instr.a];
+                    if (instr.opcode == Opcode::PUSHN) {
+                        constants.emplace_back(number_from_string(str));
+                    } else if (instr.opcode == Opcode::PUSHS) {
+                        constants.emplace_back(utf8string(str));
+                    } else {
+                        constants.emplace_back(std::vector<unsigned char>(str.begin(), str.end()));
+                    }
+                    c = constant_index.emplace(key, static_cast<uint32_t>(constants.size() - 1)).first;
+                }
+                instr.a = c->second;
+                break;
+            }
+            case Opcode::CALLP:
+                rtl_functions[instr.a] = rtl_find_function(object.strtable[instr.a]);
+                break;
+            case Opcode::CALLX: {
+                const std::string &modname = object.strtable[instr.a];
+                extension_calls.emplace_back(modname, object.strtable[instr.b], just_path(object.source_path) + LIBRARY_NAME_PREFIX + "neon_" + modname, instr.c);
+                instr.a = static_cast<uint32_t>(extension_calls.size() - 1);
+                break;
+            }
+            case Opcode::JUMP:
+            case Opcode::JF:
+            case Opcode::JT:
+                instr.a = static_cast<uint32_t>(instruction_index(instr.a));
+                break;
+            default:
+                break;
+        }
+    }
+    for (auto &f: object.functions) {
+        function_entries.push_back(instruction_index(f.entry));
+    }
+    for (auto e: object.exceptions) {
+        e.start = static_cast<unsigned int>(instruction_index(e.start));
+        e.end = static_cast<unsigned int>(instruction_index(e.end));
+        e.handler = static_cast<unsigned int>(instruction_index(e.handler));
+        exceptions.push_back(e);
+    }
+}
+
+size_t Module::instruction_index(size_t offset) const
+{
+    auto i = std::lower_bound(offsets.begin(), offsets.end(), offset);
+    assert(i != offsets.end() && *i == offset);
+    return i - offsets.begin();
+}
+
 inline void dump_frames(Executor *exec)
 {
     if (false) {
         printf("Frames:\n");
-        for (auto &f: exec->frames) {
-            printf("  %p { nest=%u outer=%p locals=%zu opstack_depth=%zu }\n", &f, f.nesting_depth, f.outer, f.locals.size(), f.opstack_depth);
+        for (auto f = exec->frames.innermost(); f != nullptr; f = f->caller) {
+            printf("  %p { nest=%u outer=%p locals=%zu opstack_depth=%zu }\n", f, f->nesting_depth, f->outer, f->count, f->opstack_depth);
         }
     }
 }
 
 void Executor::exec_PUSHB()
 {
-    bool val = module->object.code[ip+1] != 0;
-    ip += 2;
+    bool val = module->code[ip].a != 0;
+    ip++;
     stack.push(Cell(val));
 }
 
 void Executor::exec_PUSHN()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
-    if (not module->number_table[val].first) {
-        module->number_table[val] = std::make_pair(true, number_from_string(module->object.strtable[val]));
-    }
-    stack.push(Cell(module->number_table[val].second));
+    stack.push(module->constants[val]);
 }
 
 void Executor::exec_PUSHS()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
-    stack.push(Cell(utf8string(module->object.strtable[val])));
+    stack.push(module->constants[val]);
 }
 
 void Executor::exec_PUSHY()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
-    stack.push(Cell(std::vector<unsigned char>(reinterpret_cast<const unsigned char *>(module->object.strtable[val].data()), reinterpret_cast<const unsigned char *>(module->object.strtable[val].data()) + module->object.strtable[val].size())));
+    stack.push(module->constants[val]);
 }
 
 void Executor::exec_PUSHPG()
 {
+    uint32_t addr = module->code[ip].a;
     ip++;
-    uint32_t addr = Bytecode::get_vint(module->object.code, ip);
     assert(addr < module->globals.size());
     stack.push(Cell(&module->globals.at(addr)));
 }
 
 void Executor::exec_PUSHPPG()
 {
+    uint32_t name = module->code[ip].a;
     ip++;
-    uint32_t name = Bytecode::get_vint(module->object.code, ip);
     stack.push(Cell(rtl_variable(module->object.strtable[name])));
 }
 
 void Executor::exec_PUSHPMG()
 {
+    uint32_t mod = module->code[ip].a;
+    uint32_t name = module->code[ip].b;
     ip++;
-    uint32_t mod = Bytecode::get_vint(module->object.code, ip);
-    uint32_t name = Bytecode::get_vint(module->object.code, ip);
     auto m = modules.find(module->object.strtable[mod]);
     if (m == modules.end()) {
         fprintf(stderr, "fatal: module not found: %s\n", module->object.strtable[mod].c_str());
@@ -704,29 +1683,29 @@ void Executor::exec_PUSHPMG()
 
 void Executor::exec_PUSHPL()
 {
+    uint32_t addr = module->code[ip].a;
     ip++;
-    uint32_t addr = Bytecode::get_vint(module->object.code, ip);
-    stack.push(Cell(&frames.back().locals.at(addr)));
+    stack.push(Cell(&frames.back().local(addr)));
 }
 
 void Executor::exec_PUSHPOL()
 {
+    uint32_t back = module->code[ip].a;
+    uint32_t addr = module->code[ip].b;
     ip++;
-    uint32_t back = Bytecode::get_vint(module->object.code, ip);
-    uint32_t addr = Bytecode::get_vint(module->object.code, ip);
     dump_frames(this);
     ActivationFrame *frame = &frames.back();
     while (back > 0) {
         frame = frame->outer;
         back--;
     }
-    stack.push(Cell(&frame->locals.at(addr)));
+    stack.push(Cell(&frame->local(addr)));
 }
 
 void Executor::exec_PUSHI()
 {
+    uint32_t x = module->code[ip].a;
     ip++;
-    uint32_t x = Bytecode::get_vint(module->object.code, ip);
     stack.push(Cell(number_from_uint32(x)));
 }
 
@@ -826,6 +1805,7 @@ void Executor::exec_STOREA()
 {
     ip++;
     Cell *addr = stack.top().address(); stack.pop();
+    write_barrier(&stack.top());
     *addr = stack.top(); stack.pop();
     addr->array();
 }
@@ -834,6 +1814,7 @@ void Executor::exec_STORED()
 {
     ip++;
     Cell *addr = stack.top().address(); stack.pop();
+    write_barrier(&stack.top());
     *addr = stack.top(); stack.pop();
     addr->dictionary();
 }
@@ -843,6 +1824,7 @@ void Executor::exec_STOREP()
     ip++;
     Cell *addr = stack.top().address(); stack.pop();
     Cell *val = stack.top().address(); stack.pop();
+    write_barrier(val);
     *addr = Cell(val);
 }
 
@@ -1107,8 +2089,8 @@ void Executor::exec_NEA()
 void Executor::exec_EQD()
 {
     ip++;
-    const std::map<utf8string, Cell> &b = stack.top().dictionary();
-    const std::map<utf8string, Cell> &a = stack.peek(1).dictionary();
+    const HashDictionary<Cell> &b = stack.top().dictionary();
+    const HashDictionary<Cell> &a = stack.peek(1).dictionary();
     bool v = a == b;
     stack.pop();
     stack.pop();
@@ -1118,8 +2100,8 @@ void Executor::exec_EQD()
 void Executor::exec_NED()
 {
     ip++;
-    const std::map<utf8string, Cell> &b = stack.top().dictionary();
-    const std::map<utf8string, Cell> &a = stack.peek(1).dictionary();
+    const HashDictionary<Cell> &b = stack.top().dictionary();
+    const HashDictionary<Cell> &a = stack.peek(1).dictionary();
     bool v = a != b;
     stack.pop();
     stack.pop();
@@ -1261,8 +2243,7 @@ void Executor::exec_INDEXDR()
     ip++;
     utf8string index = stack.top().string(); stack.pop();
     Cell *addr = stack.top().address(); stack.pop();
-    auto e = addr->dictionary().find(index);
-    if (e == addr->dictionary().end()) {
+    if (addr->dictionary().lookup(index) == nullptr) {
         raise_literal(utf8string("PANIC"), std::make_shared<ObjectString>("Dictionary key not found: " + index));
         return;
     }
@@ -1282,13 +2263,13 @@ void Executor::exec_INDEXDV()
 {
     ip++;
     utf8string index = stack.top().string(); stack.pop();
-    const std::map<utf8string, Cell> &dictionary = stack.top().dictionary();
-    auto e = dictionary.find(index);
-    if (e == dictionary.end()) {
+    const HashDictionary<Cell> &dictionary = stack.top().dictionary();
+    const Cell *e = dictionary.lookup(index);
+    if (e == nullptr) {
         raise_literal(utf8string("PANIC"), std::make_shared<ObjectString>("Dictionary key not found: " + index));
         return;
     }
-    Cell val = e->second;
+    Cell val = *e;
     stack.pop();
     stack.push(val);
 }
@@ -1309,7 +2290,7 @@ void Executor::exec_IND()
     ip++;
     auto &dictionary = stack.top().dictionary();
     utf8string key = stack.peek(1).string();
-    bool v = dictionary.find(key) != dictionary.end();
+    bool v = dictionary.lookup(key) != nullptr;
     stack.pop();
     stack.pop();
     stack.push(Cell(v));
@@ -1318,18 +2299,21 @@ void Executor::exec_IND()
 void Executor::exec_CALLP()
 {
     const size_t start_ip = ip;
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
-    std::string func = module->object.strtable.at(val);
+    const RtlFunction *fn = module->rtl_functions[val];
+    if (fn == nullptr) {
+        fprintf(stderr, "neon: function not found: %s\n", module->object.strtable.at(val).c_str());
+        abort();
+    }
+    if (fn == rtl_array_append || fn == rtl_array_extend) {
+        // These store their last argument into an INOUT array.
+        write_barrier(&stack.top());
+    }
     try {
         BidExceptionHandler handler(start_ip);
-        rtl_call(stack, func, module->rtl_call_tokens[val]);
-        std::string funcname = func;
-        auto sep = funcname.find('$');
-        if (sep != std::string::npos) {
-            funcname = funcname.substr(sep + 1);
-        }
-        handler.check_and_raise(funcname.c_str());
+        rtl_call(stack, *fn);
+        handler.check_and_raise(fn->display_name);
     } catch (RtlException &x) {
         ip = start_ip;
         raise(x);
@@ -1338,8 +2322,8 @@ void Executor::exec_CALLP()
 
 void Executor::exec_CALLF()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
     if (callstack.size() >= param_recursion_limit) {
         raise_literal(utf8string("PANIC"), std::make_shared<ObjectString>(utf8string("StackOverflow: Stack depth exceeds recursion limit of " + std::to_string(param_recursion_limit))));
         return;
@@ -1349,9 +2333,9 @@ void Executor::exec_CALLF()
 
 void Executor::exec_CALLMF()
 {
+    uint32_t mod = module->code[ip].a;
+    uint32_t func = module->code[ip].b;
     ip++;
-    uint32_t mod = Bytecode::get_vint(module->object.code, ip);
-    uint32_t func = Bytecode::get_vint(module->object.code, ip);
     if (callstack.size() >= param_recursion_limit) {
         raise_literal(utf8string("PANIC"), std::make_shared<ObjectString>(utf8string("StackOverflow: Stack depth exceeds recursion limit of " + std::to_string(param_recursion_limit))));
         return;
@@ -1397,15 +2381,15 @@ void Executor::exec_CALLI()
 
 void Executor::exec_JUMP()
 {
+    uint32_t target = module->code[ip].a;
     ip++;
-    uint32_t target = Bytecode::get_vint(module->object.code, ip);
     ip = target;
 }
 
 void Executor::exec_JF()
 {
+    uint32_t target = module->code[ip].a;
     ip++;
-    uint32_t target = Bytecode::get_vint(module->object.code, ip);
     bool a = stack.top().boolean(); stack.pop();
     if (not a) {
         ip = target;
@@ -1414,8 +2398,8 @@ void Executor::exec_JF()
 
 void Executor::exec_JT()
 {
+    uint32_t target = module->code[ip].a;
     ip++;
-    uint32_t target = Bytecode::get_vint(module->object.code, ip);
     bool a = stack.top().boolean(); stack.pop();
     if (a) {
         ip = target;
@@ -1454,8 +2438,8 @@ void Executor::exec_RET()
 
 void Executor::exec_CONSA()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
     std::vector<Cell> a;
     while (val > 0) {
         a.push_back(stack.top());
@@ -1467,8 +2451,8 @@ void Executor::exec_CONSA()
 
 void Executor::exec_CONSD()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
     Cell d;
     while (val > 0) {
         Cell value = stack.top(); stack.pop();
@@ -1481,24 +2465,19 @@ void Executor::exec_CONSD()
 
 void Executor::exec_EXCEPT()
 {
-    const size_t start_ip = ip;
-    ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
-    ip = start_ip;
+    uint32_t val = module->code[ip].a;
     std::shared_ptr<Object> info = stack.top().object(); stack.pop();
     raise_literal(utf8string(module->object.strtable[val]), info);
 }
 
 void Executor::exec_ALLOC()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
-    allocs.emplace_front(std::vector<Cell>(val), true);
-    Cell *cell = &allocs.front();
-    stack.push(Cell(cell));
+    stack.push(Cell(heap.allocate(val)));
     allocations++;
     if (param_garbage_collection_interval > 0 && allocations >= param_garbage_collection_interval) {
-        garbage_collect();
+        collect_garbage(false);
     }
 }
 
@@ -1510,8 +2489,8 @@ void Executor::exec_PUSHNIL()
 
 void Executor::exec_PUSHPEG()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
     if (external_globals == nullptr) {
         fprintf(stderr, "internal error: no external globals\n");
         exit(1);
@@ -1528,58 +2507,69 @@ void Executor::exec_PUSHPEG()
 
 void Executor::exec_JUMPTBL()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
     Number n = stack.top().number(); stack.pop();
     if (number_is_integer(n) && not number_is_negative(n)) {
         uint32_t i = number_to_uint32(n);
         if (i < val) {
-            ip += 6 * i;
+            ip += i;
         } else {
-            ip += 6 * val;
+            ip += val;
         }
     } else {
-        ip += 6 * val;
+        ip += val;
     }
 }
 
 void Executor::exec_CALLX()
 {
+    Module::ExtensionCall &call = module->extension_calls[module->code[ip].a];
     ip++;
-    uint32_t mod = Bytecode::get_vint(module->object.code, ip);
-    uint32_t name = Bytecode::get_vint(module->object.code, ip);
-    uint32_t out_param_count = Bytecode::get_vint(module->object.code, ip);
-    std::string modname = module->object.strtable[mod];
-    std::string modlib = just_path(module->object.source_path) + LIBRARY_NAME_PREFIX + "neon_" + modname;
-    if (g_ExtensionModules.find(modname) == g_ExtensionModules.end()) {
+    if (call.function == nullptr) {
+        if (g_ExtensionModules.find(call.modname) == g_ExtensionModules.end()) {
+            try {
+                void_function_t init = rtl_foreign_function(call.library, "Ne_INIT");
+                reinterpret_cast<int (*)(const Ne_MethodTable *)>(init)(&ExtensionMethodTable);
+            } catch (RtlException &e) {
+                fprintf(stderr, "%s\n", e.info.c_str());
+                exit(1);
+            }
+            g_ExtensionModules.insert(call.modname);
+        }
         try {
-            void_function_t init = rtl_foreign_function(modlib, "Ne_INIT");
-            reinterpret_cast<int (*)(const Ne_MethodTable *)>(init)(&ExtensionMethodTable);
-        } catch (RtlException &e) {
-            fprintf(stderr, "%s\n", e.info.c_str());
+            call.function = reinterpret_cast<Ne_ExtensionFunction>(rtl_foreign_function(call.library, "Ne_" + call.funcname));
+        } catch (RtlException &) {
+            fprintf(stderr, "neon_exec: function Ne_%s not found in %s\n", call.funcname.c_str(), call.library.c_str());
             exit(1);
         }
-        g_ExtensionModules.insert(modname);
     }
-    std::string funcname = module->object.strtable[name];
-    void_function_t p;
-    try {
-        p = rtl_foreign_function(modlib, "Ne_" + funcname);
-    } catch (RtlException &) {
-        fprintf(stderr, "neon_exec: function Ne_%s not found in %s\n", funcname.c_str(), modlib.c_str());
-        exit(1);
+    Cell fresh_out_params;
+    Cell *out_params = &call.out_params;
+    if (call.busy) {
+        fresh_out_params.array_for_write().resize(call.out_params.array().size());
+        out_params = &fresh_out_params;
     }
-    Ne_ExtensionFunction f = reinterpret_cast<Ne_ExtensionFunction>(p);
-    Cell out_params;
-    out_params.array_for_write().resize(out_param_count);
+    call.busy = true;
     Cell retval;
-    int r = f(reinterpret_cast<Ne_Cell *>(&retval), reinterpret_cast<Ne_ParameterList *>(&stack.top()), reinterpret_cast<Ne_ParameterList *>(&out_params));
+    int r = call.function(reinterpret_cast<Ne_Cell *>(&retval), reinterpret_cast<Ne_ParameterList *>(&stack.top()), reinterpret_cast<Ne_ParameterList *>(out_params));
+    if (out_params == &call.out_params) {
+        call.busy = false;
+    }
     stack.pop();
+    // Take the out parameters before looking at the result, so the cached
+    // cells are left empty whether or not the call succeeded.
+    std::vector<Cell> results;
+    results.reserve(out_params->array().size());
+    for (auto &c: out_params->array_for_write()) {
+        results.push_back(std::move(c));
+        c = Cell();
+    }
     switch (r) {
         case Ne_SUCCESS: {
             stack.push(retval);
-            for (auto &c: out_params.array()) {
-                stack.push(c);
+            for (auto &c: results) {
+                stack.push(std::move(c));
             }
             break;
         }
@@ -1590,7 +2580,7 @@ void Executor::exec_CALLX()
             break;
         }
         default:
-            fprintf(stderr, "neon: invalid return value %d from extension function %s.%s\n", r, modname.c_str(), funcname.c_str());
+            fprintf(stderr, "neon: invalid return value %d from extension function %s.%s\n", r, call.modname.c_str(), call.funcname.c_str());
             exit(1);
     }
 }
@@ -1606,8 +2596,8 @@ void Executor::exec_SWAP()
 
 void Executor::exec_DROPN()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
     std::vector<Cell> hold;
     for (uint32_t i = 0; i < val; i++) {
         hold.push_back(stack.top());
@@ -1621,16 +2611,16 @@ void Executor::exec_DROPN()
 
 void Executor::exec_PUSHFP()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
     std::vector<Cell> a = {Cell::makeOther(module), Cell(number_from_uint32(val))};
     stack.push(Cell(a));
 }
 
 void Executor::exec_CALLV()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
     if (callstack.size() >= param_recursion_limit) {
         raise_literal(utf8string("PANIC"), std::make_shared<ObjectString>(utf8string("StackOverflow: Stack depth exceeds recursion limit of " + std::to_string(param_recursion_limit))));
         return;
@@ -1646,8 +2636,8 @@ void Executor::exec_CALLV()
 
 void Executor::exec_PUSHCI()
 {
+    uint32_t val = module->code[ip].a;
     ip++;
-    uint32_t val = Bytecode::get_vint(module->object.code, ip);
     auto dot = module->object.strtable[val].find('.');
     if (dot == std::string::npos) {
         for (auto &c: module->object.classes) {
@@ -1682,9 +2672,9 @@ void Executor::exec_PUSHCI()
 
 void Executor::exec_PUSHMFP()
 {
+    uint32_t mod = module->code[ip].a;
+    uint32_t func = module->code[ip].b;
     ip++;
-    uint32_t mod = Bytecode::get_vint(module->object.code, ip);
-    uint32_t func = Bytecode::get_vint(module->object.code, ip);
     auto f = module->module_functions.find(std::make_pair(module->object.strtable[mod], module->object.strtable[func]));
     if (f != module->module_functions.end()) {
         stack.push(Cell(std::vector<Cell> {Cell::makeOther(f->second.first), Cell(number_from_uint32(f->second.second))}));
@@ -1724,7 +2714,7 @@ void Executor::invoke(Module *m, uint32_t index)
     frames.emplace_back(nest, outer, locals, stack.depth() - params);
     dump_frames(this);
     module = m;
-    ip = m->object.functions[index].entry;
+    ip = m->function_entries[index];
 }
 
 void Executor::raise_literal(const utf8string &exception, std::shared_ptr<Object> info)
@@ -1734,13 +2724,13 @@ void Executor::raise_literal(const utf8string &exception, std::shared_ptr<Object
     Cell exceptionvar;
     exceptionvar.array_index_for_write(0) = Cell(exception);
     exceptionvar.array_index_for_write(1) = Cell(info);
-    exceptionvar.array_index_for_write(2) = Cell(number_from_uint32(static_cast<uint32_t>(ip)));
+    exceptionvar.array_index_for_write(2) = Cell(number_from_uint32(static_cast<uint32_t>(module->offsets[ip])));
 
     auto tmodule = module;
     auto tip = ip;
     size_t sp = callstack.size();
     for (;;) {
-        for (auto e = tmodule->object.exceptions.begin(); e != tmodule->object.exceptions.end(); ++e) {
+        for (auto e = tmodule->exceptions.begin(); e != tmodule->exceptions.end(); ++e) {
             if (tip >= e->start && tip < e->end) {
                 const std::string handler = tmodule->object.strtable[e->excid];
                 if (exception.str() == handler
@@ -1770,10 +2760,10 @@ void Executor::raise_literal(const utf8string &exception, std::shared_ptr<Object
     utf8string detail;
     info->getString(detail);
     fprintf(stderr, "Unhandled exception %s (%s)\n", exception.c_str(), detail.c_str());
-    while (ip < module->object.code.size()) {
+    while (ip < module->code.size()) {
         if (module->debug != nullptr) {
             auto line = module->debug->line_numbers.end();
-            auto p = ip;
+            auto p = module->offsets[ip];
             for (;;) {
                 line = module->debug->line_numbers.find(p);
                 if (line != module->debug->line_numbers.end()) {
@@ -1786,13 +2776,13 @@ void Executor::raise_literal(const utf8string &exception, std::shared_ptr<Object
                 p--;
             }
             if (line != module->debug->line_numbers.end()) {
-                fprintf(stderr, "  Stack frame #%lu: file %s line %d address %lu\n", static_cast<unsigned long>(callstack.size()), module->debug->source_path.c_str(), line->second, static_cast<unsigned long>(ip));
+                fprintf(stderr, "  Stack frame #%lu: file %s line %d address %lu\n", static_cast<unsigned long>(callstack.size()), module->debug->source_path.c_str(), line->second, static_cast<unsigned long>(module->offsets[ip]));
                 fprintf(stderr, "    %s\n", module->debug->source_lines.at(line->second).c_str());
             } else {
-                fprintf(stderr, "  Stack frame #%lu: file %s address %lu (line number not found)\n", static_cast<unsigned long>(callstack.size()), module->debug->source_path.c_str(), static_cast<unsigned long>(ip));
+                fprintf(stderr, "  Stack frame #%lu: file %s address %lu (line number not found)\n", static_cast<unsigned long>(callstack.size()), module->debug->source_path.c_str(), static_cast<unsigned long>(module->offsets[ip]));
             }
         } else {
-            fprintf(stderr, "  Stack frame #%lu: module %s address %lu (no debug info available)\n", static_cast<unsigned long>(callstack.size()), module->name.c_str(), static_cast<unsigned long>(ip));
+            fprintf(stderr, "  Stack frame #%lu: module %s address %lu (no debug info available)\n", static_cast<unsigned long>(callstack.size()), module->name.c_str(), static_cast<unsigned long>(module->offsets[ip]));
         }
         if (callstack.empty()) {
             break;
@@ -1832,85 +2822,85 @@ void Executor::interrupt()
     interrupted = true;
 }
 
-static void mark(Cell *c)
+void Executor::garbage_collect()
 {
-    std::vector<Cell *> todo;
-    todo.push_back(c);
-    while (not todo.empty()) {
-        c = todo.back();
-        todo.pop_back();
-        if (c == nullptr || (c->gc.alloced && c->gc.marked)) {
-            continue;
-        }
-        c->gc.marked = true;
-        switch (c->get_type()) {
-            case Cell::Type::None:
-            case Cell::Type::Boolean:
-            case Cell::Type::Number:
-            case Cell::Type::String:
-            case Cell::Type::Bytes:
-            case Cell::Type::Object:
-                // nothing
-                break;
-            case Cell::Type::Address:
-                todo.push_back(c->address());
-                break;
-            case Cell::Type::Array:
-                for (auto &x: c->array()) {
-                    todo.push_back(const_cast<Cell *>(&x));
-                }
-                break;
-            case Cell::Type::Dictionary:
-                for (auto &x: c->dictionary()) {
-                    todo.push_back(const_cast<Cell *>(&x.second));
-                }
-                break;
-            case Cell::Type::Other:
-                break;
-        }
+    // Records marked by a collection already in progress might have become
+    // unreachable since, so finish that one and then start a fresh one.
+    if (heap.is_marking()) {
+        collect_garbage(true);
     }
+    collect_garbage(true);
 }
 
-void Executor::garbage_collect()
+// Do some garbage collection work. With no pause budget, or when finish
+// is set, this runs a whole collection. Otherwise it starts or continues an
+// incremental collection, and returns when the budget has been used up.
+void Executor::collect_garbage(bool finish)
 {
-    // Clear marked bits.
-    for (Cell &c: allocs) {
-        assert(c.gc.alloced);
-        c.gc.marked = false;
+    auto start = std::chrono::steady_clock::now();
+
+    if (not heap.is_marking()) {
+        heap.start_marking();
+        mark_roots();
+    }
+    bool done = true;
+    if (not finish && param_garbage_collection_pause_budget > 0) {
+        done = heap.mark_step(start + std::chrono::microseconds(param_garbage_collection_pause_budget));
+    }
+    if (done) {
+        // The roots are not covered by the write barrier, so they need
+        // to be scanned again before marking can finish.
+        mark_roots();
+        heap.finish_marking();
+        if (finish || heap.major_due()) {
+            heap.sweep_all();
+        } else {
+            heap.sweep_nursery();
+        }
+        allocations = 0;
+        gc_statistics.count++;
     }
 
-    // Mark reachable objects.
+    uint64_t pause = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    gc_statistics.pause_total += pause;
+    gc_statistics.pause_maximum = std::max(gc_statistics.pause_maximum, pause);
+}
+
+void Executor::mark_roots()
+{
     for (auto &m: modules) {
         for (auto &g: m.second->globals) {
-            mark(&g);
+            heap.shade(&g);
         }
     }
-    for (auto &f: frames) {
-        for (auto &v: f.locals) {
-            mark(&v);
+    for (auto f = frames.innermost(); f != nullptr; f = f->caller) {
+        for (size_t i = 0; i < f->count; i++) {
+            heap.shade(&f->locals[i]);
         }
     }
     for (size_t i = 0; i < stack.depth(); i++) {
-        mark(&stack.peek(i));
+        heap.shade(&stack.peek(i));
     }
+}
 
-    // Sweep unreachable objects.
-    for (auto c = allocs.begin(); c != allocs.end(); ) {
-        if (not c->gc.marked) {
-            auto tmp = c;
-            ++c;
-            allocs.erase(tmp);
-        } else {
-            ++c;
-        }
-    }
+size_t Executor::get_allocated_object_count()
+{
+    return heap.count();
+}
 
-    allocations = 0;
+size_t Executor::get_garbage_collection_count()
+{
+    return gc_statistics.count;
 }
 
-size_t Executor::get_allocated_object_count()
+uint64_t Executor::get_garbage_collection_pause_maximum()
+{
+    return gc_statistics.pause_maximum;
+}
+
+uint64_t Executor::get_garbage_collection_pause_total()
 {
-    return allocs.size();
+    return gc_statistics.pause_total;
 }
 
 bool Executor::is_module_imported(const std::string &mod)
@@ -1928,6 +2918,11 @@ void Executor::set_garbage_collection_interval(size_t count)
     param_garbage_collection_interval = count;
 }
 
+void Executor::set_garbage_collection_pause_budget(uint64_t microseconds)
+{
+    param_garbage_collection_pause_budget = microseconds;
+}
+
 void Executor::set_recursion_limit(size_t depth)
 {
     param_recursion_limit = depth;
@@ -1935,7 +2930,7 @@ void Executor::set_recursion_limit(size_t depth)
 
 int Executor::exec()
 {
-    ip = module->object.code.size();
+    ip = module->code.size();
     invoke(module, 0);
 
     // This sets up the call stack in such a way as to initialize
@@ -1949,17 +2944,25 @@ int Executor::exec()
     if (r == 0) {
         assert(stack.empty());
     }
+    if (profiler != nullptr) {
+        profiler->report();
+    }
     return r;
 }
 
 int Executor::exec_loop(size_t min_callstack_depth)
 {
-    while (callstack.size() > min_callstack_depth && ip < module->object.code.size() && exit_code == 0) {
+#ifdef NEON_THREADED_DISPATCH
+    if (options->enable_threaded_dispatch && not options->enable_trace && profiler == nullptr && debug_server == nullptr) {
+        return exec_loop_threaded(min_callstack_depth);
+    }
+#endif
+    while (callstack.size() > min_callstack_depth && ip < module->code.size() && exit_code == 0) {
         if (options->enable_trace) {
-            auto i = ip;
-            std::cerr << "mod " << module->name << " ip " << ip << " (" << stack.depth() << ") " << disassemble_instruction(module->object, i) << "\n";
+            auto i = module->offsets[ip];
+            std::cerr << "mod " << module->name << " ip " << i << " (" << stack.depth() << ") " << disassemble_instruction(module->object, i) << "\n";
             if (module->debug != nullptr) {
-                auto sd = module->debug->stack_depth.find(ip);
+                auto sd = module->debug->stack_depth.find(module->offsets[ip]);
                 if (sd != module->debug->stack_depth.end()) {
                     int expected_depth = static_cast<int>(frames.empty() ? 0 : frames.back().opstack_depth) + sd->second;
                     if (expected_depth != static_cast<int>(stack.depth())) {
@@ -1969,12 +2972,15 @@ int Executor::exec_loop(size_t min_callstack_depth)
                 }
             }
         }
+        if (profiler != nullptr) {
+            profiler->tick(module, ip, callstack);
+        }
         if (debug_server != nullptr) {
             switch (debugger_state) {
                 case DebuggerState::STOPPED:
                     break;
                 case DebuggerState::RUN:
-                    if (debugger_breakpoints.find(ip) != debugger_breakpoints.end()) {
+                    if (debugger_breakpoints.find(module->offsets[ip]) != debugger_breakpoints.end()) {
                         debugger_state = DebuggerState::STOPPED;
                     }
                     break;
@@ -1982,7 +2988,7 @@ int Executor::exec_loop(size_t min_callstack_depth)
                     debugger_state = DebuggerState::STOPPED;
                     break;
                 case DebuggerState::STEP_SOURCE:
-                    if (callstack.size() <= debugger_step_source_depth && module->debug != nullptr && module->debug->line_numbers.find(ip) != module->debug->line_numbers.end()) {
+                    if (callstack.size() <= debugger_step_source_depth && module->debug != nullptr && module->debug->line_numbers.find(module->offsets[ip]) != module->debug->line_numbers.end()) {
                         debugger_state = DebuggerState::STOPPED;
                     }
                     break;
@@ -1997,7 +3003,7 @@ int Executor::exec_loop(size_t min_callstack_depth)
                 return 1;
             }
         }
-        switch (static_cast<Opcode>(module->object.code[ip])) {
+        switch (module->code[ip].opcode) {
             case Opcode::PUSHB:   exec_PUSHB(); break;
             case Opcode::PUSHN:   exec_PUSHN(); break;
             case Opcode::PUSHS:   exec_PUSHS(); break;
@@ -2095,7 +3101,7 @@ int Executor::exec_loop(size_t min_callstack_depth)
             case Opcode::PUSHCI:  exec_PUSHCI(); break;
             case Opcode::PUSHMFP: exec_PUSHMFP(); break;
             default:
-                fprintf(stderr, "exec: Unexpected opcode: %d\n", module->object.code[ip]);
+                fprintf(stderr, "exec: Unexpected opcode: %d\n", static_cast<int>(module->code[ip].opcode));
                 abort();
         }
         if (interrupted) {
@@ -2106,6 +3112,233 @@ int Executor::exec_loop(size_t min_callstack_depth)
     return exit_code;
 }
 
+#ifdef NEON_THREADED_DISPATCH
+// This is the same as exec_loop() above, except that it uses computed
+// goto to jump directly from one instruction handler to the next instead
+// of going back through a single switch statement. This gives the branch
+// predictor a separate indirect jump at the end of each handler to work
+// with. The trace, profiler, and debugger checks are not done here;
+// exec_loop() only uses this when those features are turned off.
+int Executor::exec_loop_threaded(size_t min_callstack_depth)
+{
+    // This table must be in the same order as enum class Opcode.
+    static void *const dispatch_table[] = {
+        &&op_PUSHB,
+        &&op_PUSHN,
+        &&op_PUSHS,
+        &&op_PUSHY,
+        &&op_PUSHPG,
+        &&op_PUSHPPG,
+        &&op_PUSHPMG,
+        &&op_PUSHPL,
+        &&op_PUSHPOL,
+        &&op_PUSHI,
+        &&op_LOADB,
+        &&op_LOADN,
+        &&op_LOADS,
+        &&op_LOADY,
+        &&op_LOADA,
+        &&op_LOADD,
+        &&op_LOADP,
+        &&op_LOADJ,
+        &&op_STOREB,
+        &&op_STOREN,
+        &&op_STORES,
+        &&op_STOREY,
+        &&op_STOREA,
+        &&op_STORED,
+        &&op_STOREP,
+        &&op_STOREJ,
+        &&op_NEGN,
+        &&op_ADDN,
+        &&op_SUBN,
+        &&op_MULN,
+        &&op_DIVN,
+        &&op_MODN,
+        &&op_EXPN,
+        &&op_EQB,
+        &&op_NEB,
+        &&op_EQN,
+        &&op_NEN,
+        &&op_LTN,
+        &&op_GTN,
+        &&op_LEN,
+        &&op_GEN,
+        &&op_EQS,
+        &&op_NES,
+        &&op_LTS,
+        &&op_GTS,
+        &&op_LES,
+        &&op_GES,
+        &&op_EQY,
+        &&op_NEY,
+        &&op_LTY,
+        &&op_GTY,
+        &&op_LEY,
+        &&op_GEY,
+        &&op_EQA,
+        &&op_NEA,
+        &&op_EQD,
+        &&op_NED,
+        &&op_EQP,
+        &&op_NEP,
+        &&op_ANDB,
+        &&op_ORB,
+        &&op_NOTB,
+        &&op_INDEXAR,
+        &&op_INDEXAW,
+        &&op_INDEXAV,
+        &&op_INDEXAN,
+        &&op_INDEXDR,
+        &&op_INDEXDW,
+        &&op_INDEXDV,
+        &&op_INA,
+        &&op_IND,
+        &&op_CALLP,
+        &&op_CALLF,
+        &&op_CALLMF,
+        &&op_CALLI,
+        &&op_JUMP,
+        &&op_JF,
+        &&op_JT,
+        &&op_DUP,
+        &&op_DUPX1,
+        &&op_DROP,
+        &&op_RET,
+        &&op_CONSA,
+        &&op_CONSD,
+        &&op_EXCEPT,
+        &&op_ALLOC,
+        &&op_PUSHNIL,
+        &&op_PUSHPEG,
+        &&op_JUMPTBL,
+        &&op_CALLX,
+        &&op_SWAP,
+        &&op_DROPN,
+        &&op_PUSHFP,
+        &&op_CALLV,
+        &&op_PUSHCI,
+        &&op_PUSHMFP,
+    };
+    static_assert(sizeof(dispatch_table) / sizeof(dispatch_table[0]) == static_cast<size_t>(Opcode::PUSHMFP) + 1, "dispatch_table does not match Opcode");
+
+#define NEXT() \
+    if (callstack.size() <= min_callstack_depth || ip >= module->code.size() || exit_code != 0) { \
+        return exit_code; \
+    } \
+    goto *dispatch_table[static_cast<size_t>(module->code[ip].opcode)]
+
+#define DISPATCH() \
+    if (interrupted) { \
+        interrupted = false; \
+        raise_literal(utf8string(rtl::ne_global::Exception_InterruptedException.name), std::make_shared<ObjectString>(utf8string("Ctrl+C Pressed"))); \
+    } \
+    NEXT()
+
+    NEXT();
+
+    op_PUSHB:    exec_PUSHB(); DISPATCH();
+    op_PUSHN:    exec_PUSHN(); DISPATCH();
+    op_PUSHS:    exec_PUSHS(); DISPATCH();
+    op_PUSHY:    exec_PUSHY(); DISPATCH();
+    op_PUSHPG:   exec_PUSHPG(); DISPATCH();
+    op_PUSHPPG:  exec_PUSHPPG(); DISPATCH();
+    op_PUSHPMG:  exec_PUSHPMG(); DISPATCH();
+    op_PUSHPL:   exec_PUSHPL(); DISPATCH();
+    op_PUSHPOL:  exec_PUSHPOL(); DISPATCH();
+    op_PUSHI:    exec_PUSHI(); DISPATCH();
+    op_LOADB:    exec_LOADB(); DISPATCH();
+    op_LOADN:    exec_LOADN(); DISPATCH();
+    op_LOADS:    exec_LOADS(); DISPATCH();
+    op_LOADY:    exec_LOADY(); DISPATCH();
+    op_LOADA:    exec_LOADA(); DISPATCH();
+    op_LOADD:    exec_LOADD(); DISPATCH();
+    op_LOADP:    exec_LOADP(); DISPATCH();
+    op_LOADJ:    exec_LOADJ(); DISPATCH();
+    op_STOREB:   exec_STOREB(); DISPATCH();
+    op_STOREN:   exec_STOREN(); DISPATCH();
+    op_STORES:   exec_STORES(); DISPATCH();
+    op_STOREY:   exec_STOREY(); DISPATCH();
+    op_STOREA:   exec_STOREA(); DISPATCH();
+    op_STORED:   exec_STORED(); DISPATCH();
+    op_STOREP:   exec_STOREP(); DISPATCH();
+    op_STOREJ:   exec_STOREJ(); DISPATCH();
+    op_NEGN:     exec_NEGN(); DISPATCH();
+    op_ADDN:     exec_ADDN(); DISPATCH();
+    op_SUBN:     exec_SUBN(); DISPATCH();
+    op_MULN:     exec_MULN(); DISPATCH();
+    op_DIVN:     exec_DIVN(); DISPATCH();
+    op_MODN:     exec_MODN(); DISPATCH();
+    op_EXPN:     exec_EXPN(); DISPATCH();
+    op_EQB:      exec_EQB(); DISPATCH();
+    op_NEB:      exec_NEB(); DISPATCH();
+    op_EQN:      exec_EQN(); DISPATCH();
+    op_NEN:      exec_NEN(); DISPATCH();
+    op_LTN:      exec_LTN(); DISPATCH();
+    op_GTN:      exec_GTN(); DISPATCH();
+    op_LEN:      exec_LEN(); DISPATCH();
+    op_GEN:      exec_GEN(); DISPATCH();
+    op_EQS:      exec_EQS(); DISPATCH();
+    op_NES:      exec_NES(); DISPATCH();
+    op_LTS:      exec_LTS(); DISPATCH();
+    op_GTS:      exec_GTS(); DISPATCH();
+    op_LES:      exec_LES(); DISPATCH();
+    op_GES:      exec_GES(); DISPATCH();
+    op_EQY:      exec_EQY(); DISPATCH();
+    op_NEY:      exec_NEY(); DISPATCH();
+    op_LTY:      exec_LTY(); DISPATCH();
+    op_GTY:      exec_GTY(); DISPATCH();
+    op_LEY:      exec_LEY(); DISPATCH();
+    op_GEY:      exec_GEY(); DISPATCH();
+    op_EQA:      exec_EQA(); DISPATCH();
+    op_NEA:      exec_NEA(); DISPATCH();
+    op_EQD:      exec_EQD(); DISPATCH();
+    op_NED:      exec_NED(); DISPATCH();
+    op_EQP:      exec_EQP(); DISPATCH();
+    op_NEP:      exec_NEP(); DISPATCH();
+    op_ANDB:     exec_ANDB(); DISPATCH();
+    op_ORB:      exec_ORB(); DISPATCH();
+    op_NOTB:     exec_NOTB(); DISPATCH();
+    op_INDEXAR:  exec_INDEXAR(); DISPATCH();
+    op_INDEXAW:  exec_INDEXAW(); DISPATCH();
+    op_INDEXAV:  exec_INDEXAV(); DISPATCH();
+    op_INDEXAN:  exec_INDEXAN(); DISPATCH();
+    op_INDEXDR:  exec_INDEXDR(); DISPATCH();
+    op_INDEXDW:  exec_INDEXDW(); DISPATCH();
+    op_INDEXDV:  exec_INDEXDV(); DISPATCH();
+    op_INA:      exec_INA(); DISPATCH();
+    op_IND:      exec_IND(); DISPATCH();
+    op_CALLP:    exec_CALLP(); DISPATCH();
+    op_CALLF:    exec_CALLF(); DISPATCH();
+    op_CALLMF:   exec_CALLMF(); DISPATCH();
+    op_CALLI:    exec_CALLI(); DISPATCH();
+    op_JUMP:     exec_JUMP(); DISPATCH();
+    op_JF:       exec_JF(); DISPATCH();
+    op_JT:       exec_JT(); DISPATCH();
+    op_DUP:      exec_DUP(); DISPATCH();
+    op_DUPX1:    exec_DUPX1(); DISPATCH();
+    op_DROP:     exec_DROP(); DISPATCH();
+    op_RET:      exec_RET(); DISPATCH();
+    op_CONSA:    exec_CONSA(); DISPATCH();
+    op_CONSD:    exec_CONSD(); DISPATCH();
+    op_EXCEPT:   exec_EXCEPT(); DISPATCH();
+    op_ALLOC:    exec_ALLOC(); DISPATCH();
+    op_PUSHNIL:  exec_PUSHNIL(); DISPATCH();
+    op_PUSHPEG:  exec_PUSHPEG(); DISPATCH();
+    op_JUMPTBL:  exec_JUMPTBL(); DISPATCH();
+    op_CALLX:    exec_CALLX(); DISPATCH();
+    op_SWAP:     exec_SWAP(); DISPATCH();
+    op_DROPN:    exec_DROPN(); DISPATCH();
+    op_PUSHFP:   exec_PUSHFP(); DISPATCH();
+    op_CALLV:    exec_CALLV(); DISPATCH();
+    op_PUSHCI:   exec_PUSHCI(); DISPATCH();
+    op_PUSHMFP:  exec_PUSHMFP(); DISPATCH();
+
+#undef DISPATCH
+#undef NEXT
+}
+#endif
+
 namespace minijson {
 
 template <> struct default_value_writer<Number> {
@@ -2191,18 +3424,18 @@ void Executor::handle_GET(const std::string &path, HttpResponse &response)
         for (auto i = callstack.rbegin(); i != callstack.rend(); ++i) {
             auto w = writer.nested_object();
             w.write("module", i->first->name);
-            w.write("ip", i->second);
+            w.write("ip", i->first->offsets[i->second]);
             w.close();
         }
         writer.close();
     } else if (path == "/frames") {
         response.code = 200;
         minijson::array_writer writer(r, config);
-        for (auto i = frames.rbegin(); i != frames.rend(); ++i) {
+        for (auto f = frames.innermost(); f != nullptr; f = f->caller) {
             auto wf = writer.nested_object();
             auto wl = wf.nested_array("locals");
-            for (auto &local: i->locals) {
-                wl.write(local);
+            for (size_t i = 0; i < f->count; i++) {
+                wl.write(f->locals[i]);
             }
             wl.close();
             wf.close();
@@ -2243,7 +3476,7 @@ void Executor::handle_GET(const std::string &path, HttpResponse &response)
         minijson::object_writer writer(r, config);
         writer.write("state", DebuggerStateName[static_cast<int>(debugger_state)]);
         writer.write("module", module->name);
-        writer.write("ip", ip);
+        writer.write("ip", module->offsets[ip]);
         writer.write("log_messages", debugger_log.size());
         writer.close();
     }
@@ -2333,6 +3566,21 @@ size_t executor_get_allocated_object_count()
     return g_executor->get_allocated_object_count();
 }
 
+size_t executor_get_garbage_collection_count()
+{
+    return g_executor->get_garbage_collection_count();
+}
+
+uint64_t executor_get_garbage_collection_pause_maximum()
+{
+    return g_executor->get_garbage_collection_pause_maximum();
+}
+
+uint64_t executor_get_garbage_collection_pause_total()
+{
+    return g_executor->get_garbage_collection_pause_total();
+}
+
 bool executor_is_module_imported(const std::string &module)
 {
     return g_executor->is_module_imported(module);
@@ -2348,6 +3596,11 @@ void executor_set_garbage_collection_interval(size_t count)
     g_executor->set_garbage_collection_interval(count);
 }
 
+void executor_set_garbage_collection_pause_budget(uint64_t microseconds)
+{
+    g_executor->set_garbage_collection_pause_budget(microseconds);
+}
+
 void executor_set_recursion_limit(size_t depth)
 {
     g_executor->set_recursion_limit(depth);
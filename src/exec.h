@@ -2,6 +2,7 @@
 #define EXEC_H
 
 #include <map>
+#include <stdint.h>
 #include <string>
 #include <vector>
 
@@ -21,15 +22,23 @@ bool executor_assertions_enabled();
 bool executor_debug_enabled();
 void executor_garbage_collect();
 size_t executor_get_allocated_object_count();
+size_t executor_get_garbage_collection_count();
+uint64_t executor_get_garbage_collection_pause_maximum();
+uint64_t executor_get_garbage_collection_pause_total();
 bool executor_is_module_imported(const std::string &module);
 bool executor_module_is_main();
 void executor_set_garbage_collection_interval(size_t count);
+void executor_set_garbage_collection_pause_budget(uint64_t microseconds);
 void executor_set_recursion_limit(size_t depth);
 
 struct ExecOptions {
     bool enable_assert = false;
     bool enable_debug = false;
     bool enable_trace = false;
+    bool enable_threaded_dispatch = true;
+    bool enable_profile = false;
+    // File to write collapsed call stacks to when profiling, if not empty.
+    std::string profile_stacks_path;
 };
 
 int exec(const std::string &source_path, const std::vector<unsigned char> &obj, const DebugInfo *debug, ICompilerSupport *support, const ExecOptions *options, unsigned short debug_port, int argc, char *argv[], std::map<std::string, Cell *> *external_globals = nullptr);
@@ -0,0 +1,267 @@
+#ifndef HASHDICTIONARY_H
+#define HASHDICTIONARY_H
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "utf8string.h"
+
+// A dictionary keyed by strings, stored in an open addressing hash table
+// with linear probing. Each entry is allocated separately, so references to
+// values stay valid until that entry is erased (as with std::map). The hash
+// of each key is kept with its entry, so growing the table never hashes a
+// key again and most failed comparisons during a probe don't have to look
+// at the key at all.
+//
+// Neon requires dictionaries to iterate in key order, so iteration goes
+// through an index of the entries sorted by key. The index is built the
+// first time it's needed and kept until a key is added or removed, except
+// that adding keys in increasing order keeps the index up to date.
+
+template <typename V> class HashDictionary {
+public:
+    typedef std::pair<const utf8string, V> value_type;
+
+private:
+    struct Node {
+        Node(size_t hash, const utf8string &key, const V &value): hash(hash), value(key, value) {}
+        Node(const Node &) = delete;
+        Node &operator=(const Node &) = delete;
+        const size_t hash;
+        value_type value;
+    };
+
+public:
+    template <typename T> class basic_iterator {
+    public:
+        explicit basic_iterator(typename std::vector<Node *>::const_iterator i): i(i) {}
+        T &operator*() const { return (*i)->value; }
+        T *operator->() const { return &(*i)->value; }
+        basic_iterator &operator++() { ++i; return *this; }
+        bool operator==(const basic_iterator &rhs) const { return i == rhs.i; }
+        bool operator!=(const basic_iterator &rhs) const { return i != rhs.i; }
+    private:
+        typename std::vector<Node *>::const_iterator i;
+    };
+    typedef basic_iterator<value_type> iterator;
+    typedef basic_iterator<const value_type> const_iterator;
+
+    // Iterates over the slots of the hash table, in no particular order.
+    template <typename T> class basic_unordered_iterator {
+    public:
+        basic_unordered_iterator(typename std::vector<Node *>::const_iterator i, typename std::vector<Node *>::const_iterator e): i(i), e(e) { skip(); }
+        T &operator*() const { return (*i)->value; }
+        T *operator->() const { return &(*i)->value; }
+        basic_unordered_iterator &operator++() { ++i; skip(); return *this; }
+        bool operator==(const basic_unordered_iterator &rhs) const { return i == rhs.i; }
+        bool operator!=(const basic_unordered_iterator &rhs) const { return i != rhs.i; }
+    private:
+        typename std::vector<Node *>::const_iterator i;
+        typename std::vector<Node *>::const_iterator e;
+        void skip() { while (i != e && *i == nullptr) ++i; }
+    };
+    typedef basic_unordered_iterator<value_type> unordered_iterator;
+    typedef basic_unordered_iterator<const value_type> const_unordered_iterator;
+
+    template <typename I> class range {
+    public:
+        range(I b, I e): b(b), e(e) {}
+        I begin() const { return b; }
+        I end() const { return e; }
+    private:
+        I b;
+        I e;
+    };
+
+    HashDictionary(): slots(), count(0), sorted(), sorted_valid(true) {}
+    HashDictionary(const HashDictionary &rhs): slots(rhs.slots.size()), count(rhs.count), sorted(), sorted_valid(false) {
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (rhs.slots[i] != nullptr) {
+                slots[i] = new Node(rhs.slots[i]->hash, rhs.slots[i]->value.first, rhs.slots[i]->value.second);
+            }
+        }
+    }
+    HashDictionary &operator=(const HashDictionary &rhs) {
+        if (&rhs != this) {
+            HashDictionary tmp(rhs);
+            std::swap(slots, tmp.slots);
+            std::swap(count, tmp.count);
+            std::swap(sorted, tmp.sorted);
+            std::swap(sorted_valid, tmp.sorted_valid);
+        }
+        return *this;
+    }
+    ~HashDictionary() {
+        for (auto n: slots) {
+            delete n;
+        }
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Return a pointer to the value for the given key, or nullptr if the
+    // key is not present.
+    V *lookup(const utf8string &key) {
+        if (count == 0) {
+            return nullptr;
+        }
+        Node *n = slots[find_slot(key, hash_key(key))];
+        return n != nullptr ? &n->value.second : nullptr;
+    }
+    const V *lookup(const utf8string &key) const {
+        return const_cast<HashDictionary *>(this)->lookup(key);
+    }
+
+    V &at(const utf8string &key) {
+        V *r = lookup(key);
+        if (r == nullptr) {
+            throw std::out_of_range("HashDictionary::at");
+        }
+        return *r;
+    }
+
+    V &operator[](const utf8string &key) {
+        if (2 * (count + 1) > slots.size()) {
+            grow();
+        }
+        size_t hash = hash_key(key);
+        size_t i = find_slot(key, hash);
+        if (slots[i] == nullptr) {
+            slots[i] = new Node(hash, key, V());
+            count++;
+            if (sorted_valid) {
+                if (sorted.empty() || sorted.back()->value.first < key) {
+                    sorted.push_back(slots[i]);
+                } else {
+                    sorted_valid = false;
+                    sorted.clear();
+                }
+            }
+        }
+        return slots[i]->value.second;
+    }
+
+    bool erase(const utf8string &key) {
+        if (count == 0) {
+            return false;
+        }
+        size_t mask = slots.size() - 1;
+        size_t i = find_slot(key, hash_key(key));
+        Node *n = slots[i];
+        if (n == nullptr) {
+            return false;
+        }
+        sorted_valid = false;
+        sorted.clear();
+        delete n;
+        slots[i] = nullptr;
+        count--;
+        // Move later entries in the same run back into the hole, so that
+        // a probe never stops early at an empty slot.
+        size_t j = i;
+        for (;;) {
+            j = (j + 1) & mask;
+            if (slots[j] == nullptr) {
+                break;
+            }
+            size_t k = slots[j]->hash & mask;
+            if (i <= j ? (k <= i || k > j) : (k <= i && k > j)) {
+                slots[i] = slots[j];
+                slots[j] = nullptr;
+                i = j;
+            }
+        }
+        return true;
+    }
+
+    iterator begin() { return iterator(sorted_nodes().begin()); }
+    iterator end() { return iterator(sorted_nodes().end()); }
+    const_iterator begin() const { return const_iterator(sorted_nodes().begin()); }
+    const_iterator end() const { return const_iterator(sorted_nodes().end()); }
+
+    // For callers that visit every entry and don't care about the order,
+    // such as the garbage collector. This never builds the sorted index.
+    range<unordered_iterator> unordered() { return range<unordered_iterator>(unordered_iterator(slots.begin(), slots.end()), unordered_iterator(slots.end(), slots.end())); }
+    range<const_unordered_iterator> unordered() const { return range<const_unordered_iterator>(const_unordered_iterator(slots.begin(), slots.end()), const_unordered_iterator(slots.end(), slots.end())); }
+
+    // Return the entry at position n in key order.
+    const value_type &nth(size_t n) const { return sorted_nodes().at(n)->value; }
+
+    bool operator==(const HashDictionary &rhs) const {
+        if (count != rhs.count) {
+            return false;
+        }
+        for (auto n: slots) {
+            if (n != nullptr) {
+                const V *v = rhs.lookup(n->value.first);
+                if (v == nullptr || not (*v == n->value.second)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    bool operator!=(const HashDictionary &rhs) const { return not operator==(rhs); }
+
+private:
+    // Always a power of two in size, and never more than half full.
+    std::vector<Node *> slots;
+    size_t count;
+    mutable std::vector<Node *> sorted;
+    mutable bool sorted_valid;
+
+    static size_t hash_key(const utf8string &key) {
+        return std::hash<std::string>()(key.str());
+    }
+
+    static bool less(const Node *a, const Node *b) {
+        return a->value.first < b->value.first;
+    }
+
+    // Return the slot that holds the given key, or the empty slot where
+    // it would go.
+    size_t find_slot(const utf8string &key, size_t hash) const {
+        size_t mask = slots.size() - 1;
+        size_t i = hash & mask;
+        while (slots[i] != nullptr && (slots[i]->hash != hash || slots[i]->value.first != key)) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void grow() {
+        std::vector<Node *> old(slots.empty() ? 8 : 2 * slots.size());
+        std::swap(slots, old);
+        size_t mask = slots.size() - 1;
+        for (auto n: old) {
+            if (n != nullptr) {
+                size_t i = n->hash & mask;
+                while (slots[i] != nullptr) {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = n;
+            }
+        }
+    }
+
+    const std::vector<Node *> &sorted_nodes() const {
+        if (not sorted_valid) {
+            sorted.clear();
+            sorted.reserve(count);
+            for (auto n: slots) {
+                if (n != nullptr) {
+                    sorted.push_back(n);
+                }
+            }
+            std::sort(sorted.begin(), sorted.end(), less);
+            sorted_valid = true;
+        }
+        return sorted;
+    }
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include "import_scheduler.h"
+
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iso646.h>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "bytecode.h"
+#include "lexer.h"
+#include "parser.h"
+#include "pt.h"
+#include "support.h"
+#include "util.h"
+
+namespace {
+
+struct ModuleInfo {
+    ModuleInfo(): source_name(), source_text(), imports(), stale(false), waiting(0), importers() {}
+    std::string source_name;
+    std::string source_text;
+    std::vector<std::string> imports;
+    bool stale;
+    // The number of stale modules imported by this one that have not been
+    // compiled yet.
+    size_t waiting;
+    std::vector<std::string> importers;
+};
+
+// Decide whether a module needs compiling, in the same way as
+// CompilerSupport::loadModule, and find out what it imports. Returns false
+// for a module that this can't say anything useful about.
+bool examine(CompilerSupport *support, const std::string &name, ModuleInfo &info)
+{
+    if (support->findEmbedded(name) != nullptr) {
+        return false;
+    }
+    Bytecode object;
+    std::string source_name;
+    std::string source_text;
+    try {
+        if (support->loadCurrentBytecode(name, object, source_name, source_text)) {
+            for (auto &imp: object.imports) {
+                info.imports.push_back(object.strtable[imp.name]);
+            }
+            return true;
+        }
+    } catch (BytecodeException &) {
+        return false;
+    }
+    try {
+        auto tokens = tokenize(source_name, source_text);
+        auto parsetree = parse(*tokens);
+        for (auto &s: parsetree->body) {
+            const pt::ImportDeclaration *import = dynamic_cast<const pt::ImportDeclaration *>(s.get());
+            if (import != nullptr) {
+                info.imports.push_back(import->module.text);
+            }
+        }
+    } catch (CompilerError *error) {
+        delete error;
+        return false;
+    }
+    // Modules also import these without saying so.
+    info.imports.push_back("global");
+    info.imports.push_back("string");
+    info.source_name = source_name;
+    info.source_text = source_text;
+    info.stale = true;
+    return true;
+}
+
+} // namespace
+
+void compile_stale_imports(CompilerSupport *support, const std::string &program_name, const std::vector<std::string> &names)
+{
+    // With only one processor there is nothing to gain, and finding the
+    // imports first costs an extra parse of every stale module. NEONJOBS
+    // sets the number of threads to use instead.
+    size_t processors = std::thread::hardware_concurrency();
+    const char *jobs = std::getenv("NEONJOBS");
+    if (jobs != nullptr) {
+        processors = std::strtoul(jobs, nullptr, 10);
+    }
+    if (processors <= 1) {
+        return;
+    }
+
+    std::map<std::string, ModuleInfo> modules;
+    modules[program_name] = ModuleInfo();
+    std::vector<std::string> pending = names;
+    while (not pending.empty()) {
+        const std::string name = pending.back();
+        pending.pop_back();
+        if (modules.find(name) != modules.end()) {
+            continue;
+        }
+        ModuleInfo &info = modules[name];
+        if (examine(support, name, info)) {
+            pending.insert(pending.end(), info.imports.begin(), info.imports.end());
+        }
+    }
+
+    std::deque<std::string> ready;
+    for (auto &m: modules) {
+        if (not m.second.stale) {
+            continue;
+        }
+        for (auto &imp: m.second.imports) {
+            auto i = modules.find(imp);
+            if (i != modules.end() && i->second.stale && i->first != m.first) {
+                i->second.importers.push_back(m.first);
+                m.second.waiting++;
+            }
+        }
+        if (m.second.waiting == 0) {
+            ready.push_back(m.first);
+        }
+    }
+    // Modules in an import cycle never become ready.
+    if (ready.empty()) {
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t running = 0;
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            cv.wait(lock, [&]() { return not ready.empty() || running == 0; });
+            if (ready.empty()) {
+                break;
+            }
+            const std::string name = ready.front();
+            ready.pop_front();
+            const ModuleInfo &info = modules[name];
+            running++;
+            lock.unlock();
+            // Each compile gets its own support, so that the modules it
+            // loads are not recorded as loaded by the program.
+            CompilerSupport module_support(*support);
+            bool ok = true;
+            try {
+                module_support.compileModule(info.source_name, info.source_text);
+            } catch (CompilerError *error) {
+                delete error;
+                ok = false;
+            } catch (std::exception &) {
+                ok = false;
+            }
+            lock.lock();
+            running--;
+            if (ok) {
+                for (auto &importer: info.importers) {
+                    if (--modules[importer].waiting == 0) {
+                        ready.push_back(importer);
+                    }
+                }
+            }
+            cv.notify_all();
+        }
+    };
+
+    size_t stale = 0;
+    for (auto &m: modules) {
+        if (m.second.stale) {
+            stale++;
+        }
+    }
+    size_t threads = processors;
+    if (threads > stale) {
+        threads = stale;
+    }
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < threads; i++) {
+        pool.push_back(std::thread(worker));
+    }
+    worker();
+    for (auto &t: pool) {
+        t.join();
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef IMPORT_SCHEDULER_H
+#define IMPORT_SCHEDULER_H
+
+#include <string>
+#include <vector>
+
+class CompilerSupport;
+
+// Brings the bytecode of the named modules, and of every module they import
+// in turn, up to date before a program that imports them is analyzed.
+//
+// The import graph is discovered first: from the IMPORT declarations in the
+// source of each module that needs compiling, and from the import table in
+// the bytecode of each module that doesn't. The stale modules are then
+// compiled on a pool of threads, each one as soon as all the stale modules
+// it imports have been written, so independent modules compile at the same
+// time. There is one thread for each processor, unless the NEONJOBS
+// environment variable gives the number of threads.
+//
+// This only ever does work early. A module that fails to compile here (or
+// that is part of an import cycle) is left alone, and the analyzer reports
+// the problem in context when it imports the module as usual. The module
+// named program_name is the one being compiled, so it is never compiled
+// here even if another module imports it.
+void compile_stale_imports(CompilerSupport *support, const std::string &program_name, const std::vector<std::string> &names);
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "analyzer.h"
 #include "ast.h"
+#include "cache.h"
 #include "cell.h"
 #include "compiler.h"
 #include "debuginfo.h"
@@ -15,6 +16,12 @@
 #include "repl.h"
 #include "support.h"
 
+// USE_RTLX embeds the compiled standard library modules in the executable,
+// so that importing them needs neither the source nor any front end work.
+#ifdef USE_RTLX
+#include "rtlx.inc"
+#endif
+
 bool dump_tokens = false;
 bool dump_parse = false;
 bool dump_ast = false;
@@ -22,6 +29,9 @@ bool dump_listing = false;
 bool enable_assert = true;
 bool enable_debug = false;
 bool enable_trace = false;
+bool enable_profile = false;
+bool enable_cache = true;
+bool enable_threaded_dispatch = true;
 bool error_json = false;
 unsigned short debug_port = 0;
 const char *repl_input = nullptr;
@@ -53,6 +63,17 @@ static const ast::Program *dump(const ast::Program *program)
     return program;
 }
 
+// Load the compiled program from the cache, if it's there and none of the
+// modules it imports have changed.
+static bool load_cached(ModuleCache &cache, CompilerSupport &support, const std::string &name, const std::string &source, std::vector<unsigned char> &bytecode, DebugInfo *debug)
+{
+    std::map<std::string, std::string> imports;
+    if (not cache.enabled() || not cache.load(name, source, enable_debug, bytecode, &imports, debug)) {
+        return false;
+    }
+    return support.importsCurrent(imports);
+}
+
 static void repl(int argc, char *argv[], const ExecOptions &options)
 {
     std::istream *in = &std::cin;
@@ -115,6 +136,10 @@ int main(int argc, char *argv[])
             dump_listing = true;
         } else if (arg == "-n") {
             enable_assert = false;
+        } else if (arg == "--no-cache") {
+            enable_cache = false;
+        } else if (arg == "--no-threaded-dispatch") {
+            enable_threaded_dispatch = false;
         } else if (arg == "--neonpath") {
             a++;
             if (argv[a] == NULL) {
@@ -122,6 +147,8 @@ int main(int argc, char *argv[])
                 exit(1);
             }
             neonpath.push_back(argv[a]);
+        } else if (arg == "--profile") {
+            enable_profile = true;
         } else if (arg == "--repl-input") {
             a++;
             if (argv[a] == NULL) {
@@ -146,6 +173,8 @@ int main(int argc, char *argv[])
     options.enable_assert = enable_assert;
     options.enable_debug = enable_debug;
     options.enable_trace = enable_trace;
+    options.enable_threaded_dispatch = enable_threaded_dispatch;
+    options.enable_profile = enable_profile;
 
     if (a >= argc) {
         repl(argc, argv, options);
@@ -155,8 +184,25 @@ int main(int argc, char *argv[])
     auto i = name.find_last_of("/:\\");
     const std::string source_path { i != std::string::npos ? name.substr(0, i+1) : "" };
 
+    if (enable_profile) {
+        if (has_suffix(name, ".neon") || has_suffix(name, ".neonx")) {
+            options.profile_stacks_path = name.substr(0, name.find_last_of('.')) + ".folded";
+        } else {
+            options.profile_stacks_path = "neon.folded";
+        }
+    }
+
     CompilerSupport compiler_support(source_path, neonpath, nullptr, enable_debug);
     RuntimeSupport runtime_support(source_path, neonpath);
+#ifdef USE_RTLX
+    compiler_support.setEmbeddedModules(rtl_bytecode, sizeof(rtl_bytecode)/sizeof(rtl_bytecode[0]));
+    runtime_support.setEmbeddedModules(rtl_bytecode, sizeof(rtl_bytecode)/sizeof(rtl_bytecode[0]));
+#endif
+    // The cache is only used when the front end has nothing else to do.
+    ModuleCache cache(enable_cache && not (dump_tokens || dump_parse || dump_ast || dump_listing) ? ModuleCache::default_directory() : "");
+    if (cache.enabled()) {
+        compiler_support.setCache(&cache);
+    }
     std::unique_ptr<DebugInfo> debug;
 
     std::vector<unsigned char> bytecode;
@@ -180,26 +226,29 @@ int main(int argc, char *argv[])
         debug.reset(new DebugInfo(name, source.str()));
 
         try {
-            auto tokens = tokenize(name, source.str());
-            if (dump_tokens) {
-                dump(*tokens);
-            }
+            if (not load_cached(cache, compiler_support, name, source.str(), bytecode, debug.get())) {
+                debug.reset(new DebugInfo(name, source.str()));
+                auto tokens = tokenize(name, source.str());
+                if (dump_tokens) {
+                    dump(*tokens);
+                }
 
-            auto parsetree = parse(*tokens);
-            if (dump_parse) {
-                dump(parsetree.get());
-            }
+                auto parsetree = parse(*tokens);
+                if (dump_parse) {
+                    dump(parsetree.get());
+                }
 
-            auto program = analyze(&compiler_support, parsetree.get());
-            if (dump_ast) {
-                dump(program);
-            }
+                auto program = analyze(&compiler_support, parsetree.get());
+                if (dump_ast) {
+                    dump(program);
+                }
 
-            bytecode = compile(program, debug.get());
-            if (dump_listing) {
-                disassemble(bytecode, std::cerr, debug.get());
+                bytecode = compile(program, debug.get());
+                if (dump_listing) {
+                    disassemble(bytecode, std::cerr, debug.get());
+                }
+                cache.store(name, source.str(), enable_debug, bytecode, &compiler_support.loadedModules(), debug.get());
             }
-
         } catch (CompilerError *error) {
             if (error_json) {
                 error->write_json(std::cerr);
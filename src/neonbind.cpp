@@ -6,6 +6,7 @@
 #include <iterator>
 #include <map>
 #include <sstream>
+#include <stdint.h>
 #include <stdio.h>
 #include <string>
 #include <string.h>
@@ -20,6 +21,7 @@
 
 #include <zip.h>
 
+#include "bundle.h"
 #include "bytecode.h"
 #include "support.h"
 
@@ -49,13 +51,92 @@ void get_modules(const Bytecode &obj, std::map<std::string, Bytecode> &modules)
     }
 }
 
+void copy_file(FILE *in, FILE *out)
+{
+    for (;;) {
+        char buf[4096];
+        size_t n = fread(buf, 1, sizeof(buf), in);
+        if (n == 0) {
+            break;
+        }
+        fwrite(buf, 1, n, out);
+    }
+}
+
+void put_uint(FILE *f, uint64_t x, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        fputc(static_cast<int>(x & 0xff), f);
+        x >>= 8;
+    }
+}
+
+void pad_to_alignment(FILE *f, long base)
+{
+    long pos = ftell(f);
+    while ((pos - base) % BUNDLE_ALIGNMENT != 0) {
+        fputc(0, f);
+        pos++;
+    }
+}
+
+// Writes the modules in the indexed bundle format described in bundle.h,
+// after whatever is already in the file. All positions are relative to
+// the start of the bundle.
+void write_indexed(FILE *f, const std::map<std::string, Bytecode> &modules)
+{
+    const long base = ftell(f);
+    std::vector<std::pair<uint64_t, uint64_t>> positions;
+    for (auto &m: modules) {
+        pad_to_alignment(f, base);
+        long pos = ftell(f);
+        fwrite(m.second.obj.data(), 1, m.second.obj.size(), f);
+        positions.push_back(std::make_pair(pos - base, m.second.obj.size()));
+    }
+    long index = ftell(f);
+    auto p = positions.begin();
+    for (auto &m: modules) {
+        put_uint(f, p->first, 8);
+        put_uint(f, p->second, 8);
+        put_uint(f, m.first.length(), 4);
+        fwrite(m.first.data(), 1, m.first.length(), f);
+        ++p;
+    }
+    long index_end = ftell(f);
+    put_uint(f, index - base, 8);
+    put_uint(f, index_end - index, 8);
+    put_uint(f, modules.size(), 4);
+    put_uint(f, BUNDLE_VERSION, 4);
+    fwrite(BUNDLE_SIGNATURE, 1, BUNDLE_SIGNATURE_SIZE, f);
+}
+
+void write_zip(const std::string &zipname, const std::map<std::string, Bytecode> &modules)
+{
+    zipFile zip = zipOpen(zipname.c_str(), 0);
+    if (zip == NULL) {
+        fprintf(stderr, "zip open error\n");
+        exit(1);
+    }
+    for (auto &m: modules) {
+        int r = zipOpenNewFileInZip(zip, (m.first+".neonx").c_str(), NULL, NULL, 0, NULL, 0, NULL, Z_DEFLATED, Z_DEFAULT_COMPRESSION);
+        if (r != ZIP_OK) {
+            fprintf(stderr, "zip open error\n");
+            exit(1);
+        }
+        r = zipWriteInFileInZip(zip, m.second.obj.data(), static_cast<unsigned int>(m.second.obj.size()));
+        zipCloseFileInZip(zip);
+    }
+    zipClose(zip, NULL);
+}
+
 int main(int argc, char *argv[])
 {
     bool executable = false;
+    bool use_zip = false;
     std::string stub_name = std::string("bin/") + DEFAULT_STUB_NAME;
 
     if (argc < 3) {
-        fprintf(stderr, "Usage: %s [-e] bundle module\n", argv[0]);
+        fprintf(stderr, "Usage: %s [-e] [-zip] bundle module\n", argv[0]);
         exit(1);
     }
 
@@ -64,6 +145,8 @@ int main(int argc, char *argv[])
         if (argv[a][0] == '-') {
             if (strcmp(argv[a], "-e") == 0) {
                 executable = true;
+            } else if (strcmp(argv[a], "-zip") == 0) {
+                use_zip = true;
             } else if (strcmp(argv[a], "-stub") == 0) {
                 a++;
                 stub_name = argv[a];
@@ -102,25 +185,37 @@ int main(int argc, char *argv[])
     }
     get_modules(modules[""], modules);
 
-    const std::string zipname = executable ? std::string(bundle) + ".zip" : bundle;
-    {
-        zipFile zip = zipOpen(zipname.c_str(), 0);
-        if (zip == NULL) {
-            fprintf(stderr, "zip open error\n");
+    if (not use_zip) {
+        FILE *out = fopen(bundle, "wb");
+        if (out == NULL) {
+            fprintf(stderr, "bundle open (%s)\n", bundle);
             exit(1);
         }
-        for (auto m: modules) {
-            int r = zipOpenNewFileInZip(zip, (m.first+".neonx").c_str(), NULL, NULL, 0, NULL, 0, NULL, Z_DEFLATED, Z_DEFAULT_COMPRESSION);
-            if (r != ZIP_OK) {
-                fprintf(stderr, "zip open error\n");
+        if (executable) {
+            FILE *stub = fopen(stub_name.c_str(), "rb");
+            if (stub == NULL) {
+                fprintf(stderr, "stub open (%s)\n", stub_name.c_str());
                 exit(1);
             }
-            r = zipWriteInFileInZip(zip, m.second.obj.data(), static_cast<unsigned int>(m.second.obj.size()));
-            zipCloseFileInZip(zip);
+            copy_file(stub, out);
+            fclose(stub);
+            // Start the bundle on a page boundary of the executable too,
+            // so that the modules are page aligned in the file.
+            pad_to_alignment(out, 0);
         }
-        zipClose(zip, NULL);
+        write_indexed(out, modules);
+        #ifndef _WIN32
+            if (executable) {
+                fchmod(fileno(out), 0755);
+            }
+        #endif
+        fclose(out);
+        return 0;
     }
 
+    const std::string zipname = executable ? std::string(bundle) + ".zip" : bundle;
+    write_zip(zipname, modules);
+
     if (executable) {
         FILE *stub = fopen(stub_name.c_str(), "rb");
         if (stub == NULL) {
@@ -137,22 +232,8 @@ int main(int argc, char *argv[])
             fprintf(stderr, "exe open\n");
             exit(1);
         }
-        for (;;) {
-            char buf[4096];
-            size_t n = fread(buf, 1, sizeof(buf), stub);
-            if (n == 0) {
-                break;
-            }
-            fwrite(buf, 1, n, exe);
-        }
-        for (;;) {
-            char buf[4096];
-            size_t n = fread(buf, 1, sizeof(buf), zip);
-            if (n == 0) {
-                break;
-            }
-            fwrite(buf, 1, n, exe);
-        }
+        copy_file(stub, exe);
+        copy_file(zip, exe);
         fclose(stub);
         fclose(zip);
         #ifndef _WIN32
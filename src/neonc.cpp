@@ -175,12 +175,7 @@ int main(int argc, char *argv[])
                     disassemble(bytecode, std::cerr, &debug);
                 }
                 if (name != "-") {
-                    std::ofstream outf(objname, std::ios::binary);
-                    if (not outf) {
-                        std::cerr << "Could not create output file: " << objname << "\n";
-                        exit(1);
-                    }
-                    outf.write(reinterpret_cast<const std::ofstream::char_type *>(bytecode.data()), bytecode.size());
+                    compiler_support.writeOutput(objname, bytecode);
                 }
             } else {
                 target_proc(&compiler_support, ast, output, options);
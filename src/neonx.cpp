@@ -8,9 +8,15 @@
 #include "exec.h"
 #include "support.h"
 
+#ifdef USE_RTLX
+#include "rtlx.inc"
+#endif
+
 bool g_enable_assert = true;
 bool g_enable_debug = false;
 bool g_enable_trace = false;
+bool g_enable_profile = false;
+bool g_enable_threaded_dispatch = true;
 unsigned short g_debug_port = 0;
 
 bool has_suffix(const std::string &str, const std::string &suffix)
@@ -31,6 +37,9 @@ void run_from_neonx(const std::vector<std::string> &neonpath, const std::string
     buf << inf.rdbuf();
 
     RuntimeSupport runtime_support(source_path, neonpath);
+#ifdef USE_RTLX
+    runtime_support.setEmbeddedModules(rtl_bytecode, sizeof(rtl_bytecode)/sizeof(rtl_bytecode[0]));
+#endif
 
     std::vector<unsigned char> bytecode;
     std::string s = buf.str();
@@ -41,6 +50,11 @@ void run_from_neonx(const std::vector<std::string> &neonpath, const std::string
     options.enable_assert = g_enable_assert;
     options.enable_debug = g_enable_debug;
     options.enable_trace = g_enable_trace;
+    options.enable_threaded_dispatch = g_enable_threaded_dispatch;
+    options.enable_profile = g_enable_profile;
+    if (g_enable_profile) {
+        options.profile_stacks_path = name.substr(0, name.size() - 6) + ".folded";
+    }
     exit(exec(name, bytecode, nullptr, &runtime_support, &options, g_debug_port, argc, argv));
 }
 
@@ -62,6 +76,8 @@ int main(int argc, char *argv[])
             g_debug_port = static_cast<unsigned short>(std::stoul(argv[a]));
         } else if (arg == "-n") {
             g_enable_assert = false;
+        } else if (arg == "--no-threaded-dispatch") {
+            g_enable_threaded_dispatch = false;
         } else if (arg == "--neonpath") {
             a++;
             if (argv[a] == NULL) {
@@ -69,6 +85,8 @@ int main(int argc, char *argv[])
                 exit(1);
             }
             neonpath.push_back(argv[a]);
+        } else if (arg == "--profile") {
+            g_enable_profile = true;
         } else if (arg == "-t") {
             g_enable_trace = true;
         } else {
@@ -2,34 +2,101 @@
 
 #include <assert.h>
 #include <iso646.h>
+#include <limits>
+
+namespace {
+
+const int64_t INT64_MAXIMUM = std::numeric_limits<int64_t>::max();
+const int64_t INT64_MINIMUM = std::numeric_limits<int64_t>::min();
+
+// Integers no larger than this in magnitude can be multiplied
+// together without overflowing int64_t.
+const int64_t MULTIPLY_LIMIT = 3037000499LL;
+
+// Integers smaller than this in magnitude are small enough that
+// the decimal128 quotient computed by number_modulo() can never be
+// rounded to an integer when the true quotient is not an integer.
+const int64_t MODULO_LIMIT = 1000000000000000LL;
+
+} // namespace
 
 BID_UINT128 Number::get_bid()
 {
+    if (is_int) {
+        return bid128_from_int64(integer);
+    }
     return bid;
 }
 
 Number number_add(Number x, Number y)
 {
+    if (x.is_int64() && y.is_int64()) {
+        int64_t a = x.get_int64();
+        int64_t b = y.get_int64();
+        if (b >= 0 ? a <= INT64_MAXIMUM - b : a >= INT64_MINIMUM - b) {
+            return Number(a + b);
+        }
+    }
     return bid128_add(x.get_bid(), y.get_bid());
 }
 
 Number number_subtract(Number x, Number y)
 {
+    if (x.is_int64() && y.is_int64()) {
+        int64_t a = x.get_int64();
+        int64_t b = y.get_int64();
+        if (b <= 0 ? a <= INT64_MAXIMUM + b : a >= INT64_MINIMUM + b) {
+            return Number(a - b);
+        }
+    }
     return bid128_sub(x.get_bid(), y.get_bid());
 }
 
 Number number_multiply(Number x, Number y)
 {
+    if (x.is_int64() && y.is_int64()) {
+        int64_t a = x.get_int64();
+        int64_t b = y.get_int64();
+        // A zero result with one negative operand is negative zero.
+        if (a >= -MULTIPLY_LIMIT && a <= MULTIPLY_LIMIT && b >= -MULTIPLY_LIMIT && b <= MULTIPLY_LIMIT
+         && ((a != 0 && b != 0) || (a >= 0 && b >= 0))) {
+            return Number(a * b);
+        }
+    }
     return bid128_mul(x.get_bid(), y.get_bid());
 }
 
 Number number_divide(Number x, Number y)
 {
+    if (x.is_int64() && y.is_int64()) {
+        int64_t a = x.get_int64();
+        int64_t b = y.get_int64();
+        // An exact quotient has the same exponent (0) as the operands.
+        // Zero divided by a negative number is negative zero.
+        if (b != 0 && not (a == INT64_MINIMUM && b == -1) && a % b == 0 && (a != 0 || b > 0)) {
+            return Number(a / b);
+        }
+    }
     return bid128_div(x.get_bid(), y.get_bid());
 }
 
 Number number_modulo(Number x, Number y)
 {
+    if (x.is_int64() && y.is_int64()) {
+        int64_t a = x.get_int64();
+        int64_t b = y.get_int64();
+        if (b != 0 && a > -MODULO_LIMIT && a < MODULO_LIMIT && b > -MODULO_LIMIT && b < MODULO_LIMIT) {
+            int64_t m = b < 0 ? -b : b;
+            int64_t r = a % m;
+            if (r < 0) {
+                r += m;
+            }
+            if (b < 0 && r != 0) {
+                r -= m;
+            }
+            return Number(r);
+        }
+    }
     BID_UINT128 m = bid128_abs(y.get_bid());
     if (bid128_isSigned(x.get_bid())) {
         Number q = number_ceil(bid128_div(bid128_abs(x.get_bid()), m));
@@ -66,16 +133,26 @@ Number number_powmod(Number /*b*/, Number /*e*/, Number /*m*/)
 
 Number number_negate(Number x)
 {
+    // Negating zero gives negative zero, which has no integer form.
+    if (x.is_int64() && x.get_int64() != 0 && x.get_int64() != INT64_MINIMUM) {
+        return Number(-x.get_int64());
+    }
     return bid128_negate(x.get_bid());
 }
 
 Number number_abs(Number x)
 {
+    if (x.is_int64() && x.get_int64() != INT64_MINIMUM) {
+        return Number(x.get_int64() < 0 ? -x.get_int64() : x.get_int64());
+    }
     return bid128_abs(x.get_bid());
 }
 
 Number number_sign(Number x)
 {
+    if (x.is_int64()) {
+        return Number(static_cast<int64_t>(x.get_int64() > 0) - static_cast<int64_t>(x.get_int64() < 0));
+    }
     if (bid128_isZero(x.get_bid())) {
         return bid128_from_uint32(0);
     }
@@ -84,16 +161,25 @@ Number number_sign(Number x)
 
 Number number_ceil(Number x)
 {
+    if (x.is_int64()) {
+        return x;
+    }
     return bid128_round_integral_positive(x.get_bid());
 }
 
 Number number_floor(Number x)
 {
+    if (x.is_int64()) {
+        return x;
+    }
     return bid128_round_integral_negative(x.get_bid());
 }
 
 Number number_trunc(Number x)
 {
+    if (x.is_int64()) {
+        return x;
+    }
     return bid128_round_integral_zero(x.get_bid());
 }
 
@@ -249,62 +335,98 @@ Number number_tgamma(Number x)
 
 bool number_is_zero(Number x)
 {
+    if (x.is_int64()) {
+        return x.get_int64() == 0;
+    }
     return bid128_isZero(x.get_bid()) != 0;
 }
 
 bool number_is_negative(Number x)
 {
+    if (x.is_int64()) {
+        return x.get_int64() < 0;
+    }
     return bid128_isSigned(x.get_bid()) != 0;
 }
 
 bool number_is_equal(Number x, Number y)
 {
+    if (x.is_int64() && y.is_int64()) {
+        return x.get_int64() == y.get_int64();
+    }
     return bid128_quiet_equal(x.get_bid(), y.get_bid()) != 0;
 }
 
 bool number_is_not_equal(Number x, Number y)
 {
+    if (x.is_int64() && y.is_int64()) {
+        return x.get_int64() != y.get_int64();
+    }
     return bid128_quiet_not_equal(x.get_bid(), y.get_bid()) != 0;
 }
 
 bool number_is_less(Number x, Number y)
 {
+    if (x.is_int64() && y.is_int64()) {
+        return x.get_int64() < y.get_int64();
+    }
     return bid128_quiet_less(x.get_bid(), y.get_bid()) != 0;
 }
 
 bool number_is_greater(Number x, Number y)
 {
+    if (x.is_int64() && y.is_int64()) {
+        return x.get_int64() > y.get_int64();
+    }
     return bid128_quiet_greater(x.get_bid(), y.get_bid()) != 0;
 }
 
 bool number_is_less_equal(Number x, Number y)
 {
+    if (x.is_int64() && y.is_int64()) {
+        return x.get_int64() <= y.get_int64();
+    }
     return bid128_quiet_less_equal(x.get_bid(), y.get_bid()) != 0;
 }
 
 bool number_is_greater_equal(Number x, Number y)
 {
+    if (x.is_int64() && y.is_int64()) {
+        return x.get_int64() >= y.get_int64();
+    }
     return bid128_quiet_greater_equal(x.get_bid(), y.get_bid()) != 0;
 }
 
 bool number_is_integer(Number x)
 {
+    if (x.is_int64()) {
+        return true;
+    }
     BID_UINT128 i = bid128_round_integral_zero(x.get_bid());
     return bid128_quiet_equal(x.get_bid(), i) != 0;
 }
 
 bool number_is_odd(Number x)
 {
+    if (x.is_int64()) {
+        return x.get_int64() % 2 != 0;
+    }
     return not bid128_isZero(bid128_fmod(x.get_bid(), bid128_from_uint32(2)));
 }
 
 bool number_is_finite(Number x)
 {
+    if (x.is_int64()) {
+        return true;
+    }
     return bid128_isFinite(x.get_bid());
 }
 
 bool number_is_nan(Number x)
 {
+    if (x.is_int64()) {
+        return false;
+    }
     return bid128_isNaN(x.get_bid()) != 0;
 }
 
@@ -312,6 +434,9 @@ std::string number_to_string(Number x, Format format)
 {
     const int PRECISION = 34;
 
+    if (x.is_int64()) {
+        return std::to_string(x.get_int64());
+    }
     char buf[50];
     bid128_to_string(buf, x.get_bid());
     std::string sbuf(buf);
@@ -355,41 +480,65 @@ std::string number_to_string(Number x, Format format)
 
 uint8_t number_to_uint8(Number x)
 {
+    if (x.is_int64() && x.get_int64() >= 0 && x.get_int64() <= std::numeric_limits<uint8_t>::max()) {
+        return static_cast<uint8_t>(x.get_int64());
+    }
     return bid128_to_uint8_int(x.get_bid());
 }
 
 int8_t number_to_sint8(Number x)
 {
+    if (x.is_int64() && x.get_int64() >= std::numeric_limits<int8_t>::min() && x.get_int64() <= std::numeric_limits<int8_t>::max()) {
+        return static_cast<int8_t>(x.get_int64());
+    }
     return bid128_to_int8_int(x.get_bid());
 }
 
 uint16_t number_to_uint16(Number x)
 {
+    if (x.is_int64() && x.get_int64() >= 0 && x.get_int64() <= std::numeric_limits<uint16_t>::max()) {
+        return static_cast<uint16_t>(x.get_int64());
+    }
     return bid128_to_uint16_int(x.get_bid());
 }
 
 int16_t number_to_sint16(Number x)
 {
+    if (x.is_int64() && x.get_int64() >= std::numeric_limits<int16_t>::min() && x.get_int64() <= std::numeric_limits<int16_t>::max()) {
+        return static_cast<int16_t>(x.get_int64());
+    }
     return bid128_to_int16_int(x.get_bid());
 }
 
 uint32_t number_to_uint32(Number x)
 {
+    if (x.is_int64() && x.get_int64() >= 0 && x.get_int64() <= std::numeric_limits<uint32_t>::max()) {
+        return static_cast<uint32_t>(x.get_int64());
+    }
     return bid128_to_uint32_int(x.get_bid());
 }
 
 int32_t number_to_sint32(Number x)
 {
+    if (x.is_int64() && x.get_int64() >= std::numeric_limits<int32_t>::min() && x.get_int64() <= std::numeric_limits<int32_t>::max()) {
+        return static_cast<int32_t>(x.get_int64());
+    }
     return bid128_to_int32_int(x.get_bid());
 }
 
 uint64_t number_to_uint64(Number x)
 {
+    if (x.is_int64() && x.get_int64() >= 0) {
+        return static_cast<uint64_t>(x.get_int64());
+    }
     return bid128_to_uint64_int(x.get_bid());
 }
 
 int64_t number_to_sint64(Number x)
 {
+    if (x.is_int64()) {
+        return x.get_int64();
+    }
     return bid128_to_int64_int(x.get_bid());
 }
 
@@ -451,47 +600,64 @@ Number number_from_string(const std::string &s)
     if (next != std::string::npos) {
         return bid128_nan(NULL);
     }
+    // Plain integers that fit use the integer form. Negative zero
+    // does not have an integer form.
+    const std::string::size_type sign = (s[0] == '+' || s[0] == '-') ? 1 : 0;
+    if (i == sign && s.length() > sign && s.length() - sign <= 18) {
+        int64_t value = 0;
+        for (std::string::size_type j = i; j < s.length(); j++) {
+            value = value * 10 + (s[j] - '0');
+        }
+        if (s[0] != '-') {
+            return Number(value);
+        } else if (value != 0) {
+            return Number(-value);
+        }
+    }
     return bid128_from_string(const_cast<char *>(s.c_str() + skip));
 }
 
 Number number_from_uint8(uint8_t x)
 {
-    return bid128_from_uint32(x);
+    return Number(static_cast<int64_t>(x));
 }
 
 Number number_from_sint8(int8_t x)
 {
-    return bid128_from_int32(x);
+    return Number(static_cast<int64_t>(x));
 }
 
 Number number_from_uint16(uint16_t x)
 {
-    return bid128_from_uint32(x);
+    return Number(static_cast<int64_t>(x));
 }
 
 Number number_from_sint16(int16_t x)
 {
-    return bid128_from_int32(x);
+    return Number(static_cast<int64_t>(x));
 }
 
 Number number_from_uint32(uint32_t x)
 {
-    return bid128_from_uint32(x);
+    return Number(static_cast<int64_t>(x));
 }
 
 Number number_from_sint32(int32_t x)
 {
-    return bid128_from_int32(x);
+    return Number(static_cast<int64_t>(x));
 }
 
 Number number_from_uint64(uint64_t x)
 {
+    if (x <= static_cast<uint64_t>(INT64_MAXIMUM)) {
+        return Number(static_cast<int64_t>(x));
+    }
     return bid128_from_uint64(x);
 }
 
 Number number_from_sint64(int64_t x)
 {
-    return bid128_from_int64(x);
+    return Number(x);
 }
 
 Number number_from_float(float x)
@@ -31,12 +31,26 @@ enum class Format {
 
 const Format DefaultFormat = Format::full;
 
+// Small integers are very common (loop counters, array indexes), so a
+// Number can also hold an int64_t. This is only used for values that are
+// exactly equal to what bid128_from_int64() would return (that is, an
+// integer with exponent 0 and never negative zero), so get_bid() always
+// gives the same result whichever form the value is held in. Operations
+// that can't be done exactly on the integer form fall back to decimal128.
+
 struct Number {
-    Number(): bid(bid128_from_uint32(0)) {}
-    Number(BID_UINT128 x): bid(x) {}
+    Number(): is_int(true), integer(0) {}
+    Number(BID_UINT128 x): is_int(false), bid(x) {}
+    explicit Number(int64_t x): is_int(true), integer(x) {}
     BID_UINT128 get_bid();
+    bool is_int64() const { return is_int; }
+    int64_t get_int64() const { return integer; }
 private:
-    BID_UINT128 bid;
+    bool is_int;
+    union {
+        int64_t integer;
+        BID_UINT128 bid;
+    };
 };
 
 Number number_add(Number x, Number y);
@@ -3,6 +3,7 @@
 
 #include <map>
 #include <memory>
+#include <utility>
 
 #include "number.h"
 #include "utf8string.h"
@@ -91,6 +92,7 @@ private:
 class ObjectArray: public Object {
 public:
     explicit ObjectArray(const std::vector<std::shared_ptr<Object>> &a): a(a) {}
+    explicit ObjectArray(std::vector<std::shared_ptr<Object>> &&a): a(std::move(a)) {}
     virtual bool getArray(std::vector<std::shared_ptr<Object>> &r) const override { r = a; return true; }
     virtual bool invokeMethod(const utf8string &name, const std::vector<std::shared_ptr<Object>> &args, std::shared_ptr<Object> &result) const override;
     virtual bool subscript(std::shared_ptr<Object> index, std::shared_ptr<Object> &r) const override;
@@ -105,6 +107,7 @@ private:
 class ObjectDictionary: public Object {
 public:
     explicit ObjectDictionary(const std::map<utf8string, std::shared_ptr<Object>> &d): d(d) {}
+    explicit ObjectDictionary(std::map<utf8string, std::shared_ptr<Object>> &&d): d(std::move(d)) {}
     virtual bool getDictionary(std::map<utf8string, std::shared_ptr<Object>> &r) const override { r = d; return true; }
     virtual bool invokeMethod(const utf8string &name, const std::vector<std::shared_ptr<Object>> &args, std::shared_ptr<Object> &result) const override;
     virtual bool subscript(std::shared_ptr<Object> index, std::shared_ptr<Object> &r) const override;
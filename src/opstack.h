@@ -1,6 +1,7 @@
 #ifndef OPSTACK_H
 #define OPSTACK_H
 
+#include <utility>
 #include <vector>
 
 template <typename T> class opstack {
@@ -13,6 +14,7 @@ public:
     typename std::vector<T>::reverse_iterator end() { return a.rend(); }
     T &peek(size_t n) { return a.at(a.size() - 1 - n); }
     void push(const T &x) { a.push_back(x); }
+    void push(T &&x) { a.push_back(std::move(x)); }
     void pop() { a.pop_back(); }
     T &top() { return a.back(); }
 private:
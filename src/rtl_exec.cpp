@@ -1,5 +1,3 @@
-#define __STDC_LIMIT_MACROS // for SIZE_MAX, see https://stackoverflow.com/questions/30472731/which-c-standard-header-defines-size-max
-
 #include "rtl_exec.h"
 
 #include <stdint.h>
@@ -7,8 +5,6 @@
 #include <stdlib.h>
 #include <string>
 
-typedef void (*Thunk)(opstack<Cell> &stack, void *func);
-
 static std::map<std::string, size_t> FunctionNames;
 static std::map<std::string, size_t> VariableNames;
 
@@ -39,18 +35,13 @@ void rtl_exec_init(int argc, char *argv[])
     }
 }
 
-void rtl_call(opstack<Cell> &stack, const std::string &name, size_t &token)
+const RtlFunction *rtl_find_function(const std::string &name)
 {
-    if (token == SIZE_MAX) {
-        auto f = FunctionNames.find(name);
-        if (f == FunctionNames.end()) {
-            fprintf(stderr, "neon: function not found: %s\n", name.c_str());
-            abort();
-        }
-        token = f->second;
+    auto f = FunctionNames.find(name);
+    if (f == FunctionNames.end()) {
+        return nullptr;
     }
-    auto &fn = BuiltinFunctions[token];
-    fn.thunk(stack, fn.func);
+    return &BuiltinFunctions[f->second];
 }
 
 Cell *rtl_variable(const std::string &name)
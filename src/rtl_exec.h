@@ -19,8 +19,22 @@ public:
     PanicException(const utf8string &info): RtlException(ExceptionName{"PANIC", {NULL}}, info) {}
 };
 
+typedef void (*Thunk)(opstack<Cell> &stack, void *func);
+
+struct RtlFunction {
+    const char *name;
+    const char *display_name; // name without the module prefix
+    Thunk thunk;
+    void *func;
+};
+
 void rtl_exec_init(int argc, char *argv[]);
-void rtl_call(opstack<Cell> &stack, const std::string &name, size_t &token);
+const RtlFunction *rtl_find_function(const std::string &name);
+
+inline void rtl_call(opstack<Cell> &stack, const RtlFunction &fn)
+{
+    fn.thunk(stack, fn.func);
+}
 Cell *rtl_variable(const std::string &name);
 
 #endif
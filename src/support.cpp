@@ -43,7 +43,9 @@ std::vector<std::string> split(const std::string &s, char d)
 } // namespace
 
 PathSupport::PathSupport(const std::string &source_path, const std::vector<std::string> &libpath)
-  : paths()
+  : paths(),
+    embedded(nullptr),
+    embedded_count(0)
 {
     if (not source_path.empty()) {
         paths.push_back(source_path);
@@ -66,6 +68,16 @@ PathSupport::PathSupport(const std::string &source_path, const std::vector<std::
     }
 }
 
+const EmbeddedModule *PathSupport::findEmbedded(const std::string &name) const
+{
+    for (size_t i = 0; i < embedded_count; i++) {
+        if (name == embedded[i].name) {
+            return &embedded[i];
+        }
+    }
+    return nullptr;
+}
+
 std::pair<std::string, std::string> PathSupport::findModule(const std::string &name)
 {
     std::string module_name = name;
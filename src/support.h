@@ -7,7 +7,9 @@
 
 class Bytecode;
 class CompilerSupport;
+class ModuleCache;
 namespace ast { class Program; }
+namespace pt { class Program; }
 
 typedef void (*CompileProc)(CompilerSupport *support, const ast::Program *, std::string output, std::map<std::string, std::string> options);
 
@@ -17,25 +19,63 @@ public:
     virtual void loadBytecode(const std::string &module, Bytecode &bytecode) = 0;
     virtual void writeOutput(const std::string &name, const std::vector<unsigned char> &content) = 0;
     virtual bool enableDebug() { return false; }
+    // Called before a program is analyzed, with a chance to bring the
+    // modules it imports up to date all at once.
+    virtual void prepareImports(const std::string & /*module_name*/, const pt::Program * /*program*/) {}
+};
+
+// A compiled module built into the executable. With USE_RTLX, the table
+// of these in gen/rtlx.inc holds the bytecode of the standard library.
+struct EmbeddedModule {
+    const char *name;
+    size_t length;
+    const unsigned char *bytecode;
 };
 
 class PathSupport: public ICompilerSupport {
 public:
     explicit PathSupport(const std::string &source_path, const std::vector<std::string> &libpath);
     std::pair<std::string, std::string> findModule(const std::string &name);
+    // Embedded modules are used in preference to any found on the path.
+    void setEmbeddedModules(const EmbeddedModule *modules, size_t count) { embedded = modules; embedded_count = count; }
+    const EmbeddedModule *findEmbedded(const std::string &name) const;
 private:
     std::vector<std::string> paths;
+    const EmbeddedModule *embedded;
+    size_t embedded_count;
 };
 
 class CompilerSupport: public PathSupport {
 public:
-    CompilerSupport(const std::string &source_path, const std::vector<std::string> &libpath, CompileProc cproc, bool enabledebug): PathSupport(source_path, libpath), cproc(cproc), enabledebug(enabledebug) {}
+    CompilerSupport(const std::string &source_path, const std::vector<std::string> &libpath, CompileProc cproc, bool enabledebug): PathSupport(source_path, libpath), cproc(cproc), enabledebug(enabledebug), cache(nullptr), loaded_modules(), imports_prepared(false) {}
     virtual void loadBytecode(const std::string &name, Bytecode &object) override;
     virtual void writeOutput(const std::string &name, const std::vector<unsigned char> &content) override;
     virtual bool enableDebug() override { return enabledebug; }
+    // Compiles stale imports concurrently (see import_scheduler.h). This
+    // only happens for the first program analyzed with this support; the
+    // modules compiled on its behalf find their imports already current.
+    virtual void prepareImports(const std::string &module_name, const pt::Program *program) override;
+    // Compile a module from its source and write its bytecode next to it.
+    std::vector<unsigned char> compileModule(const std::string &source_name, const std::string &source_text);
+    void setCache(ModuleCache *c) { cache = c; }
+    // The source hash of every module loaded so far, by name.
+    const std::map<std::string, std::string> &loadedModules() const { return loaded_modules; }
+    // Bring the bytecode of each of the given modules up to date, and check
+    // that none of them has a different source hash now.
+    bool importsCurrent(const std::map<std::string, std::string> &imports);
+    // Load the bytecode of a module and return true, unless it has source
+    // that has changed since the bytecode was compiled. Then return false
+    // with the source to compile instead. Both loading a module and the
+    // import scheduler decide whether a module is stale here.
+    bool loadCurrentBytecode(const std::string &name, Bytecode &object, std::string &source_name, std::string &source_text);
 private:
     CompileProc cproc;
     bool enabledebug;
+    ModuleCache *cache;
+    std::map<std::string, std::string> loaded_modules;
+    bool imports_prepared;
+
+    void loadModule(const std::string &name, Bytecode &object);
 };
 
 class RuntimeSupport: public PathSupport {
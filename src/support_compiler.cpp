@@ -11,8 +11,12 @@
 
 #include "analyzer.h"
 #include "ast.h"
+#include "atomic_file.h"
+#include "cache.h"
+#include "import_scheduler.h"
 #include "lexer.h"
 #include "parser.h"
+#include "pt.h"
 #include "compiler.h"
 
 #ifdef _MSC_VER
@@ -20,86 +24,150 @@
 #define mkdir(x,y) _mkdir(x)
 #endif
 
-#ifdef USE_RTLX
-#include "rtl.inc"
-#endif
-
 void CompilerSupport::loadBytecode(const std::string &name, Bytecode &object)
 {
-#ifdef USE_RTLX
-    for (size_t i = 0; i < sizeof(rtl_sources)/sizeof(rtl_sources[0]); i++) {
-        if (name == rtl_sources[i].name) {
-            auto tokens = tokenize(name, rtl_sources[i].source);
-            auto parsetree = parse(*tokens);
-            auto ast = analyze(this, parsetree.get());
-            auto bytecode = compile(ast, nullptr);
-            object.load("-builtin-", bytecode);
-            return;
-        }
+    loadModule(name, object);
+    loaded_modules[name] = object.source_hash;
+}
+
+void CompilerSupport::loadModule(const std::string &name, Bytecode &object)
+{
+    std::string source_name;
+    std::string source_text;
+    if (not loadCurrentBytecode(name, object, source_name, source_text)) {
+        object.load(source_name, BytecodeImage::own(compileModule(source_name, source_text)));
+    }
+}
+
+bool CompilerSupport::loadCurrentBytecode(const std::string &name, Bytecode &object, std::string &source_name, std::string &source_text)
+{
+    const EmbeddedModule *embedded = findEmbedded(name);
+    if (embedded != nullptr) {
+        object.load("-builtin-", BytecodeImage::borrow(embedded->bytecode, embedded->length));
+        return true;
     }
-#endif
 
     std::pair<std::string, std::string> names = findModule(name);
     if (names.first.empty() && names.second.empty()) {
         throw BytecodeException("file not found");
     }
 
-    std::ifstream obj_file(names.second, std::ios::binary);
     std::ifstream src_file(names.first);
 
-    std::string source_text;
+    source_text.clear();
     if (src_file.good()) {
         std::stringstream buf;
         buf << src_file.rdbuf();
         source_text = buf.str();
     }
 
+    std::shared_ptr<const BytecodeImage> image = BytecodeImage::map(names.second);
+
     if (not source_text.empty()) {
-        if (obj_file.good()) {
+        if (image != nullptr) {
             SHA256 sha256;
             sha256(source_text);
             unsigned char h[SHA256::HashBytes];
             sha256.getHash(h);
             std::string hash = std::string(h, h+sizeof(h));
 
-            std::stringstream buf;
-            buf << obj_file.rdbuf();
-            std::vector<unsigned char> bytecode;
-            std::string s = buf.str();
-            std::copy(s.begin(), s.end(), std::back_inserter(bytecode));
-            object.load(name, bytecode);
-
-            if (object.source_hash == hash) {
-                return;
+            // Bytecode that can't be loaded is replaced from the source.
+            try {
+                object.load(name, image);
+                if (object.source_hash == hash) {
+                    return true;
+                }
+            } catch (BytecodeException &) {
             }
             object = Bytecode();
         }
+        source_name = names.first;
+        return false;
+    }
+
+    if (image == nullptr) {
+        image = BytecodeImage::own(std::vector<unsigned char>());
+    }
+    object.load(names.first.empty() ? names.second : names.first, image);
+    return true;
+}
 
-        obj_file.close();
-        const std::string objname = names.first + "x";
-        remove(objname.c_str());
-        {
-            auto tokens = tokenize(names.first, source_text);
-            auto parsetree = parse(*tokens);
-            auto ast = analyze(this, parsetree.get());
-            auto bytecode = compile(ast, nullptr);
-            writeOutput(objname, bytecode);
-            if (cproc != nullptr) {
-                cproc(this, ast, "", {});
+std::vector<unsigned char> CompilerSupport::compileModule(const std::string &source_name, const std::string &source_text)
+{
+    const std::string objname = source_name + "x";
+    std::vector<unsigned char> bytecode;
+    std::map<std::string, std::string> imports;
+    if (cache != nullptr && cache->load(source_name, source_text, enabledebug, bytecode, &imports, nullptr) && importsCurrent(imports)) {
+        writeOutput(objname, bytecode);
+    } else {
+        // The modules loaded while compiling this one are kept apart, for
+        // its cache entry, and added to the ones loaded before however
+        // this returns.
+        struct ModuleImports {
+            explicit ModuleImports(std::map<std::string, std::string> &loaded): loaded(loaded), outer() { std::swap(loaded, outer); }
+            ~ModuleImports() {
+                for (auto &m: loaded) {
+                    outer[m.first] = m.second;
+                }
+                std::swap(loaded, outer);
             }
+            ModuleImports(const ModuleImports &) = delete;
+            ModuleImports &operator=(const ModuleImports &) = delete;
+            std::map<std::string, std::string> &loaded;
+            std::map<std::string, std::string> outer;
+        } module_imports(loaded_modules);
+        auto tokens = tokenize(source_name, source_text);
+        auto parsetree = parse(*tokens);
+        auto ast = analyze(this, parsetree.get());
+        bytecode = compile(ast, nullptr);
+        writeOutput(objname, bytecode);
+        if (cache != nullptr) {
+            cache->store(source_name, source_text, enabledebug, bytecode, &loaded_modules, nullptr);
         }
-        obj_file.open(objname, std::ios::binary);
-        if (not obj_file.good()) {
-            throw BytecodeException("file not found");
+        if (cproc != nullptr) {
+            cproc(this, ast, "", {});
         }
     }
+    return bytecode;
+}
 
-    std::stringstream buf;
-    buf << obj_file.rdbuf();
-    std::vector<unsigned char> bytecode;
-    std::string s = buf.str();
-    std::copy(s.begin(), s.end(), std::back_inserter(bytecode));
-    object.load(names.first.empty() ? names.second : names.first, bytecode);
+void CompilerSupport::prepareImports(const std::string &module_name, const pt::Program *program)
+{
+    // Code generators for other targets are not safe to run on more than
+    // one thread, so their modules are compiled as they are imported.
+    if (imports_prepared || cproc != nullptr) {
+        return;
+    }
+    imports_prepared = true;
+    std::vector<std::string> names {"global", "string"};
+    for (auto &s: program->body) {
+        const pt::ImportDeclaration *import = dynamic_cast<const pt::ImportDeclaration *>(s.get());
+        if (import != nullptr) {
+            names.push_back(import->module.text);
+        }
+    }
+    compile_stale_imports(this, module_name, names);
+}
+
+bool CompilerSupport::importsCurrent(const std::map<std::string, std::string> &imports)
+{
+    for (auto &imp: imports) {
+        const std::string &name = imp.first;
+        // Embedded modules can only change along with the executable.
+        if (findEmbedded(name) != nullptr) {
+            continue;
+        }
+        Bytecode module;
+        try {
+            loadBytecode(name, module);
+        } catch (BytecodeException &) {
+            return false;
+        }
+        if (module.source_hash != imp.second) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void CompilerSupport::writeOutput(const std::string &name, const std::vector<unsigned char> &content)
@@ -117,10 +185,10 @@ void CompilerSupport::writeOutput(const std::string &name, const std::vector<uns
             }
         }
     }
-    std::ofstream f(name, std::ios::binary);
-    if (not f) {
+    // Another compiler reading this module at the same time must never see
+    // a partly written file.
+    if (not write_file_atomically(name, content.data(), content.size())) {
         std::cerr << "error: Could not create output file: " << name << "\n";
         exit(1);
     }
-    f.write(reinterpret_cast<const char *>(content.data()), content.size());
 }
@@ -28,6 +28,7 @@ public:
     const char *c_str() const { return s.c_str(); }
     void clear() { invalidate(); s.clear(); }
     const char *data() const { return s.data(); }
+    char *data_for_write() { invalidate(); return &s[0]; }
     bool empty() const { return s.empty(); }
     std::string::size_type index(std::string::size_type i) const {
         if (indexes.empty()) {
@@ -51,7 +52,7 @@ public:
     }
     void push_back(std::string::value_type ch) { invalidate(); s.push_back(ch); }
     void reserve(std::string::size_type new_cap) { s.reserve(new_cap); }
-    void resize(std::string::size_type count) { s.resize(count); }
+    void resize(std::string::size_type count) { invalidate(); s.resize(count); }
     std::string::size_type size() const { return s.size(); }
     const std::string &str() const { return s; }
     std::string substr(std::string::size_type pos, std::string::size_type count) const { return s.substr(pos, count); }
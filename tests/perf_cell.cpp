@@ -0,0 +1,77 @@
+#include <stdio.h>
+
+#include "cell.h"
+#include "number.h"
+#include "opstack.h"
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+time_t get_second()
+{
+    return GetTickCount() / 1000;
+}
+
+#else
+
+#include <sys/time.h>
+
+time_t get_second()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec;
+}
+
+#endif
+
+// Count how many times the stack can push and pop a copy of the given
+// cell (plus a few more to make it look like an expression evaluation)
+// in one second.
+static long push_pop(const Cell &value)
+{
+    opstack<Cell> stack;
+    Cell local = value;
+
+    time_t start = get_second();
+    time_t now;
+    do {
+        now = get_second();
+    } while (now == start);
+
+    start = now;
+    long count = 0;
+    do {
+        for (int i = 0; i < 1000; i++) {
+            stack.push(local);
+            stack.push(Cell(local));
+            stack.push(stack.top());
+            stack.pop();
+            stack.pop();
+            local = stack.top();
+            stack.pop();
+        }
+        count += 1000;
+        now = get_second();
+    } while (now - start < 1);
+    return count;
+}
+
+int main(int, char *[])
+{
+    printf("sizeof(Cell) %zu\n", sizeof(Cell));
+
+    const size_t N = 1000000;
+    Cell a;
+    std::vector<Cell> &elements = a.array_for_write();
+    for (size_t i = 0; i < N; i++) {
+        elements.push_back(Cell(number_from_uint64(i)));
+    }
+    printf("array element bytes %zu\n", elements.capacity() * sizeof(Cell) / elements.size());
+
+    printf("push/pop number %ld\n", push_pop(Cell(number_from_uint32(12345))));
+    printf("push/pop boolean %ld\n", push_pop(Cell(true)));
+    printf("push/pop string %ld\n", push_pop(Cell(utf8string("hello world"))));
+    printf("push/pop array %ld\n", push_pop(a));
+}
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <stdio.h>
+#include <string>
+
+#include "cell.h"
+#include "number.h"
+
+// Time inserting, looking up, and iterating over a dictionary with
+// a million keys, in both increasing and scattered key order.
+
+static double elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void run(const char *name, size_t (*key)(size_t))
+{
+    const size_t N = 1000000;
+    Cell d;
+    HashDictionary<Cell> &dict = d.dictionary_for_write();
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        dict[utf8string(std::to_string(key(i)))] = Cell(number_from_uint64(i));
+    }
+    printf("%s insert %.3f\n", name, elapsed(start));
+
+    start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for (size_t i = 0; i < N; i++) {
+        if (dict.lookup(utf8string(std::to_string(key(i)))) != nullptr) {
+            found++;
+        }
+    }
+    printf("%s lookup %.3f (%zu)\n", name, elapsed(start), found);
+
+    start = std::chrono::steady_clock::now();
+    size_t count = 0;
+    for (auto &e: dict) {
+        if (not e.first.empty()) {
+            count++;
+        }
+    }
+    printf("%s iterate %.3f (%zu)\n", name, elapsed(start), count);
+}
+
+static size_t increasing(size_t i)
+{
+    return 10000000 + i;
+}
+
+static size_t scattered(size_t i)
+{
+    return (i * 2654435761u) % 1000003;
+}
+
+int main(int, char *[])
+{
+    run("increasing", increasing);
+    run("scattered", scattered);
+}
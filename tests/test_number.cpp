@@ -17,8 +17,90 @@ void do_verify_eq(int line, std::string source, std::string value, std::string e
 
 #define verify_eq(value, expected) do_verify_eq(__LINE__, #value, value, expected)
 
+std::string bid_string(BID_UINT128 x)
+{
+    char buf[50];
+    bid128_to_string(buf, x);
+    return buf;
+}
+
+// Check that an operation on the integer form of Number gives exactly
+// the same decimal128 value (including exponent and sign of zero) as
+// doing the same thing directly with the BID library.
+void verify_same(const char *op, int64_t a, int64_t b, Number value, BID_UINT128 expected)
+{
+    if (bid_string(value.get_bid()) == bid_string(expected)) {
+        return;
+    }
+    fprintf(stderr, "      op: %s\n", op);
+    fprintf(stderr, "       a: %lld\n", static_cast<long long>(a));
+    fprintf(stderr, "       b: %lld\n", static_cast<long long>(b));
+    fprintf(stderr, "   value: %s\n", bid_string(value.get_bid()).c_str());
+    fprintf(stderr, "expected: %s\n", bid_string(expected).c_str());
+    assert(false);
+}
+
+void verify_same(const char *op, int64_t a, int64_t b, bool value, bool expected)
+{
+    if (value == expected) {
+        return;
+    }
+    fprintf(stderr, "      op: %s\n", op);
+    fprintf(stderr, "       a: %lld\n", static_cast<long long>(a));
+    fprintf(stderr, "       b: %lld\n", static_cast<long long>(b));
+    fprintf(stderr, "   value: %d\n", value);
+    fprintf(stderr, "expected: %d\n", expected);
+    assert(false);
+}
+
+void test_integer_form()
+{
+    const int64_t values[] = {
+        0, 1, -1, 2, -2, 3, -3, 7, -7, 10, -10, 1000,
+        3037000499LL, -3037000499LL, 3037000500LL, -3037000500LL,
+        4294967295LL, 4294967296LL, -4294967296LL,
+        999999999999999LL, -999999999999999LL, 1000000000000000LL, -1000000000000000LL,
+        std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::max() - 1,
+        std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::min() + 1,
+    };
+    for (int64_t a: values) {
+        Number x = number_from_sint64(a);
+        BID_UINT128 bx = bid128_from_int64(a);
+        verify_same("from_sint64", a, 0, x, bx);
+        verify_same("from_string", a, 0, number_from_string(std::to_string(a)), bx);
+        verify_same("negate", a, 0, number_negate(x), bid128_negate(bx));
+        verify_same("abs", a, 0, number_abs(x), bid128_abs(bx));
+        verify_same("ceil", a, 0, number_ceil(x), bid128_round_integral_positive(bx));
+        verify_same("floor", a, 0, number_floor(x), bid128_round_integral_negative(bx));
+        verify_same("trunc", a, 0, number_trunc(x), bid128_round_integral_zero(bx));
+        verify_same("is_zero", a, 0, number_is_zero(x), bid128_isZero(bx) != 0);
+        verify_same("is_negative", a, 0, number_is_negative(x), bid128_isSigned(bx) != 0);
+        verify_same("is_odd", a, 0, number_is_odd(x), not bid128_isZero(bid128_fmod(bx, bid128_from_uint32(2))));
+        verify_eq(number_to_string(x), number_to_string(Number(bx)));
+        for (int64_t b: values) {
+            Number y = number_from_sint64(b);
+            BID_UINT128 by = bid128_from_int64(b);
+            verify_same("add", a, b, number_add(x, y), bid128_add(bx, by));
+            verify_same("subtract", a, b, number_subtract(x, y), bid128_sub(bx, by));
+            verify_same("multiply", a, b, number_multiply(x, y), bid128_mul(bx, by));
+            verify_same("divide", a, b, number_divide(x, y), bid128_div(bx, by));
+            verify_same("modulo", a, b, number_modulo(x, y), number_modulo(Number(bx), Number(by)).get_bid());
+            verify_same("equal", a, b, number_is_equal(x, y), bid128_quiet_equal(bx, by) != 0);
+            verify_same("less", a, b, number_is_less(x, y), bid128_quiet_less(bx, by) != 0);
+            verify_same("greater_equal", a, b, number_is_greater_equal(x, y), bid128_quiet_greater_equal(bx, by) != 0);
+        }
+    }
+
+    verify_same("from_string", 0, 0, number_from_string("-0"), bid128_from_string(const_cast<char *>("-0")));
+    verify_same("from_string", 0, 0, number_from_string("000"), bid128_from_string(const_cast<char *>("000")));
+    verify_same("from_string", 5, 0, number_from_string("+5"), bid128_from_string(const_cast<char *>("5")));
+    verify_same("from_uint64", 0, 0, number_from_uint64(std::numeric_limits<uint64_t>::max()), bid128_from_uint64(std::numeric_limits<uint64_t>::max()));
+}
+
 int main()
 {
+    test_integer_form();
+
     verify_eq(number_to_string(number_from_uint64(0)), "0");
     verify_eq(number_to_string(number_from_uint64(1)), "1");
     verify_eq(number_to_string(number_from_uint64(std::numeric_limits<uint32_t>::max())), "4294967295");
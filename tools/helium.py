@@ -3338,6 +3338,15 @@ def neon_runtime_garbageCollect(env):
 def neon_runtime_getAllocatedObjectCount(env):
     return 0
 
+def neon_runtime_getGarbageCollectionCount(env):
+    return 0
+
+def neon_runtime_getGarbageCollectionPauseMaximum(env):
+    return 0
+
+def neon_runtime_getGarbageCollectionPauseTotal(env):
+    return 0
+
 def neon_runtime_isModuleImported(env, name):
     return name in g_Modules
 
@@ -3347,6 +3356,9 @@ def neon_runtime_moduleIsMain(env):
 def neon_runtime_setGarbageCollectionInterval(env, count):
     pass
 
+def neon_runtime_setGarbageCollectionPauseBudget(env, microseconds):
+    pass
+
 def neon_runtime_setRecursionLimit(env, depth):
     pass
 